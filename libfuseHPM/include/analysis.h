@@ -4,12 +4,121 @@
 #include "fuse_types.h"
 
 #include <map>
+#include <random>
 #include <vector>
 
 namespace Fuse {
 
 	namespace Analysis {
 
+		// A distribution binned for TMD calculation
+		// Each populated bin has num_dimensions (flattened) coordinates, and a weight normalised to the distribution's instances
+		struct Tmd_signature {
+			unsigned int num_dimensions;
+			std::vector<double> coords;
+			std::vector<double> weights;
+			unsigned int num_instances;
+		};
+
+		// The populated bins of a distribution at one resolution, with the instance count and per-dimension value sums of each
+		// This is all that is needed to construct the distribution's signature at that resolution
+		struct Tmd_histogram {
+			unsigned int num_bins_per_dimension;
+			std::vector<int32_t> coords; // per bin and dimension, from -1 (external bin below) to num_bins_per_dimension (above)
+			std::vector<uint32_t> counts;
+			std::vector<int64_t> sums; // per bin and dimension
+		};
+
+		// Histograms of one distribution within fixed bounds, at each power-of-two resolution from 1 bin per dimension
+		struct Tmd_histogram_pyramid {
+			unsigned int num_instances;
+			std::vector<std::pair<int64_t, int64_t> > bounds_per_dimension;
+			std::vector<Tmd_histogram> levels; // level l has 2^l bins per dimension
+		};
+
+		Tmd_histogram construct_tmd_histogram(
+			const std::vector<std::vector<int64_t> >& distribution,
+			const std::vector<std::pair<int64_t, int64_t> >& bounds_per_dimension,
+			unsigned int num_bins_per_dimension
+		);
+
+		// Bins keyed by their coordinates, as used when there are too many bins to key them by an integer
+		// Gives exactly the histogram of construct_tmd_histogram, so is also the reference for its integer-keyed binning
+		Tmd_histogram construct_tmd_histogram_by_coordinates(
+			const std::vector<std::vector<int64_t> >& distribution,
+			const std::vector<std::pair<int64_t, int64_t> >& bounds_per_dimension,
+			unsigned int num_bins_per_dimension
+		);
+
+		// Computes the bin coordinate of each value in one dimension's column, given the values' offsets from the lower bound
+		typedef void (*Bin_coords_kernel)(const int64_t*, const double*, size_t, double, int64_t, int, int32_t*);
+
+		// The kernels this CPU supports, from the scalar kernel to the widest SIMD kernel (which is the one used for binning)
+		std::vector<Bin_coords_kernel> get_supported_bin_coords_kernels();
+
+		// The bounds must be those that the histogram was binned within
+		Tmd_signature construct_tmd_signature_from_histogram(
+			const Tmd_histogram& histogram,
+			const std::vector<std::pair<int64_t, int64_t> >& bounds_per_dimension
+		);
+
+		Tmd_signature construct_tmd_signature(
+			const std::vector<std::vector<int64_t> >& distribution,
+			const std::vector<std::pair<int64_t, int64_t> >& bounds_per_dimension,
+			unsigned int num_bins_per_dimension
+		);
+
+		Tmd_histogram_pyramid construct_tmd_histogram_pyramid(
+			const std::vector<std::vector<int64_t> >& distribution,
+			const std::vector<std::pair<int64_t, int64_t> >& bounds_per_dimension,
+			unsigned int max_level
+		);
+
+		// Returns nullptr if the pyramid was binned within different bounds, or does not have the requested resolution
+		const Tmd_histogram* find_pyramid_histogram(
+			const Tmd_histogram_pyramid& pyramid,
+			const std::vector<std::pair<int64_t, int64_t> >& bounds_per_dimension,
+			unsigned int num_bins_per_dimension
+		);
+
+		/* A bootstrap replicate of the signature, as if its distribution's instances were resampled with replacement
+		*  The resampled instance counts are a multinomial draw over the bins, and each bin keeps its coordinates
+		*  So a bin's coordinates remain the mean of its original instances, rather than of its resampled instances
+		*/
+		Tmd_signature resample_tmd_signature(
+			const Tmd_signature& signature,
+			std::mt19937_64& random_engine
+		);
+
+		double calculate_tmd_between_signatures(
+			const Tmd_signature& signature_one,
+			const Tmd_signature& signature_two,
+			Fuse::Tmd_solver solver
+		);
+
+		// A lower bound on the TMD between the signatures, valid for every solver, that is much cheaper than solving for the TMD
+		double calculate_tmd_lower_bound_between_signatures(
+			const Tmd_signature& signature_one,
+			const Tmd_signature& signature_two
+		);
+
+		// One dimension of the distribution's values, normalised to the range of the reference bounds and sorted
+		std::vector<double> construct_sorted_marginal(
+			const std::vector<std::vector<int64_t> >& distribution,
+			unsigned int dimension,
+			std::pair<int64_t, int64_t> bounds
+		);
+
+		// Ranks of the values from 1, where tied values each take the average of the ranks they span
+		std::vector<double> calculate_ranks(
+			const std::vector<int64_t>& values
+		);
+
+		// Spearman's rank correlation between the two dimensions of the distribution (0 if either is constant)
+		double calculate_spearmans_rank_correlation(
+			const std::vector<std::vector<int64_t> >& distribution
+		);
+
 		double calculate_uncalibrated_tmd(
 			std::vector<std::vector<int64_t> > distribution_one,
 			std::vector<std::vector<int64_t> > distribution_two,
@@ -24,10 +133,73 @@ namespace Fuse {
 			std::map<unsigned int, double> pairwise_mi_values
 		);
 
+		// Each event's values are split into this many equal-width bins between their minimum and maximum
+		const int num_mutual_information_bins = 1000;
+
+		// The mutual information bin of each instance's value in the given dimension
+		std::vector<int32_t> bin_values_for_mutual_information(
+			const std::vector<std::vector<int64_t> >& distribution,
+			unsigned int dimension
+		);
+
+		// Normalised by the geometric mean of the two entropies, so it lies in [0,1]
+		double calculate_normalised_mutual_information_of_bins(
+			const std::vector<int32_t>& bins_one,
+			const std::vector<int32_t>& bins_two
+		);
+
 		double calculate_normalised_mutual_information(
 			std::vector<std::vector<int64_t> > distribution
 		);
 				
+		// The profile's signature for one symbol, binned within the reference bounds of the pair's events
+		Tmd_signature construct_profile_signature_for_symbol(
+			Fuse::Target& target,
+			Fuse::Symbol symbol,
+			Fuse::Event_set reference_pair,
+			Fuse::Profile_p profile,
+			unsigned int bin_count
+		);
+
+		// Median, across the reference repeats, of the signature's TMD to the reference for one symbol
+		double calculate_uncalibrated_tmd_for_signature(
+			Fuse::Target& target,
+			Fuse::Symbol symbol,
+			Fuse::Event_set reference_pair,
+			const Tmd_signature& signature,
+			std::vector<unsigned int> reference_repeats_list,
+			unsigned int bin_count,
+			Fuse::Tmd_solver solver
+		);
+
+		// As above but with lower bounds in place of the TMDs, so calibrating the result bounds the calibrated TMD
+		double calculate_uncalibrated_tmd_lower_bound_for_signature(
+			Fuse::Target& target,
+			Fuse::Symbol symbol,
+			Fuse::Event_set reference_pair,
+			const Tmd_signature& signature,
+			std::vector<unsigned int> reference_repeats_list,
+			unsigned int bin_count
+		);
+
+		// Median, across the reference repeats, of the profile's TMD to the reference for one symbol
+		double calculate_uncalibrated_tmd_for_symbol(
+			Fuse::Target& target,
+			Fuse::Symbol symbol,
+			Fuse::Event_set reference_pair,
+			Fuse::Profile_p profile,
+			std::vector<unsigned int> reference_repeats_list,
+			unsigned int bin_count,
+			Fuse::Tmd_solver solver
+		);
+
+		double calibrate_tmds_for_pair(
+			Fuse::Target& target,
+			Fuse::Event_set reference_pair,
+			std::map<Fuse::Symbol, double> uncalibrated_tmd_per_symbol,
+			bool weighted_tmd
+		);
+
 		double calculate_calibrated_tmd_for_pair(
 			Fuse::Target& target,
 			std::vector<Fuse::Symbol> symbols,
@@ -35,7 +207,8 @@ namespace Fuse {
 			Fuse::Profile_p profile,
 			std::vector<unsigned int> reference_repeats_list,
 			unsigned int bin_count,
-			bool weighted_tmd
+			bool weighted_tmd,
+			Fuse::Tmd_solver solver
 		);
 
 	}
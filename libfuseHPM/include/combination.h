@@ -25,34 +25,49 @@ namespace Fuse {
 		std::vector<Fuse::Instance_p> generate_combined_instances_from_unordered_profiles(
 			std::vector<Fuse::Profile_p> sequence_profiles,
 			Fuse::Strategy strategy,
-			bool per_symbol
+			bool per_symbol,
+			Fuse::Combination_residuals* residuals = nullptr
 		);
 
 		std::vector<Fuse::Instance_p> combine_instances_via_strategy(
 			std::vector<std::vector<Fuse::Instance_p> >& instances_per_profile,
 			Fuse::Strategy strategy,
 			Fuse::Statistics_p statistics = nullptr,
-			Fuse::Event_set overlapping_events = Fuse::Event_set()
+			Fuse::Event_set overlapping_events = Fuse::Event_set(),
+			Fuse::Combination_residuals* residuals = nullptr
 		);
 
 		Fuse::Instance_p combine_instances(
 			std::vector<Fuse::Instance_p> instances_to_combine
 		);
 
+		/* Residuals */
+
+		// Adds the linking event differences of a match, where a granularity of 0 means it is unknown
+		void add_match_residuals(
+			const std::vector<Fuse::Instance_p>& match,
+			unsigned int granularity,
+			Fuse::Combination_residuals& residuals
+		);
+
+		void accumulate_residuals(
+			Fuse::Combination_residuals& residuals,
+			const Fuse::Combination_residuals& additional_residuals
+		);
+
+		// Mean relative difference over all linking event values of all matches (lower is better)
+		double summarise_residuals(
+			const Fuse::Combination_residuals& residuals
+		);
+
 		/* Strategy specific */
 
 		std::vector<Fuse::Instance_p> generate_combined_instances_bc(
 			std::vector<Fuse::Profile_p> sequence_profiles,
 			Fuse::Strategy strategy,
 			Fuse::Statistics_p statistics,
-			std::vector<Fuse::Event_set> overlapping_per_profile
-		);
-
-		std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > bc_allocate_to_clusters(
-			std::vector<Fuse::Instance_p> instances,
-			Fuse::Event_set overlapping_events,
-			std::vector<std::pair<int64_t,int64_t> > bounds,
-			unsigned int granularity
+			std::vector<Fuse::Event_set> overlapping_per_profile,
+			Fuse::Combination_residuals* residuals = nullptr
 		);
 
 		unsigned int bc_find_maximum_granularity(
@@ -62,14 +77,9 @@ namespace Fuse {
 			std::vector<std::pair<int64_t,int64_t> > bounds
 		);
 
-		unsigned int relax_similarity_constraint(
+		unsigned int bc_relax_granularity(
 			unsigned int current_granularity,
-			std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > clustered_instances_a,
-			std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > clustered_instances_b,
-			std::vector<Fuse::Instance_p> already_combined_a,
-			std::vector<Fuse::Instance_p> already_combined_b,
-			Fuse::Event_set overlapping_events,
-			std::vector<std::pair<int64_t,int64_t> > event_bounds
+			double minimum_bin_distance
 		);
 
 		std::vector<std::vector<Fuse::Instance_p> > extract_matched_instances_random(
@@ -91,6 +101,14 @@ namespace Fuse {
 		);
 
 		std::vector<std::vector<Fuse::Instance_p> > extract_matched_instances_bc(
+			std::vector<std::vector<Fuse::Instance_p> >& instances_per_profile,
+			bool remove_combined_instances,
+			Fuse::Statistics_p statistics,
+			Fuse::Event_set overlapping_events,
+			std::vector<unsigned int>* match_granularities = nullptr
+		);
+
+		std::vector<std::vector<Fuse::Instance_p> > extract_matched_instances_auction(
 			std::vector<std::vector<Fuse::Instance_p> >& instances_per_profile,
 			bool remove_combined_instances,
 			Fuse::Statistics_p statistics,
@@ -1,6 +1,8 @@
 #ifndef FUSE_CONFIG_H
 #define FUSE_CONFIG_H
 
+#include "fuse_types.h"
+
 namespace Fuse {
 
 	namespace Config {
@@ -14,6 +16,25 @@ namespace Fuse {
 		extern unsigned int tmd_bin_count;
 		extern bool calculate_per_workfunction_tmds;
 		extern bool weighted_tmd;
+		extern Fuse::Tmd_solver tmd_solver;
+		extern Fuse::Tmd_solver sequence_generator_tmd_solver;
+		extern bool sequence_generator_tmd_bounds;
+		extern double sinkhorn_epsilon;
+		extern double sinkhorn_tolerance;
+		extern unsigned int sinkhorn_max_iterations;
+		extern bool bc_tree_combination;
+		extern unsigned int combination_memory_budget_mb;
+		extern bool persist_reference_signatures;
+		extern bool adaptive_calibration;
+		extern double calibration_tolerance;
+		extern unsigned int calibration_min_combinations;
+		extern bool build_reference_pyramids;
+		extern bool cache_accuracy_results;
+		extern unsigned int epd_bootstrap_replicates;
+		extern double epd_bootstrap_confidence;
+		extern unsigned int reference_pyramid_max_level;
+		extern unsigned int auction_num_candidates;
+		extern double auction_epsilon;
 
 	}
 
@@ -27,11 +27,15 @@ namespace Fuse {
 		unsigned int number_of_executions
 	);
 
+	/* If streaming strategies are given, each part is combined into the repeat's running combination as soon as it is loaded
+	*  Then keep_in_memory applies to the combined profiles, and the consumed sequence profiles are released
+	*/
 	void execute_sequence_repeats(
 		Fuse::Target& target,
 		unsigned int number_of_executions,
 		bool minimal,
-		bool keep_in_memory = true
+		bool keep_in_memory = true,
+		std::vector<Fuse::Strategy> streaming_strategies = std::vector<Fuse::Strategy>()
 	);
 
 	void execute_hem_repeats(
@@ -48,6 +52,14 @@ namespace Fuse {
 		bool keep_in_memory = true
 	);
 
+	// Times the combination of each repeat via each strategy, without registering the combined profiles
+	void benchmark_combination_strategies(
+		Fuse::Target& target,
+		std::vector<Fuse::Strategy> strategies,
+		std::vector<unsigned int> repeat_indexes,
+		bool minimal
+	);
+
 	void analyse_sequence_combinations(
 		Fuse::Target& target,
 		std::vector<Fuse::Strategy> strategies,
@@ -55,9 +67,28 @@ namespace Fuse {
 		Fuse::Accuracy_metric metric
 	);
 
+	// Analyses every metric in a single pass over the combined profiles, writing the results of each metric separately
+	void analyse_sequence_combinations(
+		Fuse::Target& target,
+		std::vector<Fuse::Strategy> strategies,
+		std::vector<unsigned int> repeat_indexes,
+		std::vector<Fuse::Accuracy_metric> metrics
+	);
+
 	void calculate_calibration_tmds(
 		Fuse::Target& target
 	);
+
+	// Builds the histogram pyramids of every reference pair and repeat within the current statistics bounds, unless already built within them
+	void build_reference_pyramids(
+		Fuse::Target& target
+	);
+
+	// Compares a TMD solver to the exact transport solver, over the TMDs between each combination of reference repeats
+	void evaluate_tmd_solver_error(
+		Fuse::Target& target,
+		Fuse::Tmd_solver solver
+	);
 	
 	void generate_bc_sequence(
 		Fuse::Target& target
@@ -2,6 +2,7 @@
 #define FUSE_TYPES_H
 
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -29,13 +30,21 @@ namespace Fuse {
 		LGL,
 		LGL_MINIMAL,
 		BC,
-		HEM
+		HEM,
+		AUCTION
+	};
+
+	enum Tmd_solver {
+		FAST_EMD,
+		TRANSPORT_SIMPLEX,
+		SINKHORN
 	};
 
 	enum Accuracy_metric {
 		EPD,
 		EPD_TT,
-		SPEARMANS
+		SPEARMANS,
+		MARGINAL_W1
 	};
 
 	typedef std::string Event;
@@ -48,6 +57,47 @@ namespace Fuse {
 	typedef std::vector<Sequence_part> Combination_sequence;
 	typedef std::string Symbol;
 
+	// Differences in a linking event between the instances that a combination matched together
+	// Relative differences are |a-b|/max(|a|,|b|), and granularities are only known for BC matches
+	struct Linking_residual {
+		unsigned long num_matches;
+		double sum_absolute_difference;
+		double sum_relative_difference;
+		double max_absolute_difference;
+		unsigned long num_granularity_matches;
+		double sum_granularity;
+		unsigned int min_granularity;
+	};
+	typedef std::map<Symbol, std::map<Event, Linking_residual> > Combination_residuals;
+
+	// Summary of a symbol's TMDs between each combination of reference repeats, for one reference pair
+	struct Calibration_tmd {
+		Symbol symbol;
+		Event_set events;
+		unsigned int reference_idx;
+		double min;
+		double max;
+		double mean;
+		double std;
+		double median;
+		double mean_num_instances; // to be used as a 'weight' for the symbol
+		unsigned int num_combinations; // fewer than all combinations if calibrated adaptively
+		double median_relative_confidence; // half-width of the median's 95% confidence interval, relative to the median
+	};
+
+	// A symbol's TMD between one combination of reference repeats, from which its Calibration_tmd is aggregated
+	struct Calibration_combination_tmd {
+		Symbol symbol;
+		unsigned int reference_idx;
+		unsigned int repeat_one;
+		unsigned int repeat_two;
+		std::vector<std::pair<int64_t, int64_t> > bounds_per_event; // the TMD is only valid for these statistics bounds
+		unsigned int bin_count; // and for this bin count and solver
+		Tmd_solver solver;
+		double tmd;
+		double num_instances;
+	};
+
 	typedef std::shared_ptr<Fuse::Execution_profile> Profile_p;
 	typedef std::shared_ptr<Fuse::Instance> Instance_p;
 	typedef std::shared_ptr<Fuse::Statistics> Statistics_p;
@@ -61,6 +111,9 @@ namespace Fuse {
 	Accuracy_metric convert_string_to_metric(std::string metric_string);
 	std::string convert_metric_to_string(Fuse::Accuracy_metric metric);
 
+	Tmd_solver convert_string_to_tmd_solver(std::string solver_string);
+	std::string convert_tmd_solver_to_string(Fuse::Tmd_solver solver);
+
 	std::string convert_runtime_to_string(Fuse::Runtime runtime);
 	Fuse::Runtime convert_string_to_runtime(std::string runtime_str);
 
@@ -35,6 +35,9 @@ namespace Fuse {
 	};
 
 	bool comp_instances_by_label_dfs(Fuse::Instance_p a, Fuse::Instance_p b);
+
+	// Hash encoding of a label, for joining instances across profiles (equal labels have equal encodings)
+	uint64_t encode_label(const std::vector<int>& label);
 }
 
 #endif
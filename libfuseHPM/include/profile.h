@@ -21,6 +21,9 @@ namespace Fuse {
 			Fuse::Event_set events;
 			Fuse::Event_set filtered_events; // If this is populated, then only these counter-events will be loaded
 
+			// If this is a combined profile, the residuals of the linking events between its matched instances
+			Fuse::Combination_residuals combination_residuals;
+
 			// If loaded, each instance maps to [instances that it depends on, instances that depend on it]
 			std::map<
 					Fuse::Instance_p,
@@ -55,6 +58,9 @@ namespace Fuse {
 				const std::vector<Fuse::Symbol> symbols = std::vector<Fuse::Symbol>()
 			);
 
+			// Counts the instances without copying them, as per get_instances
+			size_t get_num_instances(bool include_runtime);
+
 			std::map<std::string, std::vector<std::vector<int64_t> > > get_value_distribution(
 				Fuse::Event_set events,
 				bool include_runtime,
@@ -64,6 +70,9 @@ namespace Fuse {
 			void add_instance(Fuse::Instance_p instance);
 			void add_event(Fuse::Event event);
 
+			void set_combination_residuals(Fuse::Combination_residuals residuals);
+			Fuse::Combination_residuals get_combination_residuals();
+
 	};
 
 }
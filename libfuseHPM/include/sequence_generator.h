@@ -72,7 +72,20 @@ namespace Fuse {
 			std::vector<std::pair<double, Node_p> >& nodes_by_tmd_mse,
 			std::vector<std::pair<double, Node_p> >& nodes_by_cross_profile_tmd_mse,
 			std::vector<std::pair<Fuse::Event_set, std::string> >& profiled_event_sets,
-			std::vector<std::pair<std::string, std::string> >& recorded_combinations
+			std::vector<std::pair<std::string, std::string> >& recorded_combinations,
+			const std::vector<std::pair<Fuse::Event_set, double> >& previously_evaluated_nodes,
+			double best_complete_tmd_mse
+		);
+
+		/* The TMD MSE at or above which a newly combined node would be discarded anyway, because a node with the same events
+		*  has already been evaluated or queued with that accuracy (or for a complete node, the best complete node is as accurate)
+		*/
+		double get_tmd_mse_pruning_threshold(
+			Node_p node,
+			bool complete,
+			const std::vector<std::pair<double, Node_p> >& nodes_by_tmd_mse,
+			const std::vector<std::pair<Fuse::Event_set, double> >& previously_evaluated_nodes,
+			double best_complete_tmd_mse
 		);
 
 		void prune_priority_list(
@@ -110,6 +123,7 @@ namespace Fuse {
 			bool loaded;
 			bool combined;
 			bool evaluated;
+			bool pruned; // its TMD lower bounds showed it could not reach the pruning threshold, so it was not evaluated
 
 			double epd;
 			double tmd_mse;
@@ -142,13 +156,18 @@ namespace Fuse {
 				Node_p parent_node,
 				Fuse::Target& target,
 				std::vector<std::pair<std::string, std::string> >& recorded_combinations,
-				std::vector<Fuse::Event_set> reference_pairs
+				std::vector<Fuse::Event_set> reference_pairs,
+				double tmd_mse_pruning_threshold
 			);
 
+			/* If the threshold is finite (and bounds are enabled), lower bounds on the new TMDs are computed first
+			*  The node is then only evaluated exactly if its bounded TMD MSE is below the threshold, and otherwise marked as pruned
+			*/
 			void analyse_accuracy_and_compute_metrics(
 				Fuse::Target& target,
 				Fuse::Event_set previously_combined_events,
-				std::vector<Fuse::Event_set> reference_pairs
+				std::vector<Fuse::Event_set> reference_pairs,
+				double tmd_mse_pruning_threshold
 			);
 
 			std::string get_combination_spec_as_string();
@@ -163,6 +182,10 @@ namespace Fuse {
 				std::vector<Fuse::Event_set> reference_pairs
 			);
 
+			double calculate_tmd_mse(
+				const std::map<unsigned int, double>& tmds_per_reference_index
+			);
+
 
 		};
 
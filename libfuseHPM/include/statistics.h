@@ -71,10 +71,21 @@ namespace Fuse {
 
 			std::vector<Fuse::Symbol> get_unique_symbols(bool include_runtime);
 
+			// Copies the current statistics of the events (for all symbols), which are not affected by later values
+			Fuse::Statistics_p snapshot_events(
+				Fuse::Event_set events
+			);
+
 			void load();
 			void save();
 
 		private:
+			bool find_stats(
+				Fuse::Event event,
+				Fuse::Symbol symbol,
+				Fuse::Stats& stats
+			);
+
 			void save_stats_for_symbol(
 				Fuse::Event event,
 				Fuse::Symbol symbol,
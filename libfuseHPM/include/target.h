@@ -6,10 +6,29 @@
 #include "nlohmann/json_fwd.hpp"
 
 #include <map>
+#include <memory>
+#include <set>
 #include <string>
+#include <tuple>
 
 namespace Fuse {
 
+	namespace Analysis {
+		struct Tmd_signature;
+		struct Tmd_histogram_pyramid;
+	}
+
+	// A reference signature is identified by (reference pair index, repeat index, symbol, bounds per event, bin count)
+	typedef std::tuple<unsigned int, unsigned int, Fuse::Symbol, std::vector<std::pair<int64_t, int64_t> >, unsigned int>
+		Reference_signature_key;
+
+	// A cached accuracy result is identified by (strategy, combination repeat index, reference pair index, symbol)
+	// The TMD-based metrics calculate identical TMDs, so share the same cached results
+	typedef std::tuple<Fuse::Strategy, unsigned int, unsigned int, Fuse::Symbol> Accuracy_cache_key;
+
+	// Each result is stored with a fingerprint of everything it was calculated from, and is only reused if that is unchanged
+	typedef std::pair<uint64_t, double> Accuracy_cache_entry;
+
 	class Target {
 
 		private:
@@ -63,6 +82,15 @@ namespace Fuse {
 			std::map<unsigned int, std::map<unsigned int, Fuse::Profile_p> > loaded_minimal_sequence_profiles;
 			std::map<unsigned int, std::map<unsigned int, Fuse::Profile_p> > loaded_non_minimal_sequence_profiles;
 			
+			// Binned reference distributions, built once and shared by calibration and accuracy analysis
+			std::map<Fuse::Reference_signature_key, std::shared_ptr<const Fuse::Analysis::Tmd_signature> > reference_signatures;
+			std::set<std::pair<unsigned int, unsigned int> > reference_signature_files_loaded; // (pair index, repeat index)
+
+			// Histogram pyramids of the reference distributions, from which signatures can be built without the raw values
+			std::map<std::pair<unsigned int, unsigned int>,
+					std::map<Fuse::Symbol, std::shared_ptr<const Fuse::Analysis::Tmd_histogram_pyramid> >
+				> reference_pyramids; // keyed by (pair index, repeat index), loaded on first use
+
 			// Map from reference set index to the mutual information between them
 			std::map<unsigned int, double> loaded_pairwise_mis;
 			bool pairwise_mi_loaded; // Indicates if an attempt has already been made to load the pairwise MIs
@@ -93,6 +121,12 @@ namespace Fuse {
 				bool minimal
 			);
 
+			// Drops the target's references to a repeat's loaded sequence profiles, so that their memory can be reclaimed
+			void release_sequence_profiles(
+				unsigned int repeat_index,
+				bool minimal
+			);
+
 			/* These will be ordered by their part index */
 			std::vector<Fuse::Profile_p> load_and_retrieve_sequence_profiles(
 				unsigned int repeat_idx,
@@ -120,6 +154,37 @@ namespace Fuse {
 				std::string filename
 			);
 
+			void save_combination_benchmark_to_disk(
+				Fuse::Strategy strategy,
+				unsigned int repeat_idx,
+				unsigned long num_instances,
+				double seconds,
+				double mean_relative_residual
+			);
+
+			void save_tmd_solver_error_to_disk(
+				Fuse::Tmd_solver solver,
+				unsigned long num_tmds,
+				double mean_absolute_error,
+				double max_absolute_error,
+				double mean_relative_error,
+				double max_relative_error,
+				double exact_seconds,
+				double solver_seconds
+			);
+
+			// Empty if the combination was made without residuals being recorded
+			Fuse::Combination_residuals load_combination_residuals_from_disk(
+				Fuse::Strategy strategy,
+				unsigned int repeat_idx
+			);
+
+			void save_combination_residuals_to_disk(
+				Fuse::Strategy strategy,
+				unsigned int repeat_idx,
+				const Fuse::Combination_residuals& residuals
+			);
+
 			std::map<unsigned int, double> get_or_load_pairwise_mis(
 				std::vector<Fuse::Event_set> reference_pairs
 			);
@@ -152,18 +217,17 @@ namespace Fuse {
 				std::map<Fuse::Symbol, std::vector<std::vector<int64_t> > > values_per_symbol
 			);
 
-			void save_reference_calibration_tmd_to_disk(
-				Fuse::Symbol symbol,
-				Fuse::Event_set events,
-				unsigned int reference_idx,
-				double min,
-				double max,
-				double mean,
-				double median,
-				double std,
-				double mean_num_instances
+			void save_reference_calibration_tmds_to_disk(
+				std::vector<Fuse::Calibration_tmd> calibrations
 			);
 
+			std::vector<Fuse::Calibration_combination_tmd> load_calibration_combination_tmds_from_disk();
+
+			void save_calibration_combination_tmds_to_disk(
+				const std::vector<Fuse::Calibration_combination_tmd>& combination_tmds
+			);
+
+			// For the per-event marginal metric, the map is keyed by target event index rather than reference pair index
 			void save_accuracy_results_to_disk(
 				Fuse::Accuracy_metric metric,
 				Fuse::Strategy strategy,
@@ -172,6 +236,23 @@ namespace Fuse {
 				const std::map<unsigned int, double> tmd_per_reference_pair
 			);
 
+			void save_accuracy_confidence_interval_to_disk(
+				Fuse::Accuracy_metric metric,
+				Fuse::Strategy strategy,
+				unsigned int repeat_idx,
+				double epd,
+				unsigned int num_replicates,
+				double confidence,
+				std::pair<double, double> confidence_interval
+			);
+
+			// Later records of the same key replace earlier ones
+			std::map<Fuse::Accuracy_cache_key, Fuse::Accuracy_cache_entry> load_accuracy_cache_from_disk();
+
+			void save_accuracy_cache_entries_to_disk(
+				const std::vector<std::pair<Fuse::Accuracy_cache_key, Fuse::Accuracy_cache_entry> >& entries
+			);
+
 			std::pair<double, double> get_or_load_calibration_tmd(
 				Fuse::Event_set events,
 				Fuse::Symbol symbol
@@ -189,6 +270,28 @@ namespace Fuse {
 				std::vector<Fuse::Symbol>& symbols
 			);
 
+			// Replaces any existing pyramids of the reference pair and repeat
+			void save_reference_pyramids_to_disk(
+				unsigned int pair_idx,
+				unsigned int repeat_idx,
+				const std::map<Fuse::Symbol, Fuse::Analysis::Tmd_histogram_pyramid>& pyramids_per_symbol
+			);
+
+			// The pyramids of the reference pair and repeat per symbol, empty if none have been built
+			std::map<Fuse::Symbol, std::shared_ptr<const Fuse::Analysis::Tmd_histogram_pyramid> > get_or_load_reference_pyramids(
+				unsigned int pair_idx,
+				unsigned int repeat_idx
+			);
+
+			// The symbol 'all_symbols' gives the signature of the joint distribution of all symbols
+			std::shared_ptr<const Fuse::Analysis::Tmd_signature> get_or_build_reference_signature(
+				Fuse::Event_set reference_pair,
+				unsigned int repeat_idx,
+				Fuse::Symbol symbol,
+				std::vector<std::pair<int64_t, int64_t> > bounds_per_event,
+				unsigned int bin_count
+			);
+
 			void compress_references_tracefiles(
 				std::vector<std::string> reference_tracefiles,
 				unsigned int repeat_idx
@@ -209,8 +312,16 @@ namespace Fuse {
 			std::string get_references_directory();
 			std::string get_results_directory();
 			std::string get_results_filename(Fuse::Accuracy_metric metric);
+			std::string get_confidence_intervals_filename(Fuse::Accuracy_metric metric);
+			std::string get_combination_benchmark_filename();
+			std::string get_tmd_solver_error_filename();
+			std::string get_accuracy_cache_filename();
+			std::string get_reference_signatures_filename_for(unsigned int pair_idx, unsigned int repeat_idx);
+			std::string get_reference_pyramids_filename_for(unsigned int pair_idx, unsigned int repeat_idx);
 			std::string get_combination_filename(Fuse::Strategy strategy, unsigned int repeat_idx);
+			std::string get_combination_residuals_filename(Fuse::Strategy strategy, unsigned int repeat_idx);
 			std::string get_calibration_tmds_filename();
+			std::string get_calibration_combination_tmds_filename();
 			std::string get_sequence_generation_tracefiles_directory();
 			std::string get_sequence_generation_combined_profiles_directory();
 			std::string get_sequence_generation_pairwise_mi_filename();
@@ -229,6 +340,23 @@ namespace Fuse {
 				unsigned int repeat_idx
 			);
 
+			std::map<Fuse::Reference_signature_key, std::shared_ptr<const Fuse::Analysis::Tmd_signature> >
+				load_reference_signatures_from_disk(
+				unsigned int pair_idx,
+				unsigned int repeat_idx
+			);
+
+			std::map<Fuse::Symbol, std::shared_ptr<const Fuse::Analysis::Tmd_histogram_pyramid> >
+				load_reference_pyramids_from_disk(
+				unsigned int pair_idx,
+				unsigned int repeat_idx
+			);
+
+			void save_reference_signature_to_disk(
+				const Fuse::Reference_signature_key& key,
+				const Fuse::Analysis::Tmd_signature& signature
+			);
+
 			void parse_json_mandatory(nlohmann::json& j);
 			void parse_json_optional(nlohmann::json& j);
 			void generate_json_mandatory(nlohmann::json& j);
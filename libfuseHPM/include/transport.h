@@ -0,0 +1,74 @@
+#ifndef FUSE_TRANSPORT_H
+#define FUSE_TRANSPORT_H
+
+#include <vector>
+
+namespace Fuse {
+
+	namespace Transport {
+
+		/* Exact earth mover's distance between two discrete distributions with a Euclidean ground distance
+		*  Coordinates are row-major (num_points x num_dimensions), and the weights of each distribution should sum to 1
+		*  Any small difference in total mass (e.g. from rounding) is left untransported without penalty, as in fast_emd
+		*  Returns a negative value if the solver did not converge, in which case the caller should use fast_emd instead
+		*/
+		double calculate_emd(
+			unsigned int num_dimensions,
+			const std::vector<double>& coords_one,
+			const std::vector<double>& weights_one,
+			const std::vector<double>& coords_two,
+			const std::vector<double>& weights_two
+		);
+
+		/* Approximate earth mover's distance, as the transport cost of the entropically regularised plan found by log-domain Sinkhorn
+		*  The regularisation is epsilon times the maximum ground distance, and iteration stops once the plan's marginals are
+		*  within tolerance (L1) of the weights, or after max_iterations
+		*  The result approximates the exact distance, approaching it as epsilon and tolerance decrease
+		*  It is not a bound either way: the plan only meets the weights to within tolerance, so its cost can fall below the exact distance
+		*/
+		double calculate_sinkhorn_emd(
+			unsigned int num_dimensions,
+			const std::vector<double>& coords_one,
+			const std::vector<double>& weights_one,
+			const std::vector<double>& coords_two,
+			const std::vector<double>& weights_two,
+			double epsilon,
+			double tolerance,
+			unsigned int max_iterations
+		);
+
+		/* Lower bound on the exact earth mover's distance, from the 1-D distances between the marginals of each dimension
+		*  Costs a sort per dimension rather than a transport solve, so it can be used to rule out distributions cheaply
+		*  Both distributions are normalised to unit mass, so the bound holds up to any rounding in the weights
+		*/
+		double calculate_emd_lower_bound(
+			unsigned int num_dimensions,
+			const std::vector<double>& coords_one,
+			const std::vector<double>& weights_one,
+			const std::vector<double>& coords_two,
+			const std::vector<double>& weights_two
+		);
+
+		/* Euclidean ground distance between every point of the first distribution and every point of the second
+		*  Coordinates are row-major as above, and the costs are written row-major (num_points_one x num_points_two)
+		*/
+		void calculate_ground_distances(
+			unsigned int num_dimensions,
+			const std::vector<double>& coords_one,
+			const std::vector<double>& coords_two,
+			std::vector<double>& costs
+		);
+
+		/* Exact earth mover's distance between two 1-D empirical distributions, each given as its sorted sample values
+		*  Every sample has equal weight within its distribution, and the distance is the area between the two step CDFs
+		*/
+		double calculate_sorted_1d_emd(
+			const std::vector<double>& sorted_values_one,
+			const std::vector<double>& sorted_values_two
+		);
+
+	}
+
+}
+
+#endif
@@ -3,6 +3,7 @@
 #include "profile.h"
 #include "statistics.h"
 #include "target.h"
+#include "transport.h"
 #include "util.h"
 
 /* Assertions within the EMD implementation cause it to fail when two distributions are equivalent
@@ -14,29 +15,22 @@
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wsign-compare" // Lots in this third party code
 #include "fast_emd/emd_hat.hpp"
-#include "fast_emd/emd_hat_signatures_interface.hpp"
 #pragma GCC diagnostic pop
 #undef NDEBUG
 #include "spdlog/spdlog.h"
 
-extern "C" {
-#include "MIToolbox/MutualInformation.h"
-#include "MIToolbox/Entropy.h"
-}
-
+#include <algorithm>
 #include <map>
+#include <memory>
+#include <numeric>
 #include <cmath>
+#include <limits>
+#include <unordered_map>
 #include <vector>
 
-double distance_calculation(feature_tt* one, feature_tt* two){
-
-	double square_distance = 0.0;
-
-	for(decltype(one->coords.size()) i=0; i < one->coords.size(); i++)
-		square_distance += std::pow(std::fabs(two->coords.at(i) - one->coords.at(i)),2);
-
-	return std::sqrt(square_distance);
-}
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
 
 struct Bin {
 	unsigned int num_instances;
@@ -112,96 +106,714 @@ std::map<std::vector<double>, Bin> allocate_instances_to_bins(
 
 }
 
-signature_tt<double> convert_distribution_to_bounded_signature(
-		std::vector<std::vector<int64_t> > distribution,
-		std::vector<std::pair<int64_t,int64_t> > bounds_per_dimension,
-		unsigned int num_bins_per_dimension
+/* Kernels computing the bin coordinate of each value in a column, for one dimension
+* Coordinates range from -1 (the external bin below the bounds) to num_bins_per_dimension (the external bin above)
+* The offsets are the values relative to the lower bound, converted to double, so that the division matches the map allocation exactly
+*/
+void compute_bin_coords_scalar(
+		const int64_t* values,
+		const double* offsets,
+		size_t num_values,
+		double bin_size,
+		int64_t max_value,
+		int num_bins_per_dimension,
+		int32_t* coords
 		){
 
-	// Instances are binned within the provided bounds
-	// Any outside the reference ranges are placed into one of two external bins (below min bin, above max bin)
+	for(size_t value_idx = 0; value_idx < num_values; value_idx++){
+
+		int coord = static_cast<int>(offsets[value_idx] / bin_size);
+
+		if(values[value_idx] == max_value)
+			coord--;
+
+		if(coord < 0)
+			coord = -1;
+		else if(coord > num_bins_per_dimension)
+			coord = num_bins_per_dimension;
+
+		coords[value_idx] = coord;
+
+	}
+
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+__attribute__((target("avx2")))
+void compute_bin_coords_avx2(
+		const int64_t* values,
+		const double* offsets,
+		size_t num_values,
+		double bin_size,
+		int64_t max_value,
+		int num_bins_per_dimension,
+		int32_t* coords
+		){
+
+	const __m256d bin_size_v = _mm256_set1_pd(bin_size);
+	const __m256i max_value_v = _mm256_set1_epi64x(max_value);
+	const __m256i even_lanes = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+	const __m128i lower_v = _mm_set1_epi32(-1);
+	const __m128i upper_v = _mm_set1_epi32(num_bins_per_dimension);
+
+	size_t value_idx = 0;
+	for(; value_idx + 4 <= num_values; value_idx += 4){
+
+		// Truncating conversion, as per static_cast<int>
+		__m128i coord = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_loadu_pd(offsets + value_idx), bin_size_v));
+
+		// Equal lanes are all ones (i.e. -1), so adding them decrements the coordinate of maximum values
+		__m256i is_max = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + value_idx)), max_value_v);
+		coord = _mm_add_epi32(coord, _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(is_max, even_lanes)));
+
+		coord = _mm_min_epi32(_mm_max_epi32(coord, lower_v), upper_v);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(coords + value_idx), coord);
+
+	}
+
+	compute_bin_coords_scalar(values + value_idx, offsets + value_idx, num_values - value_idx,
+		bin_size, max_value, num_bins_per_dimension, coords + value_idx);
+
+}
+
+__attribute__((target("avx512f")))
+void compute_bin_coords_avx512(
+		const int64_t* values,
+		const double* offsets,
+		size_t num_values,
+		double bin_size,
+		int64_t max_value,
+		int num_bins_per_dimension,
+		int32_t* coords
+		){
+
+	const __m512d bin_size_v = _mm512_set1_pd(bin_size);
+	const __m512i max_value_v = _mm512_set1_epi64(max_value);
+	const __m512i all_ones = _mm512_set1_epi64(-1);
+	const __m256i lower_v = _mm256_set1_epi32(-1);
+	const __m256i upper_v = _mm256_set1_epi32(num_bins_per_dimension);
+
+	size_t value_idx = 0;
+	for(; value_idx + 8 <= num_values; value_idx += 8){
+
+		__m256i coord = _mm512_cvttpd_epi32(_mm512_div_pd(_mm512_loadu_pd(offsets + value_idx), bin_size_v));
+
+		__mmask8 is_max = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(values + value_idx), max_value_v);
+		coord = _mm256_add_epi32(coord, _mm512_cvtepi64_epi32(_mm512_maskz_mov_epi64(is_max, all_ones)));
+
+		coord = _mm256_min_epi32(_mm256_max_epi32(coord, lower_v), upper_v);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(coords + value_idx), coord);
+
+	}
+
+	compute_bin_coords_scalar(values + value_idx, offsets + value_idx, num_values - value_idx,
+		bin_size, max_value, num_bins_per_dimension, coords + value_idx);
+
+}
+#endif
+
+std::vector<Fuse::Analysis::Bin_coords_kernel> Fuse::Analysis::get_supported_bin_coords_kernels(){
+
+	std::vector<Fuse::Analysis::Bin_coords_kernel> kernels = {compute_bin_coords_scalar};
+
+	#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		kernels.push_back(compute_bin_coords_avx2);
+	if(__builtin_cpu_supports("avx512f"))
+		kernels.push_back(compute_bin_coords_avx512);
+	#endif
+
+	return kernels;
+
+}
 
-	// The coordinate of any bin (including external) corresponds to the mean event values of its instances
-	// Weights are the bin's instance-count normalised to the total instances in the distribution
+std::vector<double> get_bin_size_per_dimension(
+		const std::vector<std::pair<int64_t,int64_t> >& bounds_per_dimension,
+		unsigned int num_bins_per_dimension
+		){
 
 	std::vector<double> bin_size_per_dimension;
 	bin_size_per_dimension.reserve(bounds_per_dimension.size());
 	for(auto bound : bounds_per_dimension)
 		bin_size_per_dimension.push_back((static_cast<double>(bound.second) - static_cast<double>(bound.first)) / num_bins_per_dimension);
 
-	unsigned int total_num_instances = distribution.size();
+	return bin_size_per_dimension;
 
-	std::map<std::vector<double>, Bin> populated_bins = allocate_instances_to_bins(
-		distribution,
-		bounds_per_dimension,
-		num_bins_per_dimension,
-		bin_size_per_dimension
-	);
+}
+
+/* Adds the populated bins of the histogram to the signature, for a compile-time number of dimensions D
+* A D of 0 takes the number of dimensions at runtime, as the generic fallback
+* The coordinate of any bin (including external) corresponds to the mean event values of its instances
+* Weights are the bin's instance-count normalised to the total instances in the distribution
+*/
+template<unsigned int D>
+void append_bins_to_signature(
+		Fuse::Analysis::Tmd_signature& signature,
+		const Fuse::Analysis::Tmd_histogram& histogram,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds_per_dimension,
+		const std::vector<double>& bin_size_per_dimension
+		){
+
+	const unsigned int num_dimensions = (D > 0) ? D : bounds_per_dimension.size();
+	size_t num_bins = histogram.counts.size();
+
+	signature.coords.resize(num_bins * num_dimensions);
+	signature.weights.resize(num_bins);
+
+	for(size_t bin_idx = 0; bin_idx < num_bins; bin_idx++){
+
+		unsigned int num_instances = histogram.counts[bin_idx];
+		if(num_instances < 1)
+			throw std::logic_error("When calculating TMD: found a bin containing no instances.");
+
+		for(unsigned int dim_idx = 0; dim_idx < num_dimensions; dim_idx++){
+
+			size_t coord_idx = bin_idx*num_dimensions + dim_idx;
+
+			// If the dimension is constant, all instances are in the same bin, and the coordinate doesn't need to be changed
+			if(bin_size_per_dimension[dim_idx] == 0.0){
+				signature.coords[coord_idx] = static_cast<double>(histogram.coords[coord_idx]);
+				continue;
+			}
+
+			double mean_value = static_cast<double>(histogram.sums[coord_idx]) / num_instances;
+
+			// For the external bottom bin, this is the (negative) bin distance below the minimum, which is defined as 0.0
+			// Otherwise, it is the fractional bin distance above 0.0
+			double value_displacement = mean_value - bounds_per_dimension[dim_idx].first;
+			signature.coords[coord_idx] = value_displacement / bin_size_per_dimension[dim_idx];
+
+		}
+
+		signature.weights[bin_idx] = static_cast<double>(num_instances) / signature.num_instances;
+
+	}
+
+}
+
+/* Bins the instances by an integer key per bin, for a compile-time number of dimensions D
+* A D of 0 takes the number of dimensions at runtime, as the generic fallback
+* With a fixed D, the per-instance loops over the dimensions are unrolled and the strides are constants
+*/
+template<unsigned int D>
+void bin_instances_by_key(
+		const std::vector<std::vector<int64_t> >& distribution,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds_per_dimension,
+		unsigned int num_bins_per_dimension,
+		const std::vector<double>& bin_size_per_dimension,
+		uint64_t num_cells,
+		Fuse::Analysis::Tmd_histogram& histogram
+		){
+
+	const unsigned int num_dimensions = (D > 0) ? D : bounds_per_dimension.size();
+	size_t num_instances = distribution.size();
+	uint64_t radix = static_cast<uint64_t>(num_bins_per_dimension) + 2;
+
+	// Transpose the instance values into contiguous columns per dimension
+	std::vector<int64_t> values(num_dimensions * num_instances);
+	std::vector<double> offsets(num_dimensions * num_instances);
+	for(size_t instance_idx = 0; instance_idx < num_instances; instance_idx++){
+
+		const auto& instance_values = distribution[instance_idx];
+		if(instance_values.size() < num_dimensions)
+			throw std::out_of_range(fmt::format("When calculating TMD: an instance has {} values, but {} dimensions are binned.",
+				instance_values.size(), num_dimensions));
+
+		for(unsigned int dim_idx = 0; dim_idx < num_dimensions; dim_idx++){
+			auto value = instance_values[dim_idx];
+			values[dim_idx*num_instances + instance_idx] = value;
+			offsets[dim_idx*num_instances + instance_idx] = static_cast<double>(value - bounds_per_dimension[dim_idx].first);
+		}
+
+	}
+
+	static const Fuse::Analysis::Bin_coords_kernel compute_bin_coords = Fuse::Analysis::get_supported_bin_coords_kernels().back();
+
+	std::vector<int32_t> coords(num_instances);
+	std::vector<uint64_t> keys(num_instances, 0);
+
+	for(unsigned int dim_idx = 0; dim_idx < num_dimensions; dim_idx++){
+
+		// If bin size is zero, then the values are constant, so allocate all to same bin in this dimension
+		if(bin_size_per_dimension[dim_idx] == 0.0)
+			std::fill(coords.begin(), coords.end(), 0);
+		else
+			compute_bin_coords(
+				&values[dim_idx*num_instances],
+				&offsets[dim_idx*num_instances],
+				num_instances,
+				bin_size_per_dimension[dim_idx],
+				bounds_per_dimension[dim_idx].second,
+				static_cast<int>(num_bins_per_dimension),
+				coords.data()
+			);
+
+		for(size_t instance_idx = 0; instance_idx < num_instances; instance_idx++)
+			keys[instance_idx] = keys[instance_idx] * radix + static_cast<uint64_t>(coords[instance_idx] + 1);
+
+	}
 
-	if(populated_bins.size() == 0)
+	// Small grids (e.g. 12x12 for the default two dimensions and 10 bins) are accumulated in a dense array,
+	// otherwise only the populated cells are kept in a hash grid
+	std::vector<uint64_t> populated_keys;
+	std::vector<unsigned int> cell_counts;
+	std::vector<int64_t> cell_sums;
+	std::vector<unsigned int> cell_per_populated;
+
+	if(num_cells <= std::max<uint64_t>(4096, 4 * static_cast<uint64_t>(num_instances))){
+
+		cell_counts.assign(num_cells, 0);
+		cell_sums.assign(num_cells * num_dimensions, 0);
+
+		for(size_t instance_idx = 0; instance_idx < num_instances; instance_idx++){
+			auto cell_idx = keys[instance_idx];
+			cell_counts[cell_idx]++;
+			for(unsigned int dim_idx = 0; dim_idx < num_dimensions; dim_idx++)
+				cell_sums[cell_idx*num_dimensions + dim_idx] += values[dim_idx*num_instances + instance_idx];
+		}
+
+		for(uint64_t cell_idx = 0; cell_idx < num_cells; cell_idx++){
+			if(cell_counts[cell_idx] > 0){
+				populated_keys.push_back(cell_idx);
+				cell_per_populated.push_back(cell_idx);
+			}
+		}
+
+	} else {
+
+		std::unordered_map<uint64_t, unsigned int> cell_per_key;
+
+		for(size_t instance_idx = 0; instance_idx < num_instances; instance_idx++){
+
+			auto insertion = cell_per_key.insert(std::make_pair(keys[instance_idx], static_cast<unsigned int>(cell_counts.size())));
+			if(insertion.second){
+				cell_counts.push_back(0);
+				cell_sums.resize(cell_sums.size() + num_dimensions, 0);
+			}
+
+			auto cell_idx = insertion.first->second;
+			cell_counts[cell_idx]++;
+			for(unsigned int dim_idx = 0; dim_idx < num_dimensions; dim_idx++)
+				cell_sums[cell_idx*num_dimensions + dim_idx] += values[dim_idx*num_instances + instance_idx];
+
+		}
+
+		populated_keys.reserve(cell_per_key.size());
+		for(auto cell_iter : cell_per_key)
+			populated_keys.push_back(cell_iter.first);
+		std::sort(populated_keys.begin(), populated_keys.end());
+
+		for(auto key : populated_keys)
+			cell_per_populated.push_back(cell_per_key[key]);
+
+	}
+
+	histogram.coords.resize(populated_keys.size() * num_dimensions);
+	histogram.counts.reserve(populated_keys.size());
+	histogram.sums.reserve(populated_keys.size() * num_dimensions);
+
+	for(decltype(populated_keys.size()) populated_idx = 0; populated_idx < populated_keys.size(); populated_idx++){
+
+		auto key = populated_keys[populated_idx];
+		for(unsigned int dim_idx = num_dimensions; dim_idx-- > 0; ){
+			histogram.coords[populated_idx*num_dimensions + dim_idx] = static_cast<int32_t>(key % radix) - 1;
+			key /= radix;
+		}
+
+		auto cell_idx = cell_per_populated[populated_idx];
+		histogram.counts.push_back(cell_counts[cell_idx]);
+		histogram.sums.insert(histogram.sums.end(),
+			cell_sums.begin() + static_cast<size_t>(cell_idx)*num_dimensions,
+			cell_sums.begin() + static_cast<size_t>(cell_idx + 1)*num_dimensions);
+
+	}
+
+}
+
+Fuse::Analysis::Tmd_histogram Fuse::Analysis::construct_tmd_histogram(
+		const std::vector<std::vector<int64_t> >& distribution,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds_per_dimension,
+		unsigned int num_bins_per_dimension
+		){
+
+	// Instances are binned within the provided bounds
+	// Any outside the reference ranges are placed into one of two external bins (below min bin, above max bin)
+
+	unsigned int num_dimensions = bounds_per_dimension.size();
+
+	std::vector<double> bin_size_per_dimension = get_bin_size_per_dimension(bounds_per_dimension, num_bins_per_dimension);
+
+	Fuse::Analysis::Tmd_histogram histogram;
+	histogram.num_bins_per_dimension = num_bins_per_dimension;
+
+	// Each bin is keyed by its coordinates in mixed radix, with the first dimension most significant
+	// So ascending keys are the lexicographic order of the bins' coordinates
+	uint64_t radix = static_cast<uint64_t>(num_bins_per_dimension) + 2;
+	uint64_t num_cells = 1;
+	bool keys_fit = true;
+	for(unsigned int dim_idx = 0; dim_idx < num_dimensions; dim_idx++){
+		if(num_cells > std::numeric_limits<uint64_t>::max() / radix)
+			keys_fit = false;
+		else
+			num_cells *= radix;
+	}
+
+	// Too many dimensions to key the bins by an integer, so fall back to keying by their coordinates
+	if(keys_fit == false)
+		return Fuse::Analysis::construct_tmd_histogram_by_coordinates(distribution, bounds_per_dimension, num_bins_per_dimension);
+
+	// Specialised binning for the common numbers of dimensions (EPD uses pairs), otherwise the generic binning
+	switch(num_dimensions){
+		case 1: bin_instances_by_key<1>(distribution, bounds_per_dimension, num_bins_per_dimension, bin_size_per_dimension, num_cells, histogram); break;
+		case 2: bin_instances_by_key<2>(distribution, bounds_per_dimension, num_bins_per_dimension, bin_size_per_dimension, num_cells, histogram); break;
+		case 3: bin_instances_by_key<3>(distribution, bounds_per_dimension, num_bins_per_dimension, bin_size_per_dimension, num_cells, histogram); break;
+		default: bin_instances_by_key<0>(distribution, bounds_per_dimension, num_bins_per_dimension, bin_size_per_dimension, num_cells, histogram);
+	}
+
+	return histogram;
+
+}
+
+Fuse::Analysis::Tmd_histogram Fuse::Analysis::construct_tmd_histogram_by_coordinates(
+		const std::vector<std::vector<int64_t> >& distribution,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds_per_dimension,
+		unsigned int num_bins_per_dimension
+		){
+
+	unsigned int num_dimensions = bounds_per_dimension.size();
+
+	std::vector<double> bin_size_per_dimension = get_bin_size_per_dimension(bounds_per_dimension, num_bins_per_dimension);
+
+	Fuse::Analysis::Tmd_histogram histogram;
+	histogram.num_bins_per_dimension = num_bins_per_dimension;
+
+	// The map is ordered by the bins' coordinates, which is the same order as the integer keys
+	auto populated_bins = allocate_instances_to_bins(distribution, bounds_per_dimension, num_bins_per_dimension, bin_size_per_dimension);
+
+	for(auto bin_iter : populated_bins){
+		for(unsigned int dim_idx = 0; dim_idx < num_dimensions; dim_idx++)
+			histogram.coords.push_back(static_cast<int32_t>(bin_iter.first.at(dim_idx)));
+
+		histogram.counts.push_back(bin_iter.second.num_instances);
+		histogram.sums.insert(histogram.sums.end(),
+			bin_iter.second.per_dimension_summed_values.begin(), bin_iter.second.per_dimension_summed_values.end());
+	}
+
+	return histogram;
+
+}
+
+Fuse::Analysis::Tmd_signature Fuse::Analysis::construct_tmd_signature_from_histogram(
+		const Fuse::Analysis::Tmd_histogram& histogram,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds_per_dimension
+		){
+
+	unsigned int num_dimensions = bounds_per_dimension.size();
+	size_t num_bins = histogram.counts.size();
+
+	std::vector<double> bin_size_per_dimension = get_bin_size_per_dimension(bounds_per_dimension, histogram.num_bins_per_dimension);
+
+	Fuse::Analysis::Tmd_signature signature;
+	signature.num_dimensions = num_dimensions;
+	signature.num_instances = std::accumulate(histogram.counts.begin(), histogram.counts.end(), 0u);
+
+	if(num_bins == 0)
 		throw std::runtime_error(
 			fmt::format("Cannot analyse a distribution with 0 populated bins. {}.",
 				fmt::format("The distribution contained {} instances, with {} dimensions divided into {} bins per dimension.",
-					distribution.size(),
-					bounds_per_dimension.size(),
-					num_bins_per_dimension
+					signature.num_instances,
+					num_dimensions,
+					histogram.num_bins_per_dimension
 				)
 			)
 		);
 
-	// The signature contains an array of Features (i.e. coordinates) and an array of Weights
-	// Each coord and each weight is associated by position in the array
-	signature_tt<double> signature;
-	signature.n = populated_bins.size();
-	signature.Features = new feature_tt[signature.n];
-	signature.Weights = new double[signature.n];
+	switch(num_dimensions){
+		case 1: append_bins_to_signature<1>(signature, histogram, bounds_per_dimension, bin_size_per_dimension); break;
+		case 2: append_bins_to_signature<2>(signature, histogram, bounds_per_dimension, bin_size_per_dimension); break;
+		case 3: append_bins_to_signature<3>(signature, histogram, bounds_per_dimension, bin_size_per_dimension); break;
+		default: append_bins_to_signature<0>(signature, histogram, bounds_per_dimension, bin_size_per_dimension);
+	}
 
-	// Convert each bin into the signature format for fast_emd
-	unsigned int bin_idx = 0;
-	for(auto bin_iter : populated_bins){
+	return signature;
 
-		if(bin_iter.second.num_instances < 1)
-			throw std::logic_error("When calculating TMD: found a bin containing no instances.");
+}
 
-		std::vector<double> coords = bin_iter.first;
-		double weight = static_cast<double>(bin_iter.second.num_instances) / total_num_instances;
+Fuse::Analysis::Tmd_signature Fuse::Analysis::construct_tmd_signature(
+		const std::vector<std::vector<int64_t> >& distribution,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds_per_dimension,
+		unsigned int num_bins_per_dimension
+		){
 
-		// Convert each integer coordinate into a float coordinate, corresponding to the mean of the bin's values
-		for(decltype(bounds_per_dimension.size()) dim_idx=0; dim_idx<bounds_per_dimension.size(); dim_idx++){
+	return Fuse::Analysis::construct_tmd_signature_from_histogram(
+		Fuse::Analysis::construct_tmd_histogram(distribution, bounds_per_dimension, num_bins_per_dimension),
+		bounds_per_dimension
+	);
 
-			// Continue if dimension is constant (meaning all same bin, and the coords don't need to be changed)
-			if(bin_size_per_dimension.at(dim_idx) == 0.0)
-				continue;
+}
 
-			double mean_value = static_cast<double>(bin_iter.second.per_dimension_summed_values.at(dim_idx)) / bin_iter.second.num_instances;
+Fuse::Analysis::Tmd_histogram_pyramid Fuse::Analysis::construct_tmd_histogram_pyramid(
+		const std::vector<std::vector<int64_t> >& distribution,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds_per_dimension,
+		unsigned int max_level
+		){
 
-			// If the value is external bottom, then calculate bin distance below 0.0
-			// Otherwise, calculate the fractional bin distance above 0.0
+	Fuse::Analysis::Tmd_histogram_pyramid pyramid;
+	pyramid.num_instances = distribution.size();
+	pyramid.bounds_per_dimension = bounds_per_dimension;
 
-			if(coords.at(dim_idx) < 0.0){
+	/* Each level is binned directly from the instances rather than merged from the level above
+	*  Merging would be cheaper, but the floating point bin boundaries may not nest exactly, and each level must
+	*  give exactly the signature that binning the raw instances would give
+	*/
+	pyramid.levels.reserve(max_level + 1);
+	for(unsigned int level = 0; level <= max_level; level++)
+		pyramid.levels.push_back(Fuse::Analysis::construct_tmd_histogram(distribution, bounds_per_dimension, 1u << level));
 
-				// How much lower that (min) is mean_value, in floating units of bin_size
-				double value_displacement = mean_value - bounds_per_dimension.at(dim_idx).first; // negative under (min)
-				double bin_displacement = value_displacement / bin_size_per_dimension.at(dim_idx); // convert to units of bin_size
-				coords.at(dim_idx) = 0.0 + bin_displacement; // 0.0 is defined as coord of (min)
+	return pyramid;
 
-			} else {
+}
+
+const Fuse::Analysis::Tmd_histogram* Fuse::Analysis::find_pyramid_histogram(
+		const Fuse::Analysis::Tmd_histogram_pyramid& pyramid,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds_per_dimension,
+		unsigned int num_bins_per_dimension
+		){
 
-				double fractional_bin_coord = (mean_value - bounds_per_dimension.at(dim_idx).first) / bin_size_per_dimension.at(dim_idx);
-				coords.at(dim_idx) = fractional_bin_coord;
+	if(pyramid.bounds_per_dimension != bounds_per_dimension)
+		return nullptr;
 
-			}
+	for(auto& histogram : pyramid.levels)
+		if(histogram.num_bins_per_dimension == num_bins_per_dimension)
+			return &histogram;
+
+	return nullptr;
+
+}
+
+Fuse::Analysis::Tmd_signature Fuse::Analysis::resample_tmd_signature(
+		const Fuse::Analysis::Tmd_signature& signature,
+		std::mt19937_64& random_engine
+		){
+
+	Fuse::Analysis::Tmd_signature resampled;
+	resampled.num_dimensions = signature.num_dimensions;
+	resampled.num_instances = signature.num_instances;
+
+	// The multinomial is drawn as a binomial per bin, conditioned on the instances drawn into the bins before it
+	unsigned int remaining_instances = signature.num_instances;
+	double remaining_weight = 1.0;
 
+	for(decltype(signature.weights.size()) bin_idx = 0; bin_idx < signature.weights.size() && remaining_instances > 0; bin_idx++){
+
+		unsigned int num_drawn = remaining_instances;
+		if(bin_idx + 1 < signature.weights.size()){
+			double probability = std::min(1.0, signature.weights[bin_idx] / std::max(remaining_weight, signature.weights[bin_idx]));
+			num_drawn = std::binomial_distribution<unsigned int>(remaining_instances, probability)(random_engine);
 		}
 
-		signature.Features[bin_idx].coords = coords;
-		signature.Weights[bin_idx] = weight;
+		remaining_weight -= signature.weights[bin_idx];
+		remaining_instances -= num_drawn;
+
+		if(num_drawn == 0)
+			continue;
 
-		bin_idx++;
+		resampled.coords.insert(resampled.coords.end(),
+			signature.coords.begin() + bin_idx*signature.num_dimensions,
+			signature.coords.begin() + (bin_idx+1)*signature.num_dimensions);
+		resampled.weights.push_back(static_cast<double>(num_drawn) / signature.num_instances);
 
 	}
 
-	return signature;
+	return resampled;
+
+}
+
+/* Exact EMD via fast_emd, with the ground distances from the same fixed-dimension kernels as the transport solver
+* The flow network is laid out as in fast_emd's signature interface, with the first signature's bins before the second's
+*/
+double calculate_fast_emd_between_signatures(
+		const Fuse::Analysis::Tmd_signature& tmd_signature_one,
+		const Fuse::Analysis::Tmd_signature& tmd_signature_two
+		){
+
+	size_t num_one = tmd_signature_one.weights.size();
+	size_t num_two = tmd_signature_two.weights.size();
+
+	std::vector<double> ground_distances;
+	Fuse::Transport::calculate_ground_distances(tmd_signature_one.num_dimensions,
+		tmd_signature_one.coords, tmd_signature_two.coords, ground_distances);
+
+	std::vector<double> P(num_one + num_two, 0.0);
+	std::vector<double> Q(num_one + num_two, 0.0);
+	std::copy(tmd_signature_one.weights.begin(), tmd_signature_one.weights.end(), P.begin());
+	std::copy(tmd_signature_two.weights.begin(), tmd_signature_two.weights.end(), Q.begin() + num_one);
+
+	std::vector<std::vector<double> > C(num_one + num_two, std::vector<double>(num_one + num_two, 0.0));
+	for(size_t i = 0; i < num_one; i++){
+		for(size_t j = 0; j < num_two; j++){
+			double distance = ground_distances[i*num_two + j];
+			C[i][j + num_one] = distance;
+			C[j + num_one][i] = distance;
+		}
+	}
+
+	double extra_mass_penalty = 0.0;
+	return emd_hat<double,NO_FLOW>()(P, Q, C, extra_mass_penalty);
+
+}
+
+double Fuse::Analysis::calculate_tmd_between_signatures(
+		const Fuse::Analysis::Tmd_signature& tmd_signature_one,
+		const Fuse::Analysis::Tmd_signature& tmd_signature_two,
+		Fuse::Tmd_solver solver
+		){
+
+	if(solver == Fuse::Tmd_solver::SINKHORN){
+		return Fuse::Transport::calculate_sinkhorn_emd(
+			tmd_signature_one.num_dimensions,
+			tmd_signature_one.coords,
+			tmd_signature_one.weights,
+			tmd_signature_two.coords,
+			tmd_signature_two.weights,
+			Fuse::Config::sinkhorn_epsilon,
+			Fuse::Config::sinkhorn_tolerance,
+			Fuse::Config::sinkhorn_max_iterations
+		);
+	}
+
+	if(solver == Fuse::Tmd_solver::TRANSPORT_SIMPLEX){
+
+		double result = Fuse::Transport::calculate_emd(
+			tmd_signature_one.num_dimensions,
+			tmd_signature_one.coords,
+			tmd_signature_one.weights,
+			tmd_signature_two.coords,
+			tmd_signature_two.weights
+		);
+
+		if(result >= 0.0)
+			return result;
+
+		spdlog::warn("The transport solver did not converge for signatures of {} and {} bins, so using fast_emd instead.",
+			tmd_signature_one.weights.size(),
+			tmd_signature_two.weights.size()
+		);
+
+	}
+
+	return calculate_fast_emd_between_signatures(tmd_signature_one, tmd_signature_two);
+
+}
+
+double Fuse::Analysis::calculate_tmd_lower_bound_between_signatures(
+		const Fuse::Analysis::Tmd_signature& tmd_signature_one,
+		const Fuse::Analysis::Tmd_signature& tmd_signature_two
+		){
+
+	return Fuse::Transport::calculate_emd_lower_bound(
+		tmd_signature_one.num_dimensions,
+		tmd_signature_one.coords,
+		tmd_signature_one.weights,
+		tmd_signature_two.coords,
+		tmd_signature_two.weights
+	);
+
+}
+
+std::vector<double> Fuse::Analysis::construct_sorted_marginal(
+		const std::vector<std::vector<int64_t> >& distribution,
+		unsigned int dimension,
+		std::pair<int64_t, int64_t> bounds
+		){
+
+	// Normalising by the reference range makes the distances of different events comparable before calibration
+	double range = static_cast<double>(bounds.second) - static_cast<double>(bounds.first);
+	if(range <= 0.0)
+		range = 1.0;
+
+	std::vector<double> marginal;
+	marginal.reserve(distribution.size());
+	for(auto& instance_values : distribution)
+		marginal.push_back((static_cast<double>(instance_values.at(dimension)) - static_cast<double>(bounds.first)) / range);
+
+	std::sort(marginal.begin(), marginal.end());
+
+	return marginal;
+
+}
+
+std::vector<double> Fuse::Analysis::calculate_ranks(
+		const std::vector<int64_t>& values
+		){
+
+	std::vector<size_t> order(values.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&values](size_t i, size_t j){ return values[i] < values[j]; });
+
+	std::vector<double> ranks(values.size());
+
+	size_t run_start = 0;
+	while(run_start < order.size()){
+
+		size_t run_end = run_start + 1;
+		while(run_end < order.size() && values[order[run_end]] == values[order[run_start]])
+			run_end++;
+
+		// Positions run_start to run_end-1 are tied, so share the mean of ranks run_start+1 to run_end
+		double rank = (static_cast<double>(run_start + 1) + static_cast<double>(run_end)) / 2.0;
+		for(size_t position = run_start; position < run_end; position++)
+			ranks[order[position]] = rank;
+
+		run_start = run_end;
+
+	}
+
+	return ranks;
+
+}
+
+double Fuse::Analysis::calculate_spearmans_rank_correlation(
+		const std::vector<std::vector<int64_t> >& distribution
+		){
+
+	size_t num_instances = distribution.size();
+	if(num_instances < 2)
+		return 0.0;
+
+	// Copy each dimension into its own contiguous column before ranking
+	std::vector<int64_t> column_one;
+	std::vector<int64_t> column_two;
+	column_one.reserve(num_instances);
+	column_two.reserve(num_instances);
+	for(auto& instance_values : distribution){
+		column_one.push_back(instance_values.at(0));
+		column_two.push_back(instance_values.at(1));
+	}
+
+	auto ranks_one = Fuse::Analysis::calculate_ranks(column_one);
+	auto ranks_two = Fuse::Analysis::calculate_ranks(column_two);
+
+	// Pearson correlation of the ranks, which handles ties correctly (unlike the 1 - 6*sum(d^2)/(n(n^2-1)) shortcut)
+	double mean_rank = (static_cast<double>(num_instances) + 1.0) / 2.0;
+
+	double covariance = 0.0;
+	double variance_one = 0.0;
+	double variance_two = 0.0;
+	for(size_t instance_idx = 0; instance_idx < num_instances; instance_idx++){
+		double deviation_one = ranks_one[instance_idx] - mean_rank;
+		double deviation_two = ranks_two[instance_idx] - mean_rank;
+		covariance += deviation_one * deviation_two;
+		variance_one += deviation_one * deviation_one;
+		variance_two += deviation_two * deviation_two;
+	}
+
+	if(variance_one == 0.0 || variance_two == 0.0)
+		return 0.0;
+
+	return covariance / std::sqrt(variance_one * variance_two);
+
 }
 
 double Fuse::Analysis::calculate_uncalibrated_tmd(
@@ -211,27 +823,19 @@ double Fuse::Analysis::calculate_uncalibrated_tmd(
 		unsigned int num_bins_per_dimension
 		){
 
-	signature_tt<double> signature_one = convert_distribution_to_bounded_signature(
+	auto signature_one = Fuse::Analysis::construct_tmd_signature(
 		distribution_one,
 		bounds_per_dimension,
 		num_bins_per_dimension
 	);
 
-	signature_tt<double> signature_two = convert_distribution_to_bounded_signature(
+	auto signature_two = Fuse::Analysis::construct_tmd_signature(
 		distribution_two,
 		bounds_per_dimension,
 		num_bins_per_dimension
 	);
 
-	double extra_mass_penalty = 0.0;
-	double result = emd_hat_signature_interface<double>(&signature_one, &signature_two, distance_calculation, extra_mass_penalty);
-
-	delete[](signature_one.Features);
-	delete[](signature_one.Weights);
-	delete[](signature_two.Features);
-	delete[](signature_two.Weights);
-
-	return result;
+	return Fuse::Analysis::calculate_tmd_between_signatures(signature_one, signature_two, Fuse::Config::tmd_solver);
 
 }
 
@@ -276,68 +880,156 @@ double Fuse::Analysis::compute_ami(
 
 }
 
-double Fuse::Analysis::calculate_calibrated_tmd_for_pair(
+std::vector<std::pair<int64_t, int64_t> > get_bounds_per_event(
 		Fuse::Target& target,
-		std::vector<Fuse::Symbol> symbols,
 		Fuse::Event_set reference_pair,
-		Fuse::Profile_p profile,
+		Fuse::Symbol symbol
+		){
+
+	std::vector<std::pair<int64_t, int64_t> > bounds_per_event;
+	for(auto event : reference_pair)
+		bounds_per_event.push_back(target.get_statistics()->get_bounds(event, symbol));
+
+	return bounds_per_event;
+
+}
+
+// Median, across the reference repeats, of either the TMD or its lower bound between the signature and each reference signature
+double calculate_median_tmd_to_references(
+		Fuse::Target& target,
+		Fuse::Symbol symbol,
+		Fuse::Event_set reference_pair,
+		const Fuse::Analysis::Tmd_signature& signature,
 		std::vector<unsigned int> reference_repeats_list,
 		unsigned int bin_count,
-		bool weighted_tmd
+		Fuse::Tmd_solver solver,
+		bool lower_bound_only
 		){
 
-	std::map<Fuse::Symbol, double> uncalibrated_tmd_per_symbol;
+	std::vector<double> uncalibrated_tmds_per_reference_repeat;
+	uncalibrated_tmds_per_reference_repeat.reserve(reference_repeats_list.size());
 
-	for(auto symbol : symbols){
+	auto bounds_per_event = get_bounds_per_event(target, reference_pair, symbol);
 
-		std::vector<double> uncalibrated_tmds_per_reference_repeat;
-		uncalibrated_tmds_per_reference_repeat.reserve(reference_repeats_list.size());
+	for(auto reference_repeat_idx : reference_repeats_list){
 
-		std::vector<Fuse::Symbol> constrained_symbols;
-		if(symbol != "all_symbols")
-			constrained_symbols = {symbol};
+		auto reference_signature = target.get_or_build_reference_signature(
+			reference_pair,
+			reference_repeat_idx,
+			symbol,
+			bounds_per_event,
+			bin_count
+		);
 
-		std::vector<std::pair<int64_t, int64_t> > bounds_per_event;
-		for(auto event : reference_pair)
-			bounds_per_event.push_back(target.get_statistics()->get_bounds(event, symbol));
+		double uncalibrated_tmd = 0.0;
+		if(lower_bound_only)
+			uncalibrated_tmd = Fuse::Analysis::calculate_tmd_lower_bound_between_signatures(*reference_signature, signature);
+		else
+			uncalibrated_tmd = Fuse::Analysis::calculate_tmd_between_signatures(*reference_signature, signature, solver);
 
-		// We are guaranteed one if no exception
-		std::map<std::string, std::vector<std::vector<int64_t> > > distribution_per_symbol =
-			profile->get_value_distribution(
-				reference_pair,
-				false,
-				constrained_symbols
-			);
-		auto distribution = distribution_per_symbol.begin()->second;
+		uncalibrated_tmds_per_reference_repeat.push_back(uncalibrated_tmd);
 
-		for(auto reference_repeat_idx : reference_repeats_list){
+	}
 
-			auto reference_distribution = target.get_or_load_reference_distribution(
-				reference_pair,
-				reference_repeat_idx,
-				constrained_symbols
-			);
+	return Fuse::calculate_median_from_values(uncalibrated_tmds_per_reference_repeat);
 
-			auto uncalibrated_tmd = Fuse::Analysis::calculate_uncalibrated_tmd(
-				reference_distribution,
-				distribution,
-				bounds_per_event,
-				bin_count
-			);
+}
 
-			uncalibrated_tmds_per_reference_repeat.push_back(uncalibrated_tmd);
+Fuse::Analysis::Tmd_signature Fuse::Analysis::construct_profile_signature_for_symbol(
+		Fuse::Target& target,
+		Fuse::Symbol symbol,
+		Fuse::Event_set reference_pair,
+		Fuse::Profile_p profile,
+		unsigned int bin_count
+		){
 
-		}
+	std::vector<Fuse::Symbol> constrained_symbols;
+	if(symbol != "all_symbols")
+		constrained_symbols = {symbol};
 
-		double median_uncalibrated_tmd = Fuse::calculate_median_from_values(
-			uncalibrated_tmds_per_reference_repeat
+	// We are guaranteed one if no exception
+	std::map<std::string, std::vector<std::vector<int64_t> > > distribution_per_symbol =
+		profile->get_value_distribution(
+			reference_pair,
+			false,
+			constrained_symbols
 		);
 
-		uncalibrated_tmd_per_symbol.insert(std::make_pair(symbol, median_uncalibrated_tmd));
+	return Fuse::Analysis::construct_tmd_signature(
+		distribution_per_symbol.begin()->second,
+		get_bounds_per_event(target, reference_pair, symbol),
+		bin_count
+	);
 
-	}
+}
 
-	// Now calibrate and average the tmds across symbol to get the calibrated tmd w.r.t reference pair
+double Fuse::Analysis::calculate_uncalibrated_tmd_for_signature(
+		Fuse::Target& target,
+		Fuse::Symbol symbol,
+		Fuse::Event_set reference_pair,
+		const Fuse::Analysis::Tmd_signature& signature,
+		std::vector<unsigned int> reference_repeats_list,
+		unsigned int bin_count,
+		Fuse::Tmd_solver solver
+		){
+
+	return calculate_median_tmd_to_references(target, symbol, reference_pair, signature, reference_repeats_list, bin_count, solver, false);
+
+}
+
+double Fuse::Analysis::calculate_uncalibrated_tmd_lower_bound_for_signature(
+		Fuse::Target& target,
+		Fuse::Symbol symbol,
+		Fuse::Event_set reference_pair,
+		const Fuse::Analysis::Tmd_signature& signature,
+		std::vector<unsigned int> reference_repeats_list,
+		unsigned int bin_count
+		){
+
+	// The solver is unused when only computing the bound
+	return calculate_median_tmd_to_references(target, symbol, reference_pair, signature, reference_repeats_list, bin_count,
+		Fuse::Tmd_solver::TRANSPORT_SIMPLEX, true);
+
+}
+
+double Fuse::Analysis::calculate_uncalibrated_tmd_for_symbol(
+		Fuse::Target& target,
+		Fuse::Symbol symbol,
+		Fuse::Event_set reference_pair,
+		Fuse::Profile_p profile,
+		std::vector<unsigned int> reference_repeats_list,
+		unsigned int bin_count,
+		Fuse::Tmd_solver solver
+		){
+
+	auto signature = Fuse::Analysis::construct_profile_signature_for_symbol(
+		target,
+		symbol,
+		reference_pair,
+		profile,
+		bin_count
+	);
+
+	return Fuse::Analysis::calculate_uncalibrated_tmd_for_signature(
+		target,
+		symbol,
+		reference_pair,
+		signature,
+		reference_repeats_list,
+		bin_count,
+		solver
+	);
+
+}
+
+double Fuse::Analysis::calibrate_tmds_for_pair(
+		Fuse::Target& target,
+		Fuse::Event_set reference_pair,
+		std::map<Fuse::Symbol, double> uncalibrated_tmd_per_symbol,
+		bool weighted_tmd
+		){
+
+	// Calibrate and average the tmds across symbol to get the calibrated tmd w.r.t reference pair
 	std::vector<double> calibrated_tmds_per_symbol;
 	std::vector<double> weights_per_symbol;
 	calibrated_tmds_per_symbol.reserve(uncalibrated_tmd_per_symbol.size());
@@ -383,52 +1075,183 @@ double Fuse::Analysis::calculate_calibrated_tmd_for_pair(
 
 }
 
-double Fuse::Analysis::calculate_normalised_mutual_information(
-		std::vector<std::vector<int64_t> > distribution
+double Fuse::Analysis::calculate_calibrated_tmd_for_pair(
+		Fuse::Target& target,
+		std::vector<Fuse::Symbol> symbols,
+		Fuse::Event_set reference_pair,
+		Fuse::Profile_p profile,
+		std::vector<unsigned int> reference_repeats_list,
+		unsigned int bin_count,
+		bool weighted_tmd,
+		Fuse::Tmd_solver solver
 		){
 
-	unsigned int event1_counts[distribution.size()];
-	unsigned int event2_counts[distribution.size()]; // must be same length
-
-	int64_t min_e1 = 99999;
-	int64_t max_e1 = 0;
-	int64_t min_e2 = 99999;
-	int64_t max_e2 = 0;
-	for(unsigned int task_idx = 0; task_idx < distribution.size(); task_idx++){
-	
-		std::vector<int64_t> task_counts = distribution.at(task_idx);
-		if(task_counts.at(0) < min_e1)
-			min_e1 = task_counts.at(0);
-		if (task_counts.at(0) > max_e1)
-			max_e1 = task_counts.at(0);
-		
-		if(task_counts.at(1) < min_e2)
-			min_e2 = task_counts.at(1);
-		if (task_counts.at(1) > max_e2)
-			max_e2 = task_counts.at(1);
+	std::map<Fuse::Symbol, double> uncalibrated_tmd_per_symbol;
+
+	for(auto symbol : symbols){
+
+		double median_uncalibrated_tmd = Fuse::Analysis::calculate_uncalibrated_tmd_for_symbol(
+			target,
+			symbol,
+			reference_pair,
+			profile,
+			reference_repeats_list,
+			bin_count,
+			solver
+		);
+
+		uncalibrated_tmd_per_symbol.insert(std::make_pair(symbol, median_uncalibrated_tmd));
 
 	}
 
-	for(unsigned int task_idx = 0; task_idx < distribution.size(); task_idx++){
+	return Fuse::Analysis::calibrate_tmds_for_pair(target, reference_pair, uncalibrated_tmd_per_symbol, weighted_tmd);
 
-		event1_counts[task_idx] = (unsigned int) ((((double)(distribution.at(task_idx).at(0) - min_e1)) / (max_e1 - min_e1))*1000);
-		event2_counts[task_idx] = (unsigned int) ((((double)(distribution.at(task_idx).at(1) - min_e2)) / (max_e2 - min_e2))*1000);
+}
+
+// Buffers for the mutual information kernel, kept per thread and only ever grown, so repeated calls do not allocate
+struct Mutual_information_workspace {
+	std::vector<double> offsets;
+	std::vector<uint32_t> counts_one;
+	std::vector<uint32_t> counts_two;
+	std::vector<uint32_t> joint_counts; // num_bins^2, kept zeroed between calls by resetting only the populated cells
+	std::vector<uint32_t> populated_joint_cells;
+};
+
+thread_local Mutual_information_workspace mutual_information_workspace;
+
+// Sum of -c*log(c/n) over the counts, divided by n, i.e. the entropy (in nats) of the normalised counts
+double calculate_entropy_of_counts(
+		const uint32_t* counts,
+		size_t num_counts,
+		double num_instances
+		){
+
+	double summed_count_logs = 0.0;
+	for(size_t count_idx = 0; count_idx < num_counts; count_idx++)
+		if(counts[count_idx] > 0)
+			summed_count_logs += counts[count_idx] * std::log(static_cast<double>(counts[count_idx]));
+
+	return std::log(num_instances) - summed_count_logs / num_instances;
+
+}
+
+std::vector<int32_t> Fuse::Analysis::bin_values_for_mutual_information(
+		const std::vector<std::vector<int64_t> >& distribution,
+		unsigned int dimension
+		){
 
+	static const Fuse::Analysis::Bin_coords_kernel compute_bin_coords = Fuse::Analysis::get_supported_bin_coords_kernels().back();
+
+	size_t num_instances = distribution.size();
+	std::vector<int32_t> bins(num_instances, 0);
+	if(num_instances == 0)
+		return bins;
+
+	// Contiguous column, so that the range and the bins are computed by vectorised loops
+	std::vector<int64_t> values(num_instances);
+	for(size_t instance_idx = 0; instance_idx < num_instances; instance_idx++)
+		values[instance_idx] = distribution[instance_idx].at(dimension);
+
+	int64_t min_value = values[0];
+	int64_t max_value = values[0];
+	#pragma omp simd reduction(min:min_value) reduction(max:max_value)
+	for(size_t instance_idx = 0; instance_idx < num_instances; instance_idx++){
+		min_value = std::min(min_value, values[instance_idx]);
+		max_value = std::max(max_value, values[instance_idx]);
 	}
 
-	// normalised as http://www.jmlr.org/papers/volume3/strehl02a/strehl02a.pdf (page 589)
-	double event1_entropy = calcEntropy(&event1_counts[0], distribution.size());
-	double event2_entropy = calcEntropy(&event2_counts[0], distribution.size());
-	double denominator = std::sqrt(event1_entropy * event2_entropy);
+	// Constant values have no entropy, so all share bin 0
+	if(min_value == max_value)
+		return bins;
+
+	Mutual_information_workspace& ws = mutual_information_workspace;
+	ws.offsets.resize(num_instances);
+	#pragma omp simd
+	for(size_t instance_idx = 0; instance_idx < num_instances; instance_idx++)
+		ws.offsets[instance_idx] = static_cast<double>(values[instance_idx] - min_value);
+
+	double bin_size = (static_cast<double>(max_value) - static_cast<double>(min_value)) / Fuse::Analysis::num_mutual_information_bins;
 
-	double mi = calcMutualInformation(&event1_counts[0], &event2_counts[0], distribution.size());
+	compute_bin_coords(values.data(), ws.offsets.data(), num_instances, bin_size, max_value,
+		Fuse::Analysis::num_mutual_information_bins, bins.data());
+
+	// Every value is within the range, so only rounding of the division could reach the external bin above
+	const int32_t last_bin = Fuse::Analysis::num_mutual_information_bins - 1;
+	#pragma omp simd
+	for(size_t instance_idx = 0; instance_idx < num_instances; instance_idx++)
+		bins[instance_idx] = std::min(bins[instance_idx], last_bin);
+
+	return bins;
+
+}
+
+double Fuse::Analysis::calculate_normalised_mutual_information_of_bins(
+		const std::vector<int32_t>& bins_one,
+		const std::vector<int32_t>& bins_two
+		){
 
-	if(denominator == 0.0){
+	if(bins_one.size() != bins_two.size())
+		throw std::invalid_argument(fmt::format("Cannot calculate mutual information between {} and {} binned values.",
+			bins_one.size(), bins_two.size()));
+
+	size_t num_instances = bins_one.size();
+	if(num_instances == 0)
+		return 0.0;
+
+	const size_t num_bins = Fuse::Analysis::num_mutual_information_bins;
+
+	Mutual_information_workspace& ws = mutual_information_workspace;
+	ws.counts_one.assign(num_bins, 0);
+	ws.counts_two.assign(num_bins, 0);
+	if(ws.joint_counts.size() < num_bins * num_bins)
+		ws.joint_counts.assign(num_bins * num_bins, 0);
+	ws.populated_joint_cells.clear();
+
+	// One pass builds both marginal histograms and the joint histogram
+	for(size_t instance_idx = 0; instance_idx < num_instances; instance_idx++){
+
+		size_t bin_one = bins_one[instance_idx];
+		size_t bin_two = bins_two[instance_idx];
+		size_t joint_cell = bin_one * num_bins + bin_two;
+
+		ws.counts_one[bin_one]++;
+		ws.counts_two[bin_two]++;
+		if(ws.joint_counts[joint_cell]++ == 0)
+			ws.populated_joint_cells.push_back(joint_cell);
+
+	}
+
+	double entropy_one = calculate_entropy_of_counts(ws.counts_one.data(), num_bins, num_instances);
+	double entropy_two = calculate_entropy_of_counts(ws.counts_two.data(), num_bins, num_instances);
+
+	double summed_joint_count_logs = 0.0;
+	for(auto joint_cell : ws.populated_joint_cells){
+		summed_joint_count_logs += ws.joint_counts[joint_cell] * std::log(static_cast<double>(ws.joint_counts[joint_cell]));
+		ws.joint_counts[joint_cell] = 0;
+	}
+	double joint_entropy = std::log(static_cast<double>(num_instances)) - summed_joint_count_logs / num_instances;
+
+	// normalised as http://www.jmlr.org/papers/volume3/strehl02a/strehl02a.pdf (page 589)
+	double denominator = std::sqrt(entropy_one * entropy_two);
+	if(denominator <= 0.0){
 		// The values are constant, so there is 0 entropy, meaning 0 entropy difference, meaning no information
 		return 0.0;
 	}
 
+	double mi = std::max(0.0, entropy_one + entropy_two - joint_entropy);
+
 	return (mi / denominator);
 
 }
 
+double Fuse::Analysis::calculate_normalised_mutual_information(
+		std::vector<std::vector<int64_t> > distribution
+		){
+
+	return Fuse::Analysis::calculate_normalised_mutual_information_of_bins(
+		Fuse::Analysis::bin_values_for_mutual_information(distribution, 0),
+		Fuse::Analysis::bin_values_for_mutual_information(distribution, 1)
+	);
+
+}
+
@@ -4,14 +4,20 @@
 #include "instance.h"
 #include "util.h"
 #include "statistics.h"
+#include "config.h"
 
 #include "spdlog/spdlog.h"
 
 #include <algorithm>
+#include <cmath>
 #include <ctime>
+#include <exception>
 #include <limits>
+#include <numeric>
 #include <vector>
 #include <random>
+#include <set>
+#include <unordered_map>
 
 Fuse::Profile_p Fuse::Combination::combine_profiles_via_strategy(
 		std::vector<Fuse::Profile_p> sequence_profiles,
@@ -28,6 +34,11 @@ Fuse::Profile_p Fuse::Combination::combine_profiles_via_strategy(
 
 	std::vector<Fuse::Instance_p> combined_instances;
 
+	// The residuals of any already-combined inputs carry over to the new combination
+	Fuse::Combination_residuals residuals;
+	for(auto profile : sequence_profiles)
+		Fuse::Combination::accumulate_residuals(residuals, profile->get_combination_residuals());
+
 	switch(strategy){
 
 		case Fuse::Strategy::RANDOM:
@@ -37,7 +48,8 @@ Fuse::Profile_p Fuse::Combination::combine_profiles_via_strategy(
 			combined_instances = Fuse::Combination::generate_combined_instances_from_unordered_profiles(
 				sequence_profiles,
 				strategy,
-				false
+				false,
+				&residuals
 			);
 			break;
 		case Fuse::Strategy::RANDOM_TT:
@@ -47,15 +59,19 @@ Fuse::Profile_p Fuse::Combination::combine_profiles_via_strategy(
 			combined_instances = Fuse::Combination::generate_combined_instances_from_unordered_profiles(
 				sequence_profiles,
 				strategy,
-				true
+				true,
+				&residuals
 			);
 			break;
 		case Fuse::Strategy::BC:
+		case Fuse::Strategy::AUCTION:
+			// Both match instances on the linking events between consecutive parts of the sequence
 			combined_instances = Fuse::Combination::generate_combined_instances_bc(
 				sequence_profiles,
 				strategy,
 				statistics,
-				overlapping_per_profile
+				overlapping_per_profile,
+				&residuals
 			);
 			break;
 		case Fuse::Strategy::HEM:
@@ -87,6 +103,12 @@ Fuse::Profile_p Fuse::Combination::combine_profiles_via_strategy(
 	for(auto event : unique_events)
 		combined_execution_profile->add_event(event);
 
+	combined_execution_profile->set_combination_residuals(residuals);
+
+	spdlog::debug("Combination via strategy {} has a mean relative linking event residual of {}.",
+		Fuse::convert_strategy_to_string(strategy),
+		Fuse::Combination::summarise_residuals(residuals));
+
 	return combined_execution_profile;
 
 }
@@ -94,7 +116,8 @@ Fuse::Profile_p Fuse::Combination::combine_profiles_via_strategy(
 std::vector<Fuse::Instance_p> Fuse::Combination::generate_combined_instances_from_unordered_profiles(
 		std::vector<Fuse::Profile_p> sequence_profiles,
 		Fuse::Strategy strategy,
-		bool per_symbol
+		bool per_symbol,
+		Fuse::Combination_residuals* residuals
 		){
 
 	std::vector<Fuse::Instance_p> resulting_instances;
@@ -119,7 +142,8 @@ std::vector<Fuse::Instance_p> Fuse::Combination::generate_combined_instances_fro
 		for(auto profile : sequence_profiles)
 			instances_per_profile.push_back(profile->get_instances(false, restricted_symbols_list));
 
-		auto combined_instances = Fuse::Combination::combine_instances_via_strategy(instances_per_profile, strategy);
+		auto combined_instances = Fuse::Combination::combine_instances_via_strategy(
+			instances_per_profile, strategy, nullptr, Fuse::Event_set(), residuals);
 
 		resulting_instances.insert(resulting_instances.end(), combined_instances.begin(), combined_instances.end());
 
@@ -132,10 +156,12 @@ std::vector<Fuse::Instance_p> Fuse::Combination::combine_instances_via_strategy(
 		std::vector<std::vector<Fuse::Instance_p> >& instances_per_profile,
 		Fuse::Strategy strategy,
 		Fuse::Statistics_p statistics,
-		Fuse::Event_set overlapping_events
+		Fuse::Event_set overlapping_events,
+		Fuse::Combination_residuals* residuals
 		){
 
 	std::vector<std::vector<Fuse::Instance_p> > matched_instances;
+	std::vector<unsigned int> match_granularities;
 
 	switch(strategy){
 		case Fuse::Strategy::RANDOM:
@@ -154,7 +180,10 @@ std::vector<Fuse::Instance_p> Fuse::Combination::combine_instances_via_strategy(
 			matched_instances = extract_matched_instances_by_label(instances_per_profile, false);
 			break;
 		case Fuse::Strategy::BC:
-			matched_instances = extract_matched_instances_bc(instances_per_profile, true, statistics, overlapping_events);
+			matched_instances = extract_matched_instances_bc(instances_per_profile, true, statistics, overlapping_events, &match_granularities);
+			break;
+		case Fuse::Strategy::AUCTION:
+			matched_instances = extract_matched_instances_auction(instances_per_profile, true, statistics, overlapping_events);
 			break;
 		case Fuse::Strategy::HEM:
 		default:
@@ -167,9 +196,128 @@ std::vector<Fuse::Instance_p> Fuse::Combination::combine_instances_via_strategy(
 	for(auto match : matched_instances)
 		combined_instances.push_back(Fuse::Combination::combine_instances(match));
 
+	if(residuals != nullptr){
+		for(decltype(matched_instances.size()) match_idx = 0; match_idx < matched_instances.size(); match_idx++){
+			unsigned int granularity = match_idx < match_granularities.size() ? match_granularities.at(match_idx) : 0;
+			Fuse::Combination::add_match_residuals(matched_instances.at(match_idx), granularity, *residuals);
+		}
+	}
+
 	return combined_instances;
 }
 
+void Fuse::Combination::add_match_residuals(
+		const std::vector<Fuse::Instance_p>& match,
+		unsigned int granularity,
+		Fuse::Combination_residuals& residuals
+		){
+
+	if(match.size() < 2)
+		return;
+
+	auto& residuals_per_event = residuals[match.at(0)->symbol];
+
+	// A linking event is one that was measured in more than one of the matched instances
+	// Each later measurement is compared against the first
+	for(decltype(match.size()) instance_idx = 0; instance_idx < match.size(); instance_idx++){
+		for(auto event_value : match.at(instance_idx)->event_values){
+
+			bool measured_earlier = false;
+			for(decltype(instance_idx) earlier_idx = 0; earlier_idx < instance_idx; earlier_idx++)
+				if(match.at(earlier_idx)->event_values.count(event_value.first) > 0)
+					measured_earlier = true;
+
+			if(measured_earlier)
+				continue;
+
+			for(auto later_idx = instance_idx+1; later_idx < match.size(); later_idx++){
+
+				auto later_iter = match.at(later_idx)->event_values.find(event_value.first);
+				if(later_iter == match.at(later_idx)->event_values.end())
+					continue;
+
+				double a = static_cast<double>(event_value.second);
+				double b = static_cast<double>(later_iter->second);
+				double absolute_difference = std::abs(a - b);
+				double magnitude = std::max(std::abs(a), std::abs(b));
+
+				auto residual_iter = residuals_per_event.find(event_value.first);
+				if(residual_iter == residuals_per_event.end()){
+					Fuse::Linking_residual residual = {0, 0.0, 0.0, 0.0, 0, 0.0, std::numeric_limits<unsigned int>::max()};
+					residual_iter = residuals_per_event.insert(std::make_pair(event_value.first, residual)).first;
+				}
+
+				auto& residual = residual_iter->second;
+				residual.num_matches++;
+				residual.sum_absolute_difference += absolute_difference;
+				residual.sum_relative_difference += (magnitude > 0.0) ? (absolute_difference / magnitude) : 0.0;
+				residual.max_absolute_difference = std::max(residual.max_absolute_difference, absolute_difference);
+
+				if(granularity > 0){
+					residual.num_granularity_matches++;
+					residual.sum_granularity += granularity;
+					residual.min_granularity = std::min(residual.min_granularity, granularity);
+				}
+
+			}
+
+		}
+	}
+
+}
+
+void Fuse::Combination::accumulate_residuals(
+		Fuse::Combination_residuals& residuals,
+		const Fuse::Combination_residuals& additional_residuals
+		){
+
+	for(auto symbol_iter : additional_residuals){
+
+		auto& residuals_per_event = residuals[symbol_iter.first];
+
+		for(auto event_iter : symbol_iter.second){
+
+			auto residual_iter = residuals_per_event.find(event_iter.first);
+			if(residual_iter == residuals_per_event.end()){
+				residuals_per_event.insert(event_iter);
+				continue;
+			}
+
+			auto& residual = residual_iter->second;
+			residual.num_matches += event_iter.second.num_matches;
+			residual.sum_absolute_difference += event_iter.second.sum_absolute_difference;
+			residual.sum_relative_difference += event_iter.second.sum_relative_difference;
+			residual.max_absolute_difference = std::max(residual.max_absolute_difference, event_iter.second.max_absolute_difference);
+			residual.num_granularity_matches += event_iter.second.num_granularity_matches;
+			residual.sum_granularity += event_iter.second.sum_granularity;
+			residual.min_granularity = std::min(residual.min_granularity, event_iter.second.min_granularity);
+
+		}
+	}
+
+}
+
+double Fuse::Combination::summarise_residuals(
+		const Fuse::Combination_residuals& residuals
+		){
+
+	unsigned long num_values = 0;
+	double sum_relative_difference = 0.0;
+
+	for(auto symbol_iter : residuals){
+		for(auto event_iter : symbol_iter.second){
+			num_values += event_iter.second.num_matches;
+			sum_relative_difference += event_iter.second.sum_relative_difference;
+		}
+	}
+
+	if(num_values == 0)
+		return 0.0;
+
+	return sum_relative_difference / num_values;
+
+}
+
 Fuse::Instance_p Fuse::Combination::combine_instances(
 		std::vector<Fuse::Instance_p> instances_to_combine
 		){
@@ -286,612 +434,761 @@ std::vector<std::vector<Fuse::Instance_p> > Fuse::Combination::extract_matched_i
 	return matched_instances;
 }
 
+/* Hash join of the profiles' instances on their labels
+* The first profile is probed against a hash table of each other profile, keyed on the encoded label
+* Duplicate labels within a profile are matched in order of occurrence
+*/
 std::vector<std::vector<Fuse::Instance_p> > Fuse::Combination::extract_matched_instances_by_label(
 		std::vector<std::vector<Fuse::Instance_p> >& instances_per_profile,
 		bool remove_combined_instances,
 		bool expect_matching
 		){
 
-	std::vector<unsigned int> num_instances_per_profile;
-	for(auto profile_instances : instances_per_profile){
-		std::sort(profile_instances.begin(), profile_instances.end(), Fuse::comp_instances_by_label_dfs);
-		num_instances_per_profile.push_back(profile_instances.size());
-	}
-
-	if(expect_matching)
-		if(std::adjacent_find(num_instances_per_profile.begin(), num_instances_per_profile.end(), std::not_equal_to<unsigned int>())
-				!= num_instances_per_profile.end())
-			spdlog::warn(fmt::format("Found variable instance counts when combining instances from {} sequence profiles by matching label: {}.",
-				instances_per_profile.size(), Fuse::Util::vector_to_string(num_instances_per_profile)));
-
-	unsigned int common_num_instances = *std::min_element(num_instances_per_profile.begin(), num_instances_per_profile.end());
-
 	std::vector<std::vector<Fuse::Instance_p> > matched_instances;
-	matched_instances.reserve(common_num_instances);
-
-	for(unsigned int instance_idx = 0; instance_idx < common_num_instances; instance_idx++){
 
-		std::vector<std::string> matched_label_strs;
-		std::vector<Fuse::Instance_p> match;
+	auto num_profiles = instances_per_profile.size();
+	if(num_profiles == 0)
+		return matched_instances;
 
-		match.reserve(instances_per_profile.size());
-		matched_label_strs.reserve(instances_per_profile.size());
+	const unsigned int no_instance = std::numeric_limits<unsigned int>::max();
 
-		for(auto profile_instances : instances_per_profile){
-			match.push_back(profile_instances.at(instance_idx));
-			matched_label_strs.push_back(Fuse::Util::vector_to_string(profile_instances.at(instance_idx)->label));
-		}
+	// Build a table per profile (other than the first) from encoded label to the first instance with that encoding
+	// Instances sharing an encoding are chained, and are resolved by comparing the full label
+	std::vector<std::unordered_map<uint64_t, unsigned int> > first_instance_per_profile(num_profiles);
+	std::vector<std::vector<unsigned int> > next_instance_per_profile(num_profiles);
+	std::vector<std::vector<char> > matched_per_profile(num_profiles);
 
-		if(expect_matching)
-			if(std::adjacent_find(matched_label_strs.begin(), matched_label_strs.end(), std::not_equal_to<std::string>()) != matched_label_strs.end())
-				spdlog::warn("LGL strategy matched different labels across profiles: {}.", Fuse::Util::vector_to_string(matched_label_strs));
+	for(decltype(num_profiles) profile_idx = 1; profile_idx < num_profiles; profile_idx++){
 
-		matched_instances.push_back(match);
-	}
+		auto& profile_instances = instances_per_profile.at(profile_idx);
+		auto& first_instance = first_instance_per_profile.at(profile_idx);
+		auto& next_instance = next_instance_per_profile.at(profile_idx);
 
-	if(remove_combined_instances)
-		for(auto profile_instances : instances_per_profile)
-			profile_instances.erase(profile_instances.begin(), profile_instances.begin() + common_num_instances);
+		first_instance.reserve(profile_instances.size());
+		next_instance.assign(profile_instances.size(), no_instance);
+		matched_per_profile.at(profile_idx).assign(profile_instances.size(), 0);
 
-	return matched_instances;
-}
+		// Insert in reverse, so that each chain is in order of occurrence
+		for(auto instance_idx = profile_instances.size(); instance_idx-- > 0;){
 
-std::vector<Fuse::Instance_p> Fuse::Combination::generate_combined_instances_bc(
-		std::vector<Fuse::Profile_p> sequence_profiles,
-		Fuse::Strategy strategy,
-		Fuse::Statistics_p statistics,
-		std::vector<Fuse::Event_set> overlapping_per_profile
-	){
+			auto encoded_label = Fuse::encode_label(profile_instances[instance_idx]->label);
 
-	std::vector<Fuse::Instance_p> resulting_instances;
+			auto first_iter = first_instance.find(encoded_label);
+			if(first_iter == first_instance.end()){
+				first_instance.insert(std::make_pair(encoded_label, instance_idx));
+			} else {
+				next_instance[instance_idx] = first_iter->second;
+				first_iter->second = instance_idx;
+			}
 
-	auto initial_profile = sequence_profiles.at(0);
-	auto symbols = initial_profile->get_unique_symbols(false);
-	std::map<Fuse::Symbol, std::vector<Fuse::Instance_p> > previous_instances_per_symbol;
+		}
 
-	for(auto symbol : symbols){
-		std::vector<Fuse::Symbol> symbol_list = {symbol};
-		auto instances_for_symbol = initial_profile->get_instances(false, symbol_list);
-		previous_instances_per_symbol.insert(std::make_pair(symbol, instances_for_symbol));
 	}
 
-	for(decltype(sequence_profiles.size()) combination_idx = 1; combination_idx < sequence_profiles.size(); combination_idx++){
+	matched_per_profile.at(0).assign(instances_per_profile.at(0).size(), 0);
+	matched_instances.reserve(instances_per_profile.at(0).size());
 
-		auto next_profile = sequence_profiles.at(combination_idx);
+	std::vector<unsigned int> match_indexes(num_profiles);
 
-		spdlog::info("Running BC combination {} to incorporate {} using overlapping events {}.",
-			combination_idx,
-			next_profile->get_tracefile_name(),
-			Fuse::Util::vector_to_string(overlapping_per_profile.at(combination_idx))
-		);
+	// Probe with each instance of the first profile
+	for(decltype(instances_per_profile.at(0).size()) instance_idx = 0; instance_idx < instances_per_profile.at(0).size(); instance_idx++){
 
-		std::map<Fuse::Symbol, std::vector<Fuse::Instance_p> > combined_instances_per_symbol;
+		auto& label = instances_per_profile.at(0)[instance_idx]->label;
+		auto encoded_label = Fuse::encode_label(label);
 
-		for(auto symbol : symbols){
+		bool found_in_all = true;
+		for(decltype(num_profiles) profile_idx = 1; profile_idx < num_profiles && found_in_all; profile_idx++){
 
-			spdlog::debug("Clustering instances of symbol [{}] ({}/{}).",
-				symbol, std::find(symbols.begin(), symbols.end(), symbol) - symbols.begin() + 1, symbols.size());
+			auto& profile_instances = instances_per_profile.at(profile_idx);
+			auto& matched = matched_per_profile.at(profile_idx);
 
-			std::vector<std::vector<Fuse::Instance_p> > instances_per_profile;
+			match_indexes[profile_idx] = no_instance;
 
-			// Add the instances from the previous combination
-			instances_per_profile.push_back(previous_instances_per_symbol.find(symbol)->second);
+			auto first_iter = first_instance_per_profile.at(profile_idx).find(encoded_label);
+			if(first_iter != first_instance_per_profile.at(profile_idx).end()){
+				for(auto candidate_idx = first_iter->second; candidate_idx != no_instance;
+						candidate_idx = next_instance_per_profile.at(profile_idx)[candidate_idx]){
 
-			// Add the instances from the next profile
-			std::vector<Fuse::Symbol> symbol_list = {symbol};
-			auto next_profile_instances = next_profile->get_instances(false, symbol_list);
-			instances_per_profile.push_back(next_profile_instances);
+					if(matched[candidate_idx] == 0 && profile_instances[candidate_idx]->label == label){
+						match_indexes[profile_idx] = candidate_idx;
+						break;
+					}
 
-			if(instances_per_profile.at(0).size() != instances_per_profile.at(1).size())
-				spdlog::debug("There are unequal number of instances ({} and {}) from the two profiles under BC combination.",
-					instances_per_profile.at(0).size(), instances_per_profile.at(1).size());
-			else
-				spdlog::debug("Clustering {} instances from each profile via BC, for symbol {}.",
-					instances_per_profile.at(0).size(), symbol);
+				}
+			}
 
-			auto combined_instances = Fuse::Combination::combine_instances_via_strategy(
-				instances_per_profile,
-				strategy,
-				statistics,
-				overlapping_per_profile.at(combination_idx)
-			);
+			if(match_indexes[profile_idx] == no_instance)
+				found_in_all = false;
 
-			if(instances_per_profile.at(0).size() > 0 || instances_per_profile.at(1).size() > 0)
-				spdlog::warn("There were uncombined instances for symbol '{}' remaining ({} and {}) after BC combination.",
-					symbol,
-					instances_per_profile.at(0).size(),
-					instances_per_profile.at(1).size()
-				);
+		}
+
+		if(found_in_all == false)
+			continue;
 
-			// Add the combined instances to the combined map of instances per symbol
-			combined_instances_per_symbol.insert(std::make_pair(symbol, combined_instances));
+		std::vector<Fuse::Instance_p> match;
+		match.reserve(num_profiles);
+		match.push_back(instances_per_profile.at(0)[instance_idx]);
+		matched_per_profile.at(0)[instance_idx] = 1;
 
+		for(decltype(num_profiles) profile_idx = 1; profile_idx < num_profiles; profile_idx++){
+			match.push_back(instances_per_profile.at(profile_idx)[match_indexes[profile_idx]]);
+			matched_per_profile.at(profile_idx)[match_indexes[profile_idx]] = 1;
 		}
 
-		// Set the results of this combination as the set of previous instances for the next combination
-		previous_instances_per_symbol = combined_instances_per_symbol;
+		matched_instances.push_back(match);
 
 	}
 
-	// The final combined instances per symbol are the results of the final combination, so aggregate them
-	for(auto symbol_instances : previous_instances_per_symbol)
-		resulting_instances.insert(resulting_instances.end(), symbol_instances.second.begin(), symbol_instances.second.end());
+	// Report the labels that could not be matched across all profiles, formatting only a few examples
+	if(expect_matching){
 
-	return resulting_instances;
-}
+		const unsigned int max_reported_labels = 5;
 
-/* Assume I have already filtered instances to per-symbol */
-std::vector<std::vector<Fuse::Instance_p> > Fuse::Combination::extract_matched_instances_bc(
-		std::vector<std::vector<Fuse::Instance_p> >& instances_per_profile,
-		bool remove_combined_instances,
-		Fuse::Statistics_p statistics,
-		Fuse::Event_set overlapping_events
-		){
+		std::vector<unsigned int> num_unmatched_per_profile;
+		std::vector<std::string> example_unmatched_labels;
 
-	std::vector<std::vector<Fuse::Instance_p> > matched_instances;
+		for(decltype(num_profiles) profile_idx = 0; profile_idx < num_profiles; profile_idx++){
 
-	if(instances_per_profile.size() != 2)
-		throw std::logic_error(fmt::format("BC combination strategy can only combine two profiles at a time, but {} were provided.",
-			instances_per_profile.size()));
+			unsigned int num_unmatched = 0;
+			for(decltype(instances_per_profile.at(profile_idx).size()) instance_idx = 0;
+					instance_idx < instances_per_profile.at(profile_idx).size(); instance_idx++){
 
-	if(statistics == nullptr)
-		throw std::logic_error("BC combination strategy requires event statistics, but none were provided.");
+				if(matched_per_profile.at(profile_idx)[instance_idx])
+					continue;
 
-	if(overlapping_events.size() == 0)
-		throw std::runtime_error("BC combination strategy requires overlapping events between profiles, but none were provided.");
+				num_unmatched++;
 
-	auto instances_a = instances_per_profile.at(0);
-	auto instances_b = instances_per_profile.at(1);
+				if(example_unmatched_labels.size() < max_reported_labels)
+					example_unmatched_labels.push_back(fmt::format("{} in profile {}",
+						Fuse::Util::vector_to_string(instances_per_profile.at(profile_idx)[instance_idx]->label), profile_idx));
 
-	// Sort so that we can use set_difference
-	std::sort(instances_a.begin(), instances_a.end());
-	std::sort(instances_b.begin(), instances_b.end());
+			}
 
-	if(instances_a.size() == 0 || instances_b.size() == 0)
-		return matched_instances;
+			num_unmatched_per_profile.push_back(num_unmatched);
 
-	Fuse::Symbol symbol;
-	if(instances_a.size() > 0)
-		symbol = instances_a.at(0)->symbol;
-	else if(instances_b.size() > 0)
-		symbol = instances_b.at(0)->symbol;
-	else
-		return matched_instances;
+		}
+
+		if(example_unmatched_labels.size() > 0)
+			spdlog::warn("LGL strategy matched {} instances across {} profiles, leaving {} unmatched per profile (e.g. {}).",
+				matched_instances.size(),
+				num_profiles,
+				Fuse::Util::vector_to_string(num_unmatched_per_profile),
+				Fuse::Util::vector_to_string(example_unmatched_labels));
 
-	std::vector<std::pair<int64_t,int64_t> > event_bounds;
-	for(auto event : overlapping_events){
-		event_bounds.push_back(statistics->get_bounds(event, symbol));
 	}
 
-	auto d_max = Fuse::Combination::bc_find_maximum_granularity(
-		instances_a,
-		instances_b,
-		overlapping_events,
-		event_bounds);
+	if(remove_combined_instances){
+		for(decltype(num_profiles) profile_idx = 0; profile_idx < num_profiles; profile_idx++){
 
-	spdlog::debug("Initial granularity for BC was {}.", d_max);
+			std::vector<Fuse::Instance_p> remaining_instances;
+			for(decltype(instances_per_profile.at(profile_idx).size()) instance_idx = 0;
+					instance_idx < instances_per_profile.at(profile_idx).size(); instance_idx++)
+				if(matched_per_profile.at(profile_idx)[instance_idx] == 0)
+					remaining_instances.push_back(instances_per_profile.at(profile_idx)[instance_idx]);
 
-	bool refining = true;
-	unsigned int g = d_max;
-	while(refining){
+			instances_per_profile.at(profile_idx) = remaining_instances;
 
-		auto clustered_instances_a = Fuse::Combination::bc_allocate_to_clusters(
-			instances_a,
-			overlapping_events,
-			event_bounds,
-			g);
+		}
+	}
+
+	return matched_instances;
+}
 
-		auto clustered_instances_b = Fuse::Combination::bc_allocate_to_clusters(
-			instances_b,
-			overlapping_events,
-			event_bounds,
-			g);
+/* Combines pairs of instance groups per symbol, running every (pair, symbol) job in parallel
+* The left group of each pair is the earlier part of the sequence, so the combined instances take its labels
+*/
+std::vector<std::map<Fuse::Symbol, std::vector<Fuse::Instance_p> > > combine_instance_groups_per_symbol(
+		std::vector<std::map<Fuse::Symbol, std::vector<Fuse::Instance_p> > >& groups,
+		std::vector<std::pair<unsigned int, unsigned int> > group_pairs,
+		std::vector<Fuse::Event_set> linking_events_per_pair,
+		std::vector<Fuse::Symbol> symbols,
+		Fuse::Strategy strategy,
+		Fuse::Statistics_p statistics,
+		Fuse::Combination_residuals* residuals
+		){
 
-		spdlog::trace("At granularity {}, there are {} clusters in a and {} clusters in b.",
-			g,
-			clustered_instances_a.size(),
-			clustered_instances_b.size());
+	unsigned int num_jobs = group_pairs.size() * symbols.size();
 
-		std::vector<Fuse::Instance_p> remove_from_a, remove_from_b;
+	// Gather each job's instances from both sides of the pair
+	std::vector<std::vector<std::vector<Fuse::Instance_p> > > instances_per_job;
+	instances_per_job.reserve(num_jobs);
 
-		// Go through one profile's set of clusters (we don't need to check both)
-		for(auto cluster_a_iter : clustered_instances_a){
+	for(auto group_pair : group_pairs){
+		for(auto symbol : symbols){
 
-			// Check if there are any instances of this cluster in the other profile
-			auto cluster_b_iter = clustered_instances_b.find(cluster_a_iter.first);
-			if(cluster_b_iter == clustered_instances_b.end())
-				continue;
+			std::vector<std::vector<Fuse::Instance_p> > instances_per_profile;
+			instances_per_profile.push_back(groups.at(group_pair.first)[symbol]);
+			instances_per_profile.push_back(groups.at(group_pair.second)[symbol]);
 
-			// We have cross-profile instances in the same cluster
-			auto cluster_instances_a = cluster_a_iter.second;
-			auto cluster_instances_b = cluster_b_iter->second;
+			instances_per_job.push_back(instances_per_profile);
 
-			std::vector<std::vector<Fuse::Instance_p> > instances_per_profile_within_cluster = {cluster_instances_a, cluster_instances_b};
-			auto within_cluster_matched_instances = extract_matched_instances_by_label(instances_per_profile_within_cluster, true, false);
+		}
+	}
 
-			matched_instances.insert(matched_instances.end(), within_cluster_matched_instances.begin(), within_cluster_matched_instances.end());
+	// Symbols are independent, and their instance counts are very uneven, so schedule the largest first
+	std::vector<unsigned int> schedule(num_jobs);
+	for(unsigned int job_idx = 0; job_idx < num_jobs; job_idx++)
+		schedule[job_idx] = job_idx;
 
-			// Now need to make sure that these instances are excluded from later clustering
-			// So save the ones that we have matched from each profile
-			remove_from_a.reserve(remove_from_a.size() + within_cluster_matched_instances.size());
-			remove_from_b.reserve(remove_from_b.size() + within_cluster_matched_instances.size());
-			for(auto match : within_cluster_matched_instances){
-				remove_from_a.push_back(match.at(0));
-				remove_from_b.push_back(match.at(1));
-			}
+	std::stable_sort(schedule.begin(), schedule.end(),
+		[&instances_per_job](unsigned int x, unsigned int y){
+			return (instances_per_job[x][0].size() + instances_per_job[x][1].size())
+				> (instances_per_job[y][0].size() + instances_per_job[y][1].size());
+		});
 
-		}
+	std::vector<std::vector<Fuse::Instance_p> > combined_instances_per_job(num_jobs);
+	std::vector<Fuse::Combination_residuals> residuals_per_job(num_jobs);
+	std::exception_ptr combination_exception = nullptr;
 
-		// Remove the newly combined instances for the next iteration
-		std::sort(remove_from_a.begin(), remove_from_a.end());
-		std::sort(remove_from_b.begin(), remove_from_b.end());
+	#pragma omp parallel for schedule(dynamic,1)
+	for(unsigned int schedule_idx = 0; schedule_idx < num_jobs; schedule_idx++){
 
-		std::vector<Fuse::Instance_p> remaining_instances_a, remaining_instances_b;
+		auto job_idx = schedule.at(schedule_idx);
+		auto pair_idx = job_idx / symbols.size();
+		auto symbol = symbols.at(job_idx % symbols.size());
+		auto& instances_per_profile = instances_per_job.at(job_idx);
 
-		std::set_difference(
-			instances_a.begin(), instances_a.end(),
-			remove_from_a.begin(), remove_from_a.end(),
-			std::back_inserter(remaining_instances_a));
+		spdlog::debug("Clustering instances of symbol [{}] ({}/{}).", symbol, schedule_idx + 1, num_jobs);
 
-		std::set_difference(
-			instances_b.begin(), instances_b.end(),
-			remove_from_b.begin(), remove_from_b.end(),
-			std::back_inserter(remaining_instances_b));
+		if(instances_per_profile.at(0).size() != instances_per_profile.at(1).size())
+			spdlog::debug("There are unequal number of instances ({} and {}) from the two profiles under {} combination.",
+				instances_per_profile.at(0).size(), instances_per_profile.at(1).size(), Fuse::convert_strategy_to_string(strategy));
+		else
+			spdlog::debug("Clustering {} instances from each profile via {}, for symbol {}.",
+				instances_per_profile.at(0).size(), Fuse::convert_strategy_to_string(strategy), symbol);
 
-		instances_a = remaining_instances_a;
-		instances_b = remaining_instances_b;
+		try {
 
-		// Relax the similarity constraint by reducing the granularity g
-		if(instances_a.size() == 0 || instances_b.size() == 0){
-			spdlog::debug("At final refinement with granularity {}, there are {} and {} instances remaining across the profiles.",
-				g, instances_a.size(), instances_b.size());
-			refining = false;
-			break;
-		}
+			combined_instances_per_job.at(job_idx) = Fuse::Combination::combine_instances_via_strategy(
+				instances_per_profile,
+				strategy,
+				statistics,
+				linking_events_per_pair.at(pair_idx),
+				&residuals_per_job.at(job_idx)
+			);
 
-		spdlog::debug("After clustering with granularity {}, there are {} and {} instances remaining across the profiles.",
-			g, instances_a.size(), instances_b.size());
-
-		g = Fuse::Combination::relax_similarity_constraint(g,
-			clustered_instances_a,
-			clustered_instances_b,
-			remove_from_a,
-			remove_from_b,
-			overlapping_events,
-			event_bounds
-		);
+		} catch(...){
+			#pragma omp critical (combination_exception)
+			combination_exception = std::current_exception();
+			continue;
+		}
 
-	}
+		if(instances_per_profile.at(0).size() > 0 || instances_per_profile.at(1).size() > 0)
+			spdlog::warn("There were uncombined instances for symbol '{}' remaining ({} and {}) after {} combination.",
+				symbol,
+				instances_per_profile.at(0).size(),
+				instances_per_profile.at(1).size(),
+				Fuse::convert_strategy_to_string(strategy)
+			);
 
-	if(remove_combined_instances){
-		instances_per_profile.at(0) = instances_a;
-		instances_per_profile.at(1) = instances_b;
 	}
 
-	return matched_instances;
+	if(combination_exception != nullptr)
+		std::rethrow_exception(combination_exception);
 
-}
+	if(residuals != nullptr)
+		for(auto& job_residuals : residuals_per_job)
+			Fuse::Combination::accumulate_residuals(*residuals, job_residuals);
 
-unsigned int Fuse::Combination::bc_find_maximum_granularity(
-		std::vector<Fuse::Instance_p> a,
-		std::vector<Fuse::Instance_p> b,
-		Fuse::Event_set overlapping_events,
-		std::vector<std::pair<int64_t,int64_t> > bounds
-		){
+	// Assemble the combined instances per symbol for each pair, in the original symbol order
+	std::vector<std::map<Fuse::Symbol, std::vector<Fuse::Instance_p> > > combined_groups(group_pairs.size());
+	for(unsigned int job_idx = 0; job_idx < num_jobs; job_idx++)
+		combined_groups.at(job_idx / symbols.size()).insert(
+			std::make_pair(symbols.at(job_idx % symbols.size()), combined_instances_per_job.at(job_idx)));
 
-	unsigned int granularity = std::numeric_limits<unsigned int>::max();
+	return combined_groups;
 
-	for(auto event_iter = overlapping_events.begin(); event_iter < overlapping_events.end(); event_iter++){
+}
 
-		std::vector<int64_t> values_a, values_b;
-		values_a.reserve(a.size());
-		values_b.reserve(b.size());
+std::vector<Fuse::Instance_p> Fuse::Combination::generate_combined_instances_bc(
+		std::vector<Fuse::Profile_p> sequence_profiles,
+		Fuse::Strategy strategy,
+		Fuse::Statistics_p statistics,
+		std::vector<Fuse::Event_set> overlapping_per_profile,
+		Fuse::Combination_residuals* residuals
+	){
 
-		bool error = false;
-		for(auto instance : a)
-			values_a.push_back(instance->get_event_value(*event_iter, error));
-		for(auto instance : b)
-			values_b.push_back(instance->get_event_value(*event_iter, error));
+	std::vector<Fuse::Instance_p> resulting_instances;
 
-		std::sort(values_a.begin(), values_a.end());
-		std::sort(values_b.begin(), values_b.end());
+	auto symbols = sequence_profiles.at(0)->get_unique_symbols(false);
 
-		if(values_a.size() == 1 || values_b.size() == 1)
-			return 1;
+	// Each group is a contiguous run of sequence parts that have already been combined
+	std::vector<std::map<Fuse::Symbol, std::vector<Fuse::Instance_p> > > groups;
+	std::vector<std::set<Fuse::Event> > events_per_group;
+	std::vector<unsigned int> first_part_per_group;
 
-		// Iterate over the sorted values, to find the minimum difference
-		uint64_t minimum_difference = std::numeric_limits<uint64_t>::max();
-		unsigned int a_idx = 0, b_idx = 0;
+	for(decltype(sequence_profiles.size()) part_idx = 0; part_idx < sequence_profiles.size(); part_idx++){
 
-		while(a_idx < values_a.size() && b_idx < values_b.size()){
+		auto profile = sequence_profiles.at(part_idx);
 
-			int64_t difference = values_a.at(a_idx) - values_b.at(b_idx);
-			uint64_t abs_difference = std::abs(difference);
+		std::map<Fuse::Symbol, std::vector<Fuse::Instance_p> > instances_per_symbol;
+		for(auto symbol : symbols){
+			std::vector<Fuse::Symbol> symbol_list = {symbol};
+			instances_per_symbol.insert(std::make_pair(symbol, profile->get_instances(false, symbol_list)));
+		}
 
-			if(abs_difference < minimum_difference)
-				minimum_difference = abs_difference;
+		auto profile_events = profile->get_unique_events();
 
-			if(difference < 0)
-				a_idx++; // value_b is greater than value_a, so increment a_idx to get closer to b
-			else
-				b_idx++; // value_b is lesser or equal to value_a, so increment b_idx to get closer to a
+		groups.push_back(instances_per_symbol);
+		events_per_group.push_back(std::set<Fuse::Event>(profile_events.begin(), profile_events.end()));
+		first_part_per_group.push_back(part_idx);
 
-		}
+	}
 
-		if(minimum_difference == 0)
-			return 1;
+	while(groups.size() > 1){
 
-		auto event_idx = event_iter - overlapping_events.begin();
-		unsigned int num_cells_for_minimum_difference =
-			(bounds.at(event_idx).second - bounds.at(event_idx).first) / minimum_difference;
+		// Chaining combines the accumulated group with the next part, one step at a time
+		// Tree reduction pairs up adjacent groups whenever the right group's linking events were measured in the left group
+		std::vector<std::pair<unsigned int, unsigned int> > group_pairs;
+		std::vector<Fuse::Event_set> linking_events_per_pair;
+		std::vector<bool> merged_at_group(groups.size(), false);
 
-		// We require no more than this many cells to match the closest two instances in this dimension
-		// There's no point using any more than this number of cells
-		// So save the minimum 'max num cells' across the dimensions
+		unsigned int group_idx = 0;
+		while(group_idx + 1 < groups.size()){
 
-		if(num_cells_for_minimum_difference < granularity)
-			granularity = num_cells_for_minimum_difference;
+			auto linking_events = overlapping_per_profile.at(first_part_per_group.at(group_idx+1));
 
-	}
+			bool linkable = linking_events.size() > 0;
+			for(auto event : linking_events)
+				if(events_per_group.at(group_idx).count(event) == 0)
+					linkable = false;
 
-	return granularity;
+			// The first two groups are always linkable, as every part's overlapping events were measured in an earlier part
+			if(linkable || group_idx == 0){
 
-}
+				spdlog::info("Running {} combination of the parts from {} to incorporate the parts from {} ({}) using overlapping events {}.",
+					Fuse::convert_strategy_to_string(strategy),
+					first_part_per_group.at(group_idx),
+					first_part_per_group.at(group_idx+1),
+					sequence_profiles.at(first_part_per_group.at(group_idx+1))->get_tracefile_name(),
+					Fuse::Util::vector_to_string(linking_events)
+				);
 
-std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > Fuse::Combination::bc_allocate_to_clusters(
-		std::vector<Fuse::Instance_p> instances,
-		Fuse::Event_set overlapping_events,
-		std::vector<std::pair<int64_t,int64_t> > bounds,
-		unsigned int granularity
-		){
+				group_pairs.push_back(std::make_pair(group_idx, group_idx+1));
+				linking_events_per_pair.push_back(linking_events);
+				merged_at_group.at(group_idx) = true;
+				group_idx += 2;
 
-	// A cluster is represented by a vector of cluster indexes
-	// Each cluster maps to the instances that populate it
-	std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > clustered_instances;
+			} else {
+				group_idx++;
+			}
 
-	if(granularity == 1){
-		// Simply add all instances to one cluster
-		std::vector<unsigned int> cluster = {0};
-		clustered_instances.insert(std::make_pair(cluster, instances));
-		return clustered_instances;
-	}
+			if(Fuse::Config::bc_tree_combination == false)
+				break;
 
-	// Alloate each instance to its cluster
-	for(auto instance : instances){
+		}
 
-		std::vector<unsigned int> cluster;
+		auto combined_groups = combine_instance_groups_per_symbol(
+			groups,
+			group_pairs,
+			linking_events_per_pair,
+			symbols,
+			strategy,
+			statistics,
+			residuals
+		);
 
-		for(unsigned int event_idx = 0; event_idx < overlapping_events.size(); event_idx++){
+		// Replace each combined pair by its result, carrying over the groups that were not paired at this level
+		std::vector<std::map<Fuse::Symbol, std::vector<Fuse::Instance_p> > > next_groups;
+		std::vector<std::set<Fuse::Event> > next_events_per_group;
+		std::vector<unsigned int> next_first_part_per_group;
 
-			int64_t minimum = bounds.at(event_idx).first;
-			int64_t maximum = bounds.at(event_idx).second;
+		unsigned int pair_idx = 0;
+		for(group_idx = 0; group_idx < groups.size(); group_idx++){
 
-			if(minimum == maximum){
-				cluster.push_back(0);
-				continue;
-			}
+			next_first_part_per_group.push_back(first_part_per_group.at(group_idx));
 
-			bool error = false;
-			int64_t value = instance->get_event_value(overlapping_events.at(event_idx), error);
+			if(merged_at_group.at(group_idx)){
 
-			unsigned int dim_coord = (((double) (value - minimum) / (maximum - minimum))) * granularity;
+				auto merged_events = events_per_group.at(group_idx);
+				merged_events.insert(events_per_group.at(group_idx+1).begin(), events_per_group.at(group_idx+1).end());
 
-			// I don't want the instance with the maximum value being in its own cluster
-			if(value == maximum && dim_coord > 0)
-				dim_coord--;
+				next_groups.push_back(combined_groups.at(pair_idx++));
+				next_events_per_group.push_back(merged_events);
+				group_idx++;
 
-			cluster.push_back(dim_coord);
+			} else {
 
-		}
+				next_groups.push_back(groups.at(group_idx));
+				next_events_per_group.push_back(events_per_group.at(group_idx));
 
-		// Now add the instance to this cluster
+			}
 
-		auto cluster_iter = clustered_instances.find(cluster);
-		if(cluster_iter == clustered_instances.end()){
-			std::vector<Fuse::Instance_p> new_cluster_instances = {instance};
-			clustered_instances.insert(std::make_pair(cluster, new_cluster_instances));
-		} else {
-			cluster_iter->second.push_back(instance);
 		}
 
+		groups = next_groups;
+		events_per_group = next_events_per_group;
+		first_part_per_group = next_first_part_per_group;
+
 	}
 
-	return clustered_instances;
+	// The final combined instances per symbol are the results of the final combination, so aggregate them
+	for(auto symbol_instances : groups.at(0))
+		resulting_instances.insert(resulting_instances.end(), symbol_instances.second.begin(), symbol_instances.second.end());
 
+	return resulting_instances;
 }
 
-std::vector<std::pair<std::vector<unsigned int>,std::vector<unsigned int> > > get_closest_clusters(
-		std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > clustered_instances_a,
-		std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > clustered_instances_b,
-		std::vector<Fuse::Instance_p> already_combined_a,
-		std::vector<Fuse::Instance_p> already_combined_b
+/* Incremental refinement state for BC combination of two per-symbol instance lists
+* The overlapping event values are extracted once, and matched instances are tombstoned rather than removed
+* Each granularity only allocates the live instances to cells, and only cells that still hold live instances
+* after matching are considered when relaxing the similarity constraint
+*/
+class Bc_refinement_grid {
+
+	public:
+
+		Bc_refinement_grid(
+			std::vector<Fuse::Instance_p> instances_a,
+			std::vector<Fuse::Instance_p> instances_b,
+			Fuse::Event_set overlapping_events,
+			std::vector<std::pair<int64_t,int64_t> > event_bounds
+		);
+
+		void allocate_to_cells(unsigned int granularity);
+		unsigned int match_within_cells(std::vector<std::vector<Fuse::Instance_p> >& matched_instances);
+		double find_minimum_pairwise_bin_distance(unsigned int granularity);
+
+		unsigned int get_num_cells();
+		unsigned int get_num_live(unsigned int profile_idx);
+		std::vector<Fuse::Instance_p> get_live_instances(unsigned int profile_idx);
+
+	private:
+
+		unsigned int num_dimensions;
+		std::vector<std::pair<int64_t,int64_t> > bounds;
+
+		// Per profile: instances in label order, their flattened overlapping event values, tombstones and live indexes
+		std::vector<Fuse::Instance_p> instances[2];
+		std::vector<int64_t> values[2];
+		std::vector<char> combined[2];
+		std::vector<unsigned int> live[2];
+
+		// Cells populated at the current granularity, with per-profile members stored contiguously per cell
+		std::vector<unsigned int> cell_coords;
+		std::unordered_map<uint64_t, unsigned int> cell_by_hash;
+		std::vector<unsigned int> cell_hash_collision;
+		std::vector<unsigned int> cell_offsets[2];
+		std::vector<unsigned int> cell_members[2];
+		std::vector<unsigned int> cell_live_counts[2];
+
+		// Cells that still contain live instances after matching
+		std::vector<unsigned int> occupied_cells[2];
+
+		unsigned int find_or_create_cell(const std::vector<unsigned int>& coords);
+
+};
+
+Bc_refinement_grid::Bc_refinement_grid(
+		std::vector<Fuse::Instance_p> instances_a,
+		std::vector<Fuse::Instance_p> instances_b,
+		Fuse::Event_set overlapping_events,
+		std::vector<std::pair<int64_t,int64_t> > event_bounds
 		){
 
-	// There may be multiple clusters at the same euclidean distance
-	std::vector<std::pair<std::vector<unsigned int>,std::vector<unsigned int> > > closest_cluster_coordinates;
+	num_dimensions = overlapping_events.size();
+	bounds = event_bounds;
 
-	std::vector<std::vector<unsigned int> > all_cluster_coords;
-	for(auto cluster : clustered_instances_a)
-		all_cluster_coords.push_back(cluster.first);
-	for(auto cluster : clustered_instances_b)
-		all_cluster_coords.push_back(cluster.first);
+	instances[0] = instances_a;
+	instances[1] = instances_b;
 
-	double minimum_squared_distance = std::numeric_limits<double>::max();
+	for(unsigned int profile_idx = 0; profile_idx < 2; profile_idx++){
 
-	for(decltype(all_cluster_coords.size()) i = 0; i < all_cluster_coords.size(); i++){
-		for(decltype(all_cluster_coords.size()) j = i+1; j < all_cluster_coords.size(); j++){
-			// Find the euclidean distance between these clusters
+		// Sorting by label once means that every cell's members are in label order when allocated in live order
+		std::stable_sort(instances[profile_idx].begin(), instances[profile_idx].end(), Fuse::comp_instances_by_label_dfs);
 
-			double squared_euclidean_distance = 0.0;
-			for(decltype(all_cluster_coords.size()) k = 0; k < all_cluster_coords.at(i).size(); k++)
-				squared_euclidean_distance += std::pow(std::fabs(all_cluster_coords.at(i).at(k)-all_cluster_coords.at(j).at(k)),2);
+		auto num_instances = instances[profile_idx].size();
 
-			bool should_add = false;
-			if(squared_euclidean_distance <= minimum_squared_distance){
+		values[profile_idx].reserve(num_instances * num_dimensions);
+		for(auto instance : instances[profile_idx]){
+			bool error = false;
+			for(auto event : overlapping_events)
+				values[profile_idx].push_back(instance->get_event_value(event, error));
+		}
 
-				auto cluster_a_iter = clustered_instances_a.find(all_cluster_coords.at(i));
-				auto cluster_b_iter = clustered_instances_b.find(all_cluster_coords.at(j));
+		combined[profile_idx].assign(num_instances, 0);
 
-				if(cluster_a_iter != clustered_instances_a.end() && cluster_b_iter != clustered_instances_b.end()){
+		live[profile_idx].resize(num_instances);
+		for(unsigned int instance_idx = 0; instance_idx < num_instances; instance_idx++)
+			live[profile_idx][instance_idx] = instance_idx;
 
-					std::vector<Fuse::Instance_p> non_merged_a, non_merged_b;
+	}
 
-					// There are some in both! Check they haven't been merged?
-					std::set_difference(
-						cluster_a_iter->second.begin(), cluster_a_iter->second.end(),
-						already_combined_a.begin(), already_combined_a.end(),
-						std::back_inserter(non_merged_a));
+}
 
-					std::set_difference(
-						cluster_b_iter->second.begin(), cluster_b_iter->second.end(),
-						already_combined_b.begin(), already_combined_b.end(),
-						std::back_inserter(non_merged_b));
+unsigned int Bc_refinement_grid::find_or_create_cell(const std::vector<unsigned int>& coords){
 
-					if(non_merged_a.size() > 0 && non_merged_b.size() > 0){
-						should_add = true;
-					}
+	// FNV-1a over the cell coordinates
+	uint64_t hash = 14695981039346656037ULL;
+	for(auto coord : coords){
+		hash ^= coord;
+		hash *= 1099511628211ULL;
+	}
 
-				}
+	unsigned int num_cells = cell_coords.size() / std::max(num_dimensions, 1u);
 
-				if(should_add == false){
-					// Check the other way around
+	auto hash_iter = cell_by_hash.find(hash);
+	if(hash_iter != cell_by_hash.end()){
 
-					cluster_a_iter = clustered_instances_a.find(all_cluster_coords.at(j));
-					cluster_b_iter = clustered_instances_b.find(all_cluster_coords.at(i));
+		unsigned int cell_idx = hash_iter->second;
+		while(true){
 
-					if(cluster_a_iter != clustered_instances_a.end() && cluster_b_iter != clustered_instances_b.end()){
+			if(std::equal(coords.begin(), coords.end(), cell_coords.begin() + cell_idx * num_dimensions))
+				return cell_idx;
 
-						std::vector<Fuse::Instance_p> non_merged_a, non_merged_b;
+			if(cell_hash_collision.at(cell_idx) == std::numeric_limits<unsigned int>::max())
+				break;
 
-						// There are some in both! Check they haven't been merged?
-						std::set_difference(
-							cluster_a_iter->second.begin(), cluster_a_iter->second.end(),
-							already_combined_a.begin(), already_combined_a.end(),
-							std::back_inserter(non_merged_a));
+			cell_idx = cell_hash_collision.at(cell_idx);
+		}
 
-						std::set_difference(
-							cluster_b_iter->second.begin(), cluster_b_iter->second.end(),
-							already_combined_b.begin(), already_combined_b.end(),
-							std::back_inserter(non_merged_b));
+		cell_hash_collision.at(cell_idx) = num_cells;
 
-						if(non_merged_a.size() > 0 && non_merged_b.size() > 0){
-							should_add = true;
-						}
+	} else {
+		cell_by_hash.insert(std::make_pair(hash, num_cells));
+	}
 
+	cell_coords.insert(cell_coords.end(), coords.begin(), coords.end());
+	cell_hash_collision.push_back(std::numeric_limits<unsigned int>::max());
+
+	return num_cells;
+
+}
+
+void Bc_refinement_grid::allocate_to_cells(unsigned int granularity){
+
+	cell_coords.clear();
+	cell_by_hash.clear();
+	cell_hash_collision.clear();
+
+	std::vector<unsigned int> cell_of_live[2];
+	std::vector<unsigned int> coords(num_dimensions, 0);
+
+	for(unsigned int profile_idx = 0; profile_idx < 2; profile_idx++){
+
+		cell_of_live[profile_idx].reserve(live[profile_idx].size());
+
+		for(auto instance_idx : live[profile_idx]){
+
+			// At granularity 1, all instances share a single cluster
+			if(granularity > 1){
+				for(unsigned int event_idx = 0; event_idx < num_dimensions; event_idx++){
+
+					int64_t minimum = bounds.at(event_idx).first;
+					int64_t maximum = bounds.at(event_idx).second;
+
+					if(minimum == maximum){
+						coords[event_idx] = 0;
+						continue;
 					}
+
+					int64_t value = values[profile_idx][instance_idx * num_dimensions + event_idx];
+
+					unsigned int dim_coord = (((double) (value - minimum) / (maximum - minimum))) * granularity;
+
+					// I don't want the instance with the maximum value being in its own cluster
+					if(value == maximum && dim_coord > 0)
+						dim_coord--;
+
+					coords[event_idx] = dim_coord;
+
 				}
 			}
 
-			if(should_add == false)
-				continue;
+			cell_of_live[profile_idx].push_back(find_or_create_cell(coords));
 
-			if(squared_euclidean_distance < minimum_squared_distance){
-				minimum_squared_distance = squared_euclidean_distance;
-				closest_cluster_coordinates.clear();
-			}
+		}
+	}
+
+	unsigned int num_cells = get_num_cells();
+
+	// Counting sort of the live instances into their cells, which keeps each cell's members in label order
+	for(unsigned int profile_idx = 0; profile_idx < 2; profile_idx++){
 
-			auto pair = std::make_pair(all_cluster_coords.at(i),all_cluster_coords.at(j));
-			closest_cluster_coordinates.push_back(pair);
+		cell_live_counts[profile_idx].assign(num_cells, 0);
+		for(auto cell_idx : cell_of_live[profile_idx])
+			cell_live_counts[profile_idx][cell_idx]++;
 
+		cell_offsets[profile_idx].assign(num_cells + 1, 0);
+		for(unsigned int cell_idx = 0; cell_idx < num_cells; cell_idx++)
+			cell_offsets[profile_idx][cell_idx+1] = cell_offsets[profile_idx][cell_idx] + cell_live_counts[profile_idx][cell_idx];
+
+		std::vector<unsigned int> insert_positions(cell_offsets[profile_idx].begin(), cell_offsets[profile_idx].end() - 1);
+		cell_members[profile_idx].resize(live[profile_idx].size());
+		for(decltype(live[profile_idx].size()) live_idx = 0; live_idx < live[profile_idx].size(); live_idx++){
+			auto cell_idx = cell_of_live[profile_idx][live_idx];
+			cell_members[profile_idx][insert_positions[cell_idx]++] = live[profile_idx][live_idx];
 		}
 
 	}
 
-	return closest_cluster_coordinates;
 }
 
+unsigned int Bc_refinement_grid::match_within_cells(std::vector<std::vector<Fuse::Instance_p> >& matched_instances){
 
-/* TODO Currently very inefficient!
-* At the moment, I find the pair of instances that are closest in euclidean distance
-* - I first find the closest pair of bins, by bin-distance, that have combinable instances
-*	- Then enumerate the instances of these bins
-* Then I find the largest single-dimension distance between these instances, and that's the span for the next bins
-*/
+	unsigned int num_matched = 0;
+	unsigned int num_cells = get_num_cells();
 
-double find_minimum_pairwise_distance_brute_force(
-		std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > clustered_instances_a,
-		std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > clustered_instances_b,
-		std::vector<Fuse::Instance_p> already_combined_a,
-		std::vector<Fuse::Instance_p> already_combined_b,
-		Fuse::Event_set overlapping_events,
-		std::vector<std::pair<int64_t,int64_t> > event_bounds,
-		unsigned int granularity
-		){
+	occupied_cells[0].clear();
+	occupied_cells[1].clear();
 
-	// Find the closest clusters that have combinable instances
-	auto closest_cluster_coordinates = get_closest_clusters(
-		clustered_instances_a,
-		clustered_instances_b,
-		already_combined_a,
-		already_combined_b
-	);
+	for(unsigned int cell_idx = 0; cell_idx < num_cells; cell_idx++){
 
-	double minimum_euclidean_squared_distance = std::numeric_limits<double>::max();
-	double closest_instances_largest_distance_in_single_event = 0;
+		unsigned int num_a = cell_live_counts[0][cell_idx];
+		unsigned int num_b = cell_live_counts[1][cell_idx];
 
-	for(auto cluster_pair : closest_cluster_coordinates){
+		if(num_a > 0 && num_b > 0){
 
-		std::vector<Fuse::Instance_p> all_instances_in_one, all_instances_in_two;
+			// Cross-profile instances in the same cell are matched in label order
+			unsigned int num_to_match = std::min(num_a, num_b);
+			for(unsigned int member_idx = 0; member_idx < num_to_match; member_idx++){
 
-		// Collect all the non-combined instances into a single list for each cluster pair
-		auto cluster_one = cluster_pair.first;
+				auto instance_idx_a = cell_members[0][cell_offsets[0][cell_idx] + member_idx];
+				auto instance_idx_b = cell_members[1][cell_offsets[1][cell_idx] + member_idx];
 
-		auto one_iter = clustered_instances_a.find(cluster_one);
-		if(one_iter != clustered_instances_a.end())
-			for(auto instance : one_iter->second){
-				if(std::find(already_combined_a.begin(), already_combined_a.end(), instance) == already_combined_a.end())
-					all_instances_in_one.push_back(instance);
-			}
-		one_iter = clustered_instances_b.find(cluster_one);
-		if(one_iter != clustered_instances_b.end())
-			for(auto instance : one_iter->second){
-				if(std::find(already_combined_b.begin(), already_combined_b.end(), instance) == already_combined_b.end())
-					all_instances_in_one.push_back(instance);
-			}
+				std::vector<Fuse::Instance_p> match = {instances[0][instance_idx_a], instances[1][instance_idx_b]};
+				matched_instances.push_back(match);
 
-		auto cluster_two = cluster_pair.second;
+				combined[0][instance_idx_a] = 1;
+				combined[1][instance_idx_b] = 1;
 
-		auto two_iter = clustered_instances_a.find(cluster_two);
-		if(two_iter != clustered_instances_a.end())
-			for(auto instance : two_iter->second){
-				if(std::find(already_combined_a.begin(), already_combined_a.end(), instance) == already_combined_a.end())
-					all_instances_in_two.push_back(instance);
 			}
-		two_iter = clustered_instances_b.find(cluster_two);
-		if(two_iter != clustered_instances_b.end())
-			for(auto instance : two_iter->second){
-				if(std::find(already_combined_b.begin(), already_combined_b.end(), instance) == already_combined_b.end())
-					all_instances_in_two.push_back(instance);
+
+			cell_live_counts[0][cell_idx] -= num_to_match;
+			cell_live_counts[1][cell_idx] -= num_to_match;
+			num_matched += num_to_match;
+
+		}
+
+		if(cell_live_counts[0][cell_idx] > 0)
+			occupied_cells[0].push_back(cell_idx);
+		if(cell_live_counts[1][cell_idx] > 0)
+			occupied_cells[1].push_back(cell_idx);
+
+	}
+
+	// Drop the tombstoned instances from the live lists, preserving label order
+	for(unsigned int profile_idx = 0; profile_idx < 2; profile_idx++){
+		auto& flags = combined[profile_idx];
+		live[profile_idx].erase(
+			std::remove_if(live[profile_idx].begin(), live[profile_idx].end(),
+				[&flags](unsigned int instance_idx){ return flags[instance_idx] != 0; }),
+			live[profile_idx].end());
+	}
+
+	return num_matched;
+
+}
+
+/* Find the pair of live cross-profile instances that are closest in euclidean distance
+* - First find the closest pairs of occupied cells, by cell distance, sweeping along the first dimension
+* - Then enumerate the live instances of these cells
+* Returns the largest single-dimension bin distance between these instances, which is the span for the next cells
+*/
+double Bc_refinement_grid::find_minimum_pairwise_bin_distance(unsigned int granularity){
+
+	std::vector<std::pair<unsigned int, unsigned int> > closest_cells;
+
+	if(occupied_cells[0].empty() || occupied_cells[1].empty())
+		return 0.0;
+
+	unsigned int cell_dimensions = std::max(num_dimensions, 1u);
+	auto& coords = cell_coords;
+
+	auto sorted_cells_b = occupied_cells[1];
+	std::sort(sorted_cells_b.begin(), sorted_cells_b.end(),
+		[&coords, cell_dimensions](unsigned int x, unsigned int y){
+			return coords[x * cell_dimensions] < coords[y * cell_dimensions];
+		});
+
+	double minimum_squared_distance = std::numeric_limits<double>::max();
+
+	for(auto cell_a : occupied_cells[0]){
+
+		double first_coord_a = coords[cell_a * cell_dimensions];
+
+		auto start = std::lower_bound(sorted_cells_b.begin(), sorted_cells_b.end(), coords[cell_a * cell_dimensions],
+			[&coords, cell_dimensions](unsigned int cell, unsigned int coord){
+				return coords[cell * cell_dimensions] < coord;
+			}) - sorted_cells_b.begin();
+
+		// Sweep outwards in both directions until the first dimension alone is further than the current minimum
+		for(int direction = 0; direction < 2; direction++){
+
+			long position = (direction == 0) ? start : start - 1;
+			long step = (direction == 0) ? 1 : -1;
+
+			for(; position >= 0 && position < (long) sorted_cells_b.size(); position += step){
+
+				auto cell_b = sorted_cells_b[position];
+
+				double first_dim_distance = first_coord_a - coords[cell_b * cell_dimensions];
+				if(first_dim_distance * first_dim_distance > minimum_squared_distance)
+					break;
+
+				double squared_distance = 0.0;
+				for(unsigned int k = 0; k < cell_dimensions; k++){
+					double distance = ((double) coords[cell_a * cell_dimensions + k]) - ((double) coords[cell_b * cell_dimensions + k]);
+					squared_distance += distance * distance;
+				}
+
+				if(squared_distance > minimum_squared_distance)
+					continue;
+
+				if(squared_distance < minimum_squared_distance){
+					minimum_squared_distance = squared_distance;
+					closest_cells.clear();
+				}
+
+				closest_cells.push_back(std::make_pair(cell_a, cell_b));
+
 			}
+		}
 
-		for(auto instance_one : all_instances_in_one){
-			for(auto instance_two : all_instances_in_two){
+	}
+
+	double minimum_euclidean_squared_distance = std::numeric_limits<double>::max();
+	double closest_instances_largest_distance_in_single_event = 0;
+
+	for(auto cell_pair : closest_cells){
+
+		auto begin_a = cell_members[0].begin() + cell_offsets[0][cell_pair.first];
+		auto end_a = cell_members[0].begin() + cell_offsets[0][cell_pair.first + 1];
+		auto begin_b = cell_members[1].begin() + cell_offsets[1][cell_pair.second];
+		auto end_b = cell_members[1].begin() + cell_offsets[1][cell_pair.second + 1];
+
+		for(auto a_iter = begin_a; a_iter != end_a; a_iter++){
+
+			if(combined[0][*a_iter])
+				continue;
+
+			for(auto b_iter = begin_b; b_iter != end_b; b_iter++){
+
+				if(combined[1][*b_iter])
+					continue;
 
-				bool error = false;
 				double squared_bin_euclidean_distance = 0.0;
 				double local_largest_distance_in_single_event = 0.0;
-				for(decltype(overlapping_events.size()) k = 0; k < overlapping_events.size(); k++){
+				for(unsigned int k = 0; k < num_dimensions; k++){
 
-					int64_t count_from_one = instance_one->get_event_value(overlapping_events.at(k),error);
-					int64_t count_from_two = instance_two->get_event_value(overlapping_events.at(k),error);
+					int64_t count_from_one = values[0][(*a_iter) * num_dimensions + k];
+					int64_t count_from_two = values[1][(*b_iter) * num_dimensions + k];
 
 					uint64_t difference = std::abs(((double) count_from_one) - ((double) count_from_two));
 
-					int64_t range = event_bounds.at(k).second - event_bounds.at(k).first;
+					int64_t range = bounds.at(k).second - bounds.at(k).first;
 
 					double bin_distance = ((double) difference) / (((double)(range)) / granularity);
 
-					if(bin_distance > local_largest_distance_in_single_event){
+					if(bin_distance > local_largest_distance_in_single_event)
 						local_largest_distance_in_single_event = bin_distance;
-					}
 
-					squared_bin_euclidean_distance += std::pow(bin_distance,2);
+					squared_bin_euclidean_distance += bin_distance * bin_distance;
 				}
 
 				if(squared_bin_euclidean_distance == minimum_euclidean_squared_distance){
-					if(local_largest_distance_in_single_event < closest_instances_largest_distance_in_single_event){
+					if(local_largest_distance_in_single_event < closest_instances_largest_distance_in_single_event)
 						closest_instances_largest_distance_in_single_event = local_largest_distance_in_single_event;
-					}
 				} else if(squared_bin_euclidean_distance < minimum_euclidean_squared_distance){
 					minimum_euclidean_squared_distance = squared_bin_euclidean_distance;
 					closest_instances_largest_distance_in_single_event = local_largest_distance_in_single_event;
@@ -903,27 +1200,185 @@ double find_minimum_pairwise_distance_brute_force(
 	}
 
 	return closest_instances_largest_distance_in_single_event;
+
 }
 
-unsigned int Fuse::Combination::relax_similarity_constraint(
-		unsigned int current_granularity,
-		std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > clustered_instances_a,
-		std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > clustered_instances_b,
-		std::vector<Fuse::Instance_p> already_combined_a,
-		std::vector<Fuse::Instance_p> already_combined_b,
+unsigned int Bc_refinement_grid::get_num_cells(){
+	return cell_coords.size() / std::max(num_dimensions, 1u);
+}
+
+unsigned int Bc_refinement_grid::get_num_live(unsigned int profile_idx){
+	return live[profile_idx].size();
+}
+
+std::vector<Fuse::Instance_p> Bc_refinement_grid::get_live_instances(unsigned int profile_idx){
+
+	std::vector<Fuse::Instance_p> live_instances;
+	live_instances.reserve(live[profile_idx].size());
+
+	for(auto instance_idx : live[profile_idx])
+		live_instances.push_back(instances[profile_idx][instance_idx]);
+
+	return live_instances;
+
+}
+
+/* Assume I have already filtered instances to per-symbol */
+std::vector<std::vector<Fuse::Instance_p> > Fuse::Combination::extract_matched_instances_bc(
+		std::vector<std::vector<Fuse::Instance_p> >& instances_per_profile,
+		bool remove_combined_instances,
+		Fuse::Statistics_p statistics,
 		Fuse::Event_set overlapping_events,
-		std::vector<std::pair<int64_t,int64_t> > event_bounds
+		std::vector<unsigned int>* match_granularities
 		){
 
-	double minimum_bin_distance = find_minimum_pairwise_distance_brute_force(
-		clustered_instances_a,
-		clustered_instances_b,
-		already_combined_a,
-		already_combined_b,
+	std::vector<std::vector<Fuse::Instance_p> > matched_instances;
+
+	if(instances_per_profile.size() != 2)
+		throw std::logic_error(fmt::format("BC combination strategy can only combine two profiles at a time, but {} were provided.",
+			instances_per_profile.size()));
+
+	if(statistics == nullptr)
+		throw std::logic_error("BC combination strategy requires event statistics, but none were provided.");
+
+	if(overlapping_events.size() == 0)
+		throw std::runtime_error("BC combination strategy requires overlapping events between profiles, but none were provided.");
+
+	auto instances_a = instances_per_profile.at(0);
+	auto instances_b = instances_per_profile.at(1);
+
+	if(instances_a.size() == 0 || instances_b.size() == 0)
+		return matched_instances;
+
+	Fuse::Symbol symbol = instances_a.at(0)->symbol;
+
+	std::vector<std::pair<int64_t,int64_t> > event_bounds;
+	for(auto event : overlapping_events){
+		event_bounds.push_back(statistics->get_bounds(event, symbol));
+	}
+
+	auto d_max = Fuse::Combination::bc_find_maximum_granularity(
+		instances_a,
+		instances_b,
 		overlapping_events,
-		event_bounds,
-		current_granularity
-	);
+		event_bounds);
+
+	spdlog::debug("Initial granularity for BC was {}.", d_max);
+
+	matched_instances.reserve(std::min(instances_a.size(), instances_b.size()));
+
+	Bc_refinement_grid grid(instances_a, instances_b, overlapping_events, event_bounds);
+
+	unsigned int g = d_max;
+	while(true){
+
+		grid.allocate_to_cells(g);
+
+		auto num_matched = grid.match_within_cells(matched_instances);
+
+		if(match_granularities != nullptr)
+			match_granularities->insert(match_granularities->end(), num_matched, g);
+
+		spdlog::trace("At granularity {}, there were {} populated cells and {} new matches.",
+			g,
+			grid.get_num_cells(),
+			num_matched);
+
+		// Relax the similarity constraint by reducing the granularity g
+		if(grid.get_num_live(0) == 0 || grid.get_num_live(1) == 0){
+			spdlog::debug("At final refinement with granularity {}, there are {} and {} instances remaining across the profiles.",
+				g, grid.get_num_live(0), grid.get_num_live(1));
+			break;
+		}
+
+		spdlog::debug("After clustering with granularity {}, there are {} and {} instances remaining across the profiles.",
+			g, grid.get_num_live(0), grid.get_num_live(1));
+
+		double minimum_bin_distance = grid.find_minimum_pairwise_bin_distance(g);
+
+		g = Fuse::Combination::bc_relax_granularity(g, minimum_bin_distance);
+
+	}
+
+	if(remove_combined_instances){
+		instances_per_profile.at(0) = grid.get_live_instances(0);
+		instances_per_profile.at(1) = grid.get_live_instances(1);
+	}
+
+	return matched_instances;
+
+}
+
+unsigned int Fuse::Combination::bc_find_maximum_granularity(
+		std::vector<Fuse::Instance_p> a,
+		std::vector<Fuse::Instance_p> b,
+		Fuse::Event_set overlapping_events,
+		std::vector<std::pair<int64_t,int64_t> > bounds
+		){
+
+	unsigned int granularity = std::numeric_limits<unsigned int>::max();
+
+	for(auto event_iter = overlapping_events.begin(); event_iter < overlapping_events.end(); event_iter++){
+
+		std::vector<int64_t> values_a, values_b;
+		values_a.reserve(a.size());
+		values_b.reserve(b.size());
+
+		bool error = false;
+		for(auto instance : a)
+			values_a.push_back(instance->get_event_value(*event_iter, error));
+		for(auto instance : b)
+			values_b.push_back(instance->get_event_value(*event_iter, error));
+
+		std::sort(values_a.begin(), values_a.end());
+		std::sort(values_b.begin(), values_b.end());
+
+		if(values_a.size() == 1 || values_b.size() == 1)
+			return 1;
+
+		// Iterate over the sorted values, to find the minimum difference
+		uint64_t minimum_difference = std::numeric_limits<uint64_t>::max();
+		unsigned int a_idx = 0, b_idx = 0;
+
+		while(a_idx < values_a.size() && b_idx < values_b.size()){
+
+			int64_t difference = values_a.at(a_idx) - values_b.at(b_idx);
+			uint64_t abs_difference = std::abs(difference);
+
+			if(abs_difference < minimum_difference)
+				minimum_difference = abs_difference;
+
+			if(difference < 0)
+				a_idx++; // value_b is greater than value_a, so increment a_idx to get closer to b
+			else
+				b_idx++; // value_b is lesser or equal to value_a, so increment b_idx to get closer to a
+
+		}
+
+		if(minimum_difference == 0)
+			return 1;
+
+		auto event_idx = event_iter - overlapping_events.begin();
+		unsigned int num_cells_for_minimum_difference =
+			(bounds.at(event_idx).second - bounds.at(event_idx).first) / minimum_difference;
+
+		// We require no more than this many cells to match the closest two instances in this dimension
+		// There's no point using any more than this number of cells
+		// So save the minimum 'max num cells' across the dimensions
+
+		if(num_cells_for_minimum_difference < granularity)
+			granularity = num_cells_for_minimum_difference;
+
+	}
+
+	return granularity;
+
+}
+
+unsigned int Fuse::Combination::bc_relax_granularity(
+		unsigned int current_granularity,
+		double minimum_bin_distance
+		){
 
 	unsigned int next_granularity = std::ceil(((double) ((double) 1.0/(1.0+minimum_bin_distance))) * current_granularity);
 
@@ -940,3 +1395,428 @@ unsigned int Fuse::Combination::relax_similarity_constraint(
 
 }
 
+
+/* Flattened linking event values of each instance, scaled by the event bounds so that each event spans [0,1] */
+std::vector<double> get_normalised_linking_values(
+		const std::vector<Fuse::Instance_p>& instances,
+		const Fuse::Event_set& overlapping_events,
+		const std::vector<std::pair<int64_t,int64_t> >& event_bounds
+		){
+
+	std::vector<double> values;
+	values.reserve(instances.size() * overlapping_events.size());
+
+	for(auto instance : instances){
+		for(decltype(overlapping_events.size()) event_idx = 0; event_idx < overlapping_events.size(); event_idx++){
+
+			bool error = false;
+			auto value = instance->get_event_value(overlapping_events.at(event_idx), error);
+
+			auto bounds = event_bounds.at(event_idx);
+			double range = static_cast<double>(bounds.second - bounds.first);
+
+			if(range > 0.0)
+				values.push_back(static_cast<double>(value - bounds.first) / range);
+			else
+				values.push_back(0.0);
+
+		}
+	}
+
+	return values;
+
+}
+
+/* Finds the k nearest objects of each bidder, returning the candidate objects and their euclidean distances
+* Objects are sorted along the first dimension, and each bidder sweeps outwards from its own position
+* Taking the closer side each step means the first-dimension gap only grows, so the sweep stops once it exceeds the k-th distance
+*/
+void find_nearest_candidates(
+		const std::vector<double>& bidder_values,
+		const std::vector<double>& object_values,
+		unsigned int num_dimensions,
+		unsigned int num_candidates,
+		std::vector<unsigned int>& candidates,
+		std::vector<double>& candidate_costs
+		){
+
+	long num_bidders = bidder_values.size() / num_dimensions;
+	long num_objects = object_values.size() / num_dimensions;
+
+	std::vector<unsigned int> object_order(num_objects);
+	std::iota(object_order.begin(), object_order.end(), 0);
+	std::stable_sort(object_order.begin(), object_order.end(),
+		[&object_values, num_dimensions](unsigned int x, unsigned int y){
+			return object_values[static_cast<size_t>(x)*num_dimensions] < object_values[static_cast<size_t>(y)*num_dimensions];
+		});
+
+	std::vector<double> sorted_first_values(num_objects);
+	for(long sorted_idx = 0; sorted_idx < num_objects; sorted_idx++)
+		sorted_first_values[sorted_idx] = object_values[static_cast<size_t>(object_order[sorted_idx])*num_dimensions];
+
+	candidates.resize(static_cast<size_t>(num_bidders) * num_candidates);
+	candidate_costs.resize(static_cast<size_t>(num_bidders) * num_candidates);
+
+	#pragma omp parallel for schedule(dynamic,64)
+	for(long bidder = 0; bidder < num_bidders; bidder++){
+
+		const double* point = &bidder_values[static_cast<size_t>(bidder)*num_dimensions];
+
+		// Max-heap of (squared distance, object), so ties are broken by object index
+		std::vector<std::pair<double, unsigned int> > nearest;
+		nearest.reserve(num_candidates);
+
+		long right = std::lower_bound(sorted_first_values.begin(), sorted_first_values.end(), point[0]) - sorted_first_values.begin();
+		long left = right - 1;
+
+		while(left >= 0 || right < num_objects){
+
+			bool take_right = (left < 0) || (right < num_objects
+				&& (sorted_first_values[right] - point[0]) <= (point[0] - sorted_first_values[left]));
+
+			long sorted_idx = take_right ? right++ : left--;
+
+			double first_gap = sorted_first_values[sorted_idx] - point[0];
+			if(nearest.size() == num_candidates && first_gap*first_gap > nearest.front().first)
+				break;
+
+			auto object = object_order[sorted_idx];
+			const double* other = &object_values[static_cast<size_t>(object)*num_dimensions];
+
+			double distance = 0.0;
+			for(unsigned int dim_idx = 0; dim_idx < num_dimensions; dim_idx++)
+				distance += (point[dim_idx] - other[dim_idx]) * (point[dim_idx] - other[dim_idx]);
+
+			auto candidate = std::make_pair(distance, object);
+			if(nearest.size() < num_candidates){
+				nearest.push_back(candidate);
+				std::push_heap(nearest.begin(), nearest.end());
+			} else if(candidate < nearest.front()){
+				std::pop_heap(nearest.begin(), nearest.end());
+				nearest.back() = candidate;
+				std::push_heap(nearest.begin(), nearest.end());
+			}
+
+		}
+
+		std::sort_heap(nearest.begin(), nearest.end());
+		for(unsigned int candidate_idx = 0; candidate_idx < num_candidates; candidate_idx++){
+			candidates[static_cast<size_t>(bidder)*num_candidates + candidate_idx] = nearest[candidate_idx].second;
+			candidate_costs[static_cast<size_t>(bidder)*num_candidates + candidate_idx] = std::sqrt(nearest[candidate_idx].first);
+		}
+
+	}
+
+}
+
+/* Epsilon-scaled Jacobi auction over a sparse candidate graph, minimising the total cost of the assignment
+* Returns the assigned object of each bidder, or -1 if the bidder preferred to stay unassigned at the reservation cost
+* Each round computes the bids of all unassigned bidders in parallel, then resolves them in bidder order
+*/
+std::vector<int> solve_sparse_auction(
+		unsigned int num_bidders,
+		unsigned int num_objects,
+		unsigned int num_candidates,
+		const std::vector<unsigned int>& candidates,
+		const std::vector<double>& candidate_costs,
+		unsigned int& num_phases,
+		unsigned long& num_rounds
+		){
+
+	const int unassigned = -1;
+	const int reserved = -2;
+
+	double max_cost = 0.0;
+	for(auto cost : candidate_costs)
+		max_cost = std::max(max_cost, cost);
+
+	// Paying more than the reservation cost for an object is worse than staying unassigned
+	double reservation_cost = 2.0 * max_cost + 1.0;
+	double final_epsilon = std::max(Fuse::Config::auction_epsilon, std::numeric_limits<double>::epsilon());
+	double epsilon = std::max(final_epsilon, reservation_cost / 4.0);
+
+	// Prices are only carried between phases when every object must be assigned
+	// Otherwise, objects left unassigned with stale prices would break the epsilon-optimality of the final phase
+	if(num_bidders != num_objects)
+		epsilon = final_epsilon;
+
+	std::vector<double> prices(num_objects, 0.0);
+	std::vector<int> owners(num_objects);
+	std::vector<int> assignments(num_bidders);
+
+	std::vector<int> bid_objects(num_bidders);
+	std::vector<double> bid_prices(num_bidders);
+	std::vector<int> best_bidders(num_objects, unassigned);
+	std::vector<double> best_bid_prices(num_objects);
+
+	num_phases = 0;
+	num_rounds = 0;
+
+	while(true){
+
+		std::fill(owners.begin(), owners.end(), unassigned);
+		std::fill(assignments.begin(), assignments.end(), unassigned);
+
+		std::vector<unsigned int> bidding(num_bidders);
+		std::iota(bidding.begin(), bidding.end(), 0);
+
+		while(bidding.size() > 0){
+
+			num_rounds++;
+			long num_bidding = bidding.size();
+
+			#pragma omp parallel for schedule(static)
+			for(long bidding_idx = 0; bidding_idx < num_bidding; bidding_idx++){
+
+				auto bidder = bidding[bidding_idx];
+
+				int best_object = reserved;
+				double best_value = -reservation_cost;
+				double second_value = -std::numeric_limits<double>::infinity();
+
+				for(unsigned int candidate_idx = 0; candidate_idx < num_candidates; candidate_idx++){
+
+					auto object = candidates[static_cast<size_t>(bidder)*num_candidates + candidate_idx];
+					double value = -candidate_costs[static_cast<size_t>(bidder)*num_candidates + candidate_idx] - prices[object];
+
+					if(value > best_value){
+						second_value = best_value;
+						best_value = value;
+						best_object = object;
+					} else if(value > second_value){
+						second_value = value;
+					}
+
+				}
+
+				bid_objects[bidder] = best_object;
+				if(best_object != reserved)
+					bid_prices[bidder] = prices[best_object] + (best_value - second_value) + epsilon;
+
+			}
+
+			// Resolve the bids in bidder order, so that equal bids are won deterministically
+			std::vector<unsigned int> objects_bid_upon;
+			for(auto bidder : bidding){
+
+				auto object = bid_objects[bidder];
+				if(object == reserved){
+					assignments[bidder] = reserved;
+					continue;
+				}
+
+				if(best_bidders[object] == unassigned){
+					objects_bid_upon.push_back(object);
+					best_bidders[object] = bidder;
+					best_bid_prices[object] = bid_prices[bidder];
+				} else if(bid_prices[bidder] > best_bid_prices[object]){
+					best_bidders[object] = bidder;
+					best_bid_prices[object] = bid_prices[bidder];
+				}
+
+			}
+
+			std::vector<unsigned int> next_bidding;
+			for(auto object : objects_bid_upon){
+
+				if(owners[object] != unassigned){
+					assignments[owners[object]] = unassigned;
+					next_bidding.push_back(owners[object]);
+				}
+
+				owners[object] = best_bidders[object];
+				assignments[best_bidders[object]] = object;
+				prices[object] = best_bid_prices[object];
+				best_bidders[object] = unassigned;
+
+			}
+
+			for(auto bidder : bidding)
+				if(assignments[bidder] == unassigned)
+					next_bidding.push_back(bidder);
+
+			std::sort(next_bidding.begin(), next_bidding.end());
+			bidding.swap(next_bidding);
+
+		}
+
+		num_phases++;
+
+		if(epsilon <= final_epsilon)
+			break;
+
+		epsilon = std::max(final_epsilon, epsilon / 5.0);
+
+	}
+
+	for(auto& assignment : assignments)
+		if(assignment == reserved)
+			assignment = unassigned;
+
+	return assignments;
+
+}
+
+/* Assume I have already filtered instances to per-symbol
+* The cost of matching two instances is the euclidean distance between their normalised linking event values
+* The smaller side bids for its nearest neighbours on the other side via an auction
+* Bidders that the sparse candidates could not assign are auctioned again against the unassigned objects, until no more are assigned
+* Any instances still unassigned are then paired in label order
+*/
+std::vector<std::vector<Fuse::Instance_p> > Fuse::Combination::extract_matched_instances_auction(
+		std::vector<std::vector<Fuse::Instance_p> >& instances_per_profile,
+		bool remove_combined_instances,
+		Fuse::Statistics_p statistics,
+		Fuse::Event_set overlapping_events
+		){
+
+	std::vector<std::vector<Fuse::Instance_p> > matched_instances;
+
+	if(instances_per_profile.size() != 2)
+		throw std::logic_error(fmt::format("Auction combination strategy can only combine two profiles at a time, but {} were provided.",
+			instances_per_profile.size()));
+
+	if(statistics == nullptr)
+		throw std::logic_error("Auction combination strategy requires event statistics, but none were provided.");
+
+	if(overlapping_events.size() == 0)
+		throw std::runtime_error("Auction combination strategy requires overlapping events between profiles, but none were provided.");
+
+	auto instances_a = instances_per_profile.at(0);
+	auto instances_b = instances_per_profile.at(1);
+
+	if(instances_a.size() == 0 || instances_b.size() == 0)
+		return matched_instances;
+
+	std::stable_sort(instances_a.begin(), instances_a.end(), Fuse::comp_instances_by_label_dfs);
+	std::stable_sort(instances_b.begin(), instances_b.end(), Fuse::comp_instances_by_label_dfs);
+
+	Fuse::Symbol symbol = instances_a.at(0)->symbol;
+
+	std::vector<std::pair<int64_t,int64_t> > event_bounds;
+	for(auto event : overlapping_events)
+		event_bounds.push_back(statistics->get_bounds(event, symbol));
+
+	unsigned int num_dimensions = overlapping_events.size();
+
+	auto values_a = get_normalised_linking_values(instances_a, overlapping_events, event_bounds);
+	auto values_b = get_normalised_linking_values(instances_b, overlapping_events, event_bounds);
+
+	// The instance indexes of each profile that are not yet matched
+	std::vector<unsigned int> remaining_a(instances_a.size());
+	std::vector<unsigned int> remaining_b(instances_b.size());
+	std::iota(remaining_a.begin(), remaining_a.end(), 0);
+	std::iota(remaining_b.begin(), remaining_b.end(), 0);
+
+	std::vector<int> match_per_a(instances_a.size(), -1);
+
+	unsigned int num_auctions = 0;
+	unsigned int num_phases = 0;
+	unsigned long num_rounds = 0;
+
+	while(remaining_a.size() > 0 && remaining_b.size() > 0){
+
+		// The smaller side bids, so that every bidder can be assigned an object
+		bool a_bids = remaining_a.size() <= remaining_b.size();
+		auto& bidder_indexes = a_bids ? remaining_a : remaining_b;
+		auto& object_indexes = a_bids ? remaining_b : remaining_a;
+		auto& all_bidder_values = a_bids ? values_a : values_b;
+		auto& all_object_values = a_bids ? values_b : values_a;
+
+		std::vector<double> bidder_values;
+		std::vector<double> object_values;
+		bidder_values.reserve(bidder_indexes.size() * num_dimensions);
+		object_values.reserve(object_indexes.size() * num_dimensions);
+
+		for(auto instance_idx : bidder_indexes)
+			bidder_values.insert(bidder_values.end(),
+				all_bidder_values.begin() + static_cast<size_t>(instance_idx)*num_dimensions,
+				all_bidder_values.begin() + static_cast<size_t>(instance_idx+1)*num_dimensions);
+
+		for(auto instance_idx : object_indexes)
+			object_values.insert(object_values.end(),
+				all_object_values.begin() + static_cast<size_t>(instance_idx)*num_dimensions,
+				all_object_values.begin() + static_cast<size_t>(instance_idx+1)*num_dimensions);
+
+		unsigned int num_bidders = bidder_indexes.size();
+		unsigned int num_objects = object_indexes.size();
+		unsigned int num_candidates = std::min(std::max(Fuse::Config::auction_num_candidates, 1u), num_objects);
+
+		std::vector<unsigned int> candidates;
+		std::vector<double> candidate_costs;
+		find_nearest_candidates(bidder_values, object_values, num_dimensions, num_candidates, candidates, candidate_costs);
+
+		unsigned int auction_phases = 0;
+		unsigned long auction_rounds = 0;
+		auto assignments = solve_sparse_auction(num_bidders, num_objects, num_candidates, candidates, candidate_costs,
+			auction_phases, auction_rounds);
+
+		num_auctions++;
+		num_phases += auction_phases;
+		num_rounds += auction_rounds;
+
+		unsigned int num_assigned = 0;
+		for(unsigned int bidder = 0; bidder < num_bidders; bidder++){
+			if(assignments[bidder] < 0)
+				continue;
+
+			auto a_idx = a_bids ? bidder_indexes[bidder] : object_indexes[assignments[bidder]];
+			auto b_idx = a_bids ? object_indexes[assignments[bidder]] : bidder_indexes[bidder];
+			match_per_a[a_idx] = b_idx;
+			num_assigned++;
+		}
+
+		spdlog::trace("Auction {} for symbol {} assigned {} of {} bidders to their nearest {} candidates.",
+			num_auctions, symbol, num_assigned, num_bidders, num_candidates);
+
+		if(num_assigned == 0)
+			break;
+
+		std::vector<char> matched_b(instances_b.size(), 0);
+		for(auto b_idx : match_per_a)
+			if(b_idx >= 0)
+				matched_b[b_idx] = 1;
+
+		remaining_a.erase(std::remove_if(remaining_a.begin(), remaining_a.end(),
+			[&match_per_a](unsigned int a_idx){ return match_per_a[a_idx] >= 0; }), remaining_a.end());
+		remaining_b.erase(std::remove_if(remaining_b.begin(), remaining_b.end(),
+			[&matched_b](unsigned int b_idx){ return matched_b[b_idx] != 0; }), remaining_b.end());
+
+	}
+
+	// Extract the matches in the label order of the first profile, then pair any leftovers in label order
+	matched_instances.reserve(std::min(instances_a.size(), instances_b.size()));
+	for(decltype(instances_a.size()) a_idx = 0; a_idx < instances_a.size(); a_idx++){
+		if(match_per_a[a_idx] >= 0){
+			std::vector<Fuse::Instance_p> match = {instances_a[a_idx], instances_b[match_per_a[a_idx]]};
+			matched_instances.push_back(match);
+		}
+	}
+
+	auto num_leftover_matches = std::min(remaining_a.size(), remaining_b.size());
+	for(decltype(num_leftover_matches) leftover_idx = 0; leftover_idx < num_leftover_matches; leftover_idx++){
+		std::vector<Fuse::Instance_p> match = {instances_a[remaining_a[leftover_idx]], instances_b[remaining_b[leftover_idx]]};
+		matched_instances.push_back(match);
+	}
+
+	spdlog::debug("Auction combination for symbol {} ran {} auctions over {} phases and {} rounds, then paired {} leftovers in label order.",
+		symbol, num_auctions, num_phases, num_rounds, num_leftover_matches);
+
+	if(remove_combined_instances){
+
+		std::vector<Fuse::Instance_p> uncombined_a;
+		std::vector<Fuse::Instance_p> uncombined_b;
+
+		for(auto leftover_idx = num_leftover_matches; leftover_idx < remaining_a.size(); leftover_idx++)
+			uncombined_a.push_back(instances_a[remaining_a[leftover_idx]]);
+		for(auto leftover_idx = num_leftover_matches; leftover_idx < remaining_b.size(); leftover_idx++)
+			uncombined_b.push_back(instances_b[remaining_b[leftover_idx]]);
+
+		instances_per_profile.at(0) = uncombined_a;
+		instances_per_profile.at(1) = uncombined_b;
+
+	}
+
+	return matched_instances;
+
+}
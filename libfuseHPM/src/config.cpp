@@ -9,3 +9,22 @@ bool Fuse::Config::lazy_load_references = false;
 unsigned int Fuse::Config::tmd_bin_count = 10;
 bool Fuse::Config::calculate_per_workfunction_tmds = true;
 bool Fuse::Config::weighted_tmd = true;
+Fuse::Tmd_solver Fuse::Config::tmd_solver = Fuse::Tmd_solver::TRANSPORT_SIMPLEX;
+Fuse::Tmd_solver Fuse::Config::sequence_generator_tmd_solver = Fuse::Tmd_solver::TRANSPORT_SIMPLEX;
+bool Fuse::Config::sequence_generator_tmd_bounds = true;
+double Fuse::Config::sinkhorn_epsilon = 0.02;
+double Fuse::Config::sinkhorn_tolerance = 1e-3;
+unsigned int Fuse::Config::sinkhorn_max_iterations = 1000;
+bool Fuse::Config::bc_tree_combination = false;
+unsigned int Fuse::Config::combination_memory_budget_mb = 0;
+bool Fuse::Config::persist_reference_signatures = true;
+bool Fuse::Config::adaptive_calibration = false;
+double Fuse::Config::calibration_tolerance = 0.05;
+unsigned int Fuse::Config::calibration_min_combinations = 10;
+bool Fuse::Config::build_reference_pyramids = false;
+bool Fuse::Config::cache_accuracy_results = true;
+unsigned int Fuse::Config::epd_bootstrap_replicates = 0;
+double Fuse::Config::epd_bootstrap_confidence = 0.95;
+unsigned int Fuse::Config::reference_pyramid_max_level = 6;
+unsigned int Fuse::Config::auction_num_candidates = 8;
+double Fuse::Config::auction_epsilon = 1e-4;
@@ -7,15 +7,23 @@
 #include "instance.h"
 #include "statistics.h"
 #include "sequence_generator.h"
+#include "transport.h"
 
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/basic_file_sink.h"
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <limits>
 #include <numeric>
 #include <ctime>
 #include <iostream>
 #include <iomanip>
+#include <random>
 #include <string>
 #include <sstream>
 
@@ -192,15 +200,193 @@ void Fuse::execute_references(
 		reference_sets.size(),
 		target.get_num_reference_repeats());
 
+	// Pyramids are only used for power-of-two bin counts, so are not worth building otherwise
+	unsigned int bin_count = Fuse::Config::tmd_bin_count;
+	bool pyramids_usable = bin_count > 0 && (bin_count & (bin_count - 1)) == 0
+		&& bin_count <= (1u << Fuse::Config::reference_pyramid_max_level);
+
+	// Only the new repeats, or those whose bounds the new repeats have widened, are (re)built
+	if(Fuse::Config::build_reference_pyramids && pyramids_usable)
+		Fuse::build_reference_pyramids(target);
+
+}
+
+/* Executes the sequence repeats, folding each part into a running combination per strategy as soon as it is loaded
+* The folds run as tasks while the next part executes, so each repeat's combined profiles are ready shortly after its final part
+* Consumed parts are not kept by the target, so their memory is released once they have been folded in
+*/
+void execute_and_stream_sequence_repeats(
+		Fuse::Target& target,
+		unsigned int number_of_repeats,
+		bool minimal,
+		bool keep_in_memory,
+		std::vector<Fuse::Strategy> streaming_strategies
+		){
+
+	auto minimal_str = minimal ? "minimal" : "non_minimal";
+	spdlog::info("Executing {} repeats of the {} sequence profiles, combining each part via strategies {} as it completes.",
+		number_of_repeats, minimal_str, Fuse::Util::vector_to_string(streaming_strategies));
+
+	auto sequence = target.get_sequence(minimal);
+	if(sequence.size() < 1)
+		throw std::runtime_error(
+			fmt::format("No {} sequence has been defined in the target JSON, so cannot execute the sequence profiles.", minimal_str));
+
+	std::vector<Fuse::Strategy> strategies;
+	for(auto strategy : streaming_strategies){
+		if(strategy == Fuse::Strategy::HEM)
+			spdlog::info("Cannot combine sequence profiles via HEM. Ignoring this strategy.");
+		else
+			strategies.push_back(strategy);
+	}
+
+	bool requires_bounds = std::find(strategies.begin(), strategies.end(), Fuse::Strategy::BC) != strategies.end()
+		|| std::find(strategies.begin(), strategies.end(), Fuse::Strategy::AUCTION) != strategies.end();
+
+	unsigned int current_idx = target.get_num_sequence_repeats(minimal);
+
+	// The running combined profile of each strategy, also used as the task dependency token for its folds
+	std::vector<Fuse::Profile_p> running_profiles(strategies.size());
+	Fuse::Profile_p* running = running_profiles.data();
+
+	std::exception_ptr streaming_exception = nullptr;
+
+	#pragma omp parallel
+	#pragma omp single
+	{
+		for(unsigned int instance_idx = current_idx; instance_idx < (current_idx+number_of_repeats); instance_idx++){
+
+			spdlog::debug("Executing sequence profiles for repeat index {}.", instance_idx);
+
+			try {
+
+				for(auto part : sequence){
+
+					std::stringstream ss;
+					ss << target.get_tracefiles_directory() << "/" << minimal_str << "_";
+					ss << "sequence_profile_" << instance_idx << "-" << part.part_idx << ".ost";
+					auto tracefile = ss.str();
+
+					Fuse::Event_set profiled_events = part.unique;
+					profiled_events.insert(profiled_events.end(), part.overlapping.begin(), part.overlapping.end());
+
+					Fuse::Profile_p execution_profile = Fuse::Profiling::execute_and_load(
+						target.get_filtered_events(),
+						target.get_target_runtime(),
+						target.get_target_binary(),
+						target.get_target_args(),
+						tracefile,
+						profiled_events,
+						target.get_should_clear_cache()
+					);
+
+					// Add the event statistics, and refresh the bounds if a strategy clusters on them
+					Fuse::add_profile_event_values_to_statistics(execution_profile, target.get_statistics());
+					if(requires_bounds)
+						target.get_statistics()->calculate_statistics_from_running();
+
+					// The folds of this part use its linking event bounds as of now, rather than when each fold happens to run
+					// Otherwise the bounds of a delayed fold would include the values of later parts
+					Fuse::Statistics_p part_statistics = target.get_statistics();
+					if(requires_bounds)
+						part_statistics = part_statistics->snapshot_events(part.overlapping);
+
+					for(unsigned int strategy_idx = 0; strategy_idx < strategies.size(); strategy_idx++){
+
+						if(part.part_idx == sequence.front().part_idx){
+							running[strategy_idx] = execution_profile;
+							continue;
+						}
+
+						auto strategy = strategies.at(strategy_idx);
+						auto combined_filename = target.get_combination_filename(strategy, instance_idx);
+
+						#pragma omp task depend(inout: running[strategy_idx]) firstprivate(part_statistics)
+						{
+							try {
+
+								std::vector<Fuse::Event_set> overlapping_events;
+								if(strategy == Fuse::Strategy::BC || strategy == Fuse::Strategy::AUCTION)
+									overlapping_events = {Fuse::Event_set(), part.overlapping};
+
+								std::vector<Fuse::Profile_p> profiles_to_fold = {running[strategy_idx], execution_profile};
+
+								running[strategy_idx] = Fuse::Combination::combine_profiles_via_strategy(
+									profiles_to_fold,
+									strategy,
+									combined_filename,
+									target.get_target_binary(),
+									overlapping_events,
+									part_statistics
+								);
+
+								spdlog::debug("Folded part {} of repeat index {} into its combination via strategy {}.",
+									part.part_idx, instance_idx, Fuse::convert_strategy_to_string(strategy));
+
+							} catch(...){
+								#pragma omp critical (combination_exception)
+								streaming_exception = std::current_exception();
+							}
+						}
+
+					}
+
+				}
+
+			} catch(...){
+				#pragma omp critical (combination_exception)
+				streaming_exception = std::current_exception();
+			}
+
+			#pragma omp taskwait
+
+			if(streaming_exception != nullptr)
+				break;
+
+			for(unsigned int strategy_idx = 0; strategy_idx < strategies.size(); strategy_idx++){
+
+				target.register_new_combined_profile(strategies.at(strategy_idx), instance_idx, running[strategy_idx]);
+
+				if(keep_in_memory)
+					target.store_combined_profile(instance_idx, strategies.at(strategy_idx), running[strategy_idx]);
+
+				running[strategy_idx] = nullptr;
+
+			}
+
+			target.increment_num_sequence_repeats(minimal);
+
+			spdlog::info("Finished executing and combining repeat index {} of the {} sequence profiles.", instance_idx, minimal_str);
+
+		}
+	}
+
+	if(streaming_exception != nullptr)
+		std::rethrow_exception(streaming_exception);
+
+	target.save();
+
+	spdlog::info("Finished executing {} {} sequence profiles. Target now has {} {} sequence profiles.",
+		number_of_repeats,
+		minimal_str,
+		target.get_num_sequence_repeats(minimal),
+		minimal_str);
+
 }
 
 void Fuse::execute_sequence_repeats(
 		Fuse::Target& target,
 		unsigned int number_of_repeats,
 		bool minimal,
-		bool keep_in_memory
+		bool keep_in_memory,
+		std::vector<Fuse::Strategy> streaming_strategies
 		){
 
+	if(streaming_strategies.size() > 0){
+		execute_and_stream_sequence_repeats(target, number_of_repeats, minimal, keep_in_memory, streaming_strategies);
+		return;
+	}
+
 	auto minimal_str = minimal ? "minimal" : "non_minimal";
 	spdlog::info("Executing {} repeats of the {} sequence profiles.", number_of_repeats, minimal_str);
 
@@ -307,6 +493,44 @@ void Fuse::execute_hem_repeats(
 
 }
 
+/* Approximate in-memory size of a loaded profile, where each instance holds a map of its event values */
+uint64_t estimate_profile_footprint(Fuse::Profile_p profile){
+
+	const uint64_t bytes_per_event_value = 80;
+
+	uint64_t num_instances = profile->get_num_instances(true);
+	uint64_t num_events = profile->get_unique_events().size();
+
+	return num_instances * (sizeof(Fuse::Instance) + num_events * bytes_per_event_value);
+
+}
+
+/* Trace parsing is not thread-safe, so all loading is serialised under the same lock as the sequence generator's */
+std::vector<Fuse::Profile_p> load_sequence_profiles_serially(
+		Fuse::Target& target,
+		unsigned int repeat_idx,
+		bool minimal
+		){
+
+	std::vector<Fuse::Profile_p> sequence_profiles;
+	std::exception_ptr loading_exception = nullptr;
+
+	#pragma omp critical (loading)
+	{
+		try {
+			sequence_profiles = target.load_and_retrieve_sequence_profiles(repeat_idx, minimal);
+		} catch(...){
+			loading_exception = std::current_exception();
+		}
+	}
+
+	if(loading_exception != nullptr)
+		std::rethrow_exception(loading_exception);
+
+	return sequence_profiles;
+
+}
+
 void Fuse::combine_sequence_repeats(
 		Fuse::Target& target,
 		std::vector<Fuse::Strategy> strategies,
@@ -321,17 +545,20 @@ void Fuse::combine_sequence_repeats(
 		Fuse::Util::vector_to_string(repeat_indexes),
 		minimal_str);
 
-	for(auto repeat_idx : repeat_indexes){
+	if(std::find(strategies.begin(), strategies.end(), Fuse::Strategy::HEM) != strategies.end())
+		spdlog::info("Cannot combine sequence profiles via HEM. Ignoring this strategy.");
 
-		spdlog::debug("Getting {} sequence profiles for repeat index {}.", minimal_str, repeat_idx);
-		std::vector<Fuse::Profile_p> sequence_profiles = target.load_and_retrieve_sequence_profiles(repeat_idx, minimal);
+	// Determine the outstanding work up front, so that only the repeats requiring combination are loaded
+	std::vector<unsigned int> outstanding_repeats;
+	std::vector<std::vector<Fuse::Strategy> > strategies_per_repeat;
 
+	for(auto repeat_idx : repeat_indexes){
+
+		std::vector<Fuse::Strategy> outstanding_strategies;
 		for(auto strategy : strategies){
 
-			if(strategy == Fuse::Strategy::HEM){
-				spdlog::info("Cannot combine sequence profiles via HEM. Ignoring this strategy.");
+			if(strategy == Fuse::Strategy::HEM)
 				continue;
-			}
 
 			// Check if we have already combined this repeat index with this strategy
 			if(target.combined_profile_exists(strategy, repeat_idx)){
@@ -339,271 +566,1831 @@ void Fuse::combine_sequence_repeats(
 				continue;
 			}
 
-			spdlog::info("Combining sequence profiles for repeat index {} via strategy {}.", repeat_idx, Fuse::convert_strategy_to_string(strategy));
-
-			std::vector<Fuse::Event_set> overlapping_events;
-			if(strategy == Fuse::Strategy::BC){
-				Fuse::Combination_sequence bc_sequence = target.get_sequence(minimal);
-				for(auto part : bc_sequence)
-					overlapping_events.push_back(part.overlapping);
-			}
-
-			Fuse::Profile_p combined_profile = Fuse::Combination::combine_profiles_via_strategy(
-				sequence_profiles,
-				strategy,
-				target.get_combination_filename(strategy, repeat_idx),
-				target.get_target_binary(),
-				overlapping_events,
-				target.get_statistics()
-			);
-
-			target.register_new_combined_profile(strategy, repeat_idx, combined_profile);
+			// Creates the strategy's combination directory before anything runs concurrently
+			target.get_combination_filename(strategy, repeat_idx);
 
-			if(keep_in_memory)
-				target.store_combined_profile(repeat_idx, strategy, combined_profile);
+			outstanding_strategies.push_back(strategy);
 
-			spdlog::info("Finished combining the sequence profiles for repeat index {} via strategy {}.", repeat_idx, Fuse::convert_strategy_to_string(strategy));
+		}
 
+		if(outstanding_strategies.size() > 0){
+			outstanding_repeats.push_back(repeat_idx);
+			strategies_per_repeat.push_back(outstanding_strategies);
 		}
 
-		target.save();
+	}
 
+	if(outstanding_repeats.size() == 0){
+		spdlog::info("Completed all requested combinations.");
+		return;
 	}
 
-	spdlog::info("Completed all requested combinations.");
+	unsigned int num_outstanding = outstanding_repeats.size();
+	std::vector<std::vector<Fuse::Profile_p> > profiles_per_repeat(num_outstanding);
 
-}
+	// Loading the first repeat up front resolves the sequence (which may be generated) and sizes the memory window
+	spdlog::debug("Getting {} sequence profiles for repeat index {}.", minimal_str, outstanding_repeats.front());
+	profiles_per_repeat.front() = target.load_and_retrieve_sequence_profiles(outstanding_repeats.front(), minimal);
 
+	std::vector<Fuse::Event_set> bc_overlapping_events;
+	for(auto part : target.get_sequence(minimal))
+		bc_overlapping_events.push_back(part.overlapping);
 
-void Fuse::analyse_sequence_combinations(
-		Fuse::Target& target,
-		std::vector<Fuse::Strategy> strategies,
-		std::vector<unsigned int> repeat_indexes,
-		Fuse::Accuracy_metric metric){
+	// The window is the number of repeats that may be resident at once
+	unsigned int window = num_outstanding;
+	if(Fuse::Config::combination_memory_budget_mb > 0){
 
-	if(Fuse::Config::lazy_load_references == false)
-		target.load_reference_distributions();
+		uint64_t footprint = 0;
+		for(auto profile : profiles_per_repeat.front())
+			footprint += estimate_profile_footprint(profile);
 
-	auto reference_pairs = target.get_reference_pairs();
+		// Each combined profile is about as large as the sequence profiles it was combined from
+		footprint *= (1 + strategies_per_repeat.front().size());
 
-	std::vector<unsigned int> reference_repeats_list(target.get_num_reference_repeats());
-	std::iota(reference_repeats_list.begin(), reference_repeats_list.end(), 0);
+		uint64_t budget = static_cast<uint64_t>(Fuse::Config::combination_memory_budget_mb) * 1024 * 1024;
+		window = std::max<uint64_t>(1, std::min<uint64_t>(num_outstanding, budget / std::max<uint64_t>(footprint, 1)));
+
+		spdlog::info("Each repeat requires approximately {} MB, so up to {} repeats will be combined concurrently within the {} MB memory budget.",
+			footprint / (1024 * 1024), window, Fuse::Config::combination_memory_budget_mb);
 
-	std::vector<Fuse::Symbol> symbols = {"all_symbols"};
-	if(Fuse::Config::calculate_per_workfunction_tmds){
-		auto all_symbols = target.get_statistics()->get_unique_symbols(false);
-		symbols.insert(symbols.end(), all_symbols.begin(), all_symbols.end());
 	}
 
-	unsigned int strategy_idx = 0;
-	for(auto strategy : strategies){
+	// Task dependency tokens: a repeat's combinations depend on its load, and a repeat is only loaded once
+	// the repeat 'window' positions before it has been released
+	// The tokens are addressed through data() as depend clauses need pointer-based array elements
+	std::vector<char> loaded_tokens(num_outstanding), released_tokens(num_outstanding);
+
+	std::exception_ptr combination_exception = nullptr;
+
+	#pragma omp parallel
+	#pragma omp single
+	{
+		for(unsigned int position = 0; position < num_outstanding; position++){
+
+			auto repeat_idx = outstanding_repeats.at(position);
+
+			// Loads are serialised, but prefetch the next repeats while the earlier ones are being combined
+			#pragma omp task depend(out: loaded_tokens.data()[position]) depend(in: released_tokens.data()[position < window ? position : position - window])
+			{
+				try {
+					if(position > 0){
+						spdlog::debug("Getting {} sequence profiles for repeat index {}.", minimal_str, repeat_idx);
+						profiles_per_repeat.at(position) = load_sequence_profiles_serially(target, repeat_idx, minimal);
+					}
+				} catch(...){
+					#pragma omp critical (combination_exception)
+					combination_exception = std::current_exception();
+				}
+			}
 
-		for(auto repeat_idx : repeat_indexes){ // Combined profile repeats, we report value for each
+			for(auto strategy : strategies_per_repeat.at(position)){
 
-			spdlog::info("Calculating {} accuracy for combination repeat {}/{} by strategy {} ({}/{}).",
-				Fuse::convert_metric_to_string(metric),
-				repeat_idx,
-				repeat_indexes.size()-1,
-				Fuse::convert_strategy_to_string(strategy),
-				strategy_idx,
-				strategies.size()-1
-			);
+				#pragma omp task depend(in: loaded_tokens.data()[position])
+				{
+					try {
 
-			auto profile = target.get_or_load_combined_profile(strategy, repeat_idx);
+						spdlog::info("Combining sequence profiles for repeat index {} via strategy {}.", repeat_idx, Fuse::convert_strategy_to_string(strategy));
 
-			std::map<unsigned int, double> tmd_per_reference_pair;
+						std::vector<Fuse::Event_set> overlapping_events;
+						if(strategy == Fuse::Strategy::BC || strategy == Fuse::Strategy::AUCTION)
+							overlapping_events = bc_overlapping_events;
 
-			unsigned int pair_idx = 0;
-			for(auto reference_pair : reference_pairs){
+						Fuse::Profile_p combined_profile = Fuse::Combination::combine_profiles_via_strategy(
+							profiles_per_repeat.at(position),
+							strategy,
+							target.get_combination_filename(strategy, repeat_idx),
+							target.get_target_binary(),
+							overlapping_events,
+							target.get_statistics()
+						);
 
-				/* I will get a list of uncalibrated tmds for each symbol for each reference repeat
-				*  Then I'll average these, so we have one average tmd per symbol across the reference repeats
-				*  Then I'll calibrate these to the per-symbol calibration tmds
-				*  Then I'll do a weighted average across the symbols, to give a final TMD value for this pair
-				*/
+						target.register_new_combined_profile(strategy, repeat_idx, combined_profile);
 
-				double calibrated_tmd_wrt_pair = Fuse::Analysis::calculate_calibrated_tmd_for_pair(
-					target,
-					symbols,
-					reference_pair,
-					profile,
-					reference_repeats_list,
-					Fuse::Config::tmd_bin_count,
-					Fuse::Config::weighted_tmd);
-
-				tmd_per_reference_pair.insert(std::make_pair(pair_idx, calibrated_tmd_wrt_pair));
-				pair_idx++;
-			}
+						if(keep_in_memory)
+							target.store_combined_profile(repeat_idx, strategy, combined_profile);
+
+						spdlog::info("Finished combining the sequence profiles for repeat index {} via strategy {}.", repeat_idx, Fuse::convert_strategy_to_string(strategy));
+
+					} catch(...){
+						#pragma omp critical (combination_exception)
+						combination_exception = std::current_exception();
+					}
+				}
 
-			// Calculate the overall epd
-			std::vector<double> tmds;
-			tmds.reserve(tmd_per_reference_pair.size());
-			for(auto pair_result : tmd_per_reference_pair){
-				tmds.push_back(pair_result.second);
 			}
-			double epd = Fuse::calculate_weighted_geometric_mean(tmds);
 
-			spdlog::info("Overall {} of {} repeat {} is: {}.",
-				Fuse::convert_metric_to_string(metric),
-				Fuse::convert_strategy_to_string(strategy),
-				repeat_idx,
-				epd
-			);
+			// Runs once all of this repeat's combinations have completed
+			#pragma omp task depend(inout: loaded_tokens.data()[position]) depend(out: released_tokens.data()[position])
+			{
+				try {
 
-			target.save_accuracy_results_to_disk(metric, strategy, repeat_idx, epd, tmd_per_reference_pair);
+					profiles_per_repeat.at(position).clear();
+					if(Fuse::Config::combination_memory_budget_mb > 0)
+						target.release_sequence_profiles(repeat_idx, minimal);
 
-		}
+					target.save();
+
+				} catch(...){
+					#pragma omp critical (combination_exception)
+					combination_exception = std::current_exception();
+				}
+			}
 
+		}
 	}
 
-	spdlog::info("Finished analysing the accuracy of the combined profiles.");
+	// Each release saves the target as it progresses, but the final save is what guarantees that every registration is on disk
+	target.save();
+
+	if(combination_exception != nullptr)
+		std::rethrow_exception(combination_exception);
+
+	spdlog::info("Completed all requested combinations.");
 
 }
 
-void Fuse::generate_bc_sequence(
-		Fuse::Target& target
+void Fuse::benchmark_combination_strategies(
+		Fuse::Target& target,
+		std::vector<Fuse::Strategy> strategies,
+		std::vector<unsigned int> repeat_indexes,
+		bool minimal
 		){
 
-	std::vector<std::pair<Fuse::Event_set, Fuse::Event_set> > combination_sequence =
-		Fuse::Sequence_generator::generate_bc_sequence(target, 3, 3);
+	auto minimal_str = minimal ? "minimal" : "non_minimal";
 
-	// Convert to a proper combination sequence
-	Fuse::Combination_sequence sequence;
-	unsigned int next_part_idx = 0;
-	for(auto pair : combination_sequence){
+	std::vector<Fuse::Event_set> overlapping_events_per_part;
+	for(auto part : target.get_sequence(minimal))
+		overlapping_events_per_part.push_back(part.overlapping);
 
-		Fuse::Sequence_part part;
-		part.part_idx = next_part_idx;
-		part.overlapping = pair.first;
-		part.unique = pair.second;
+	for(auto repeat_idx : repeat_indexes){
 
-		sequence.push_back(part);
+		auto sequence_profiles = target.load_and_retrieve_sequence_profiles(repeat_idx, minimal);
 
-		next_part_idx++;
-	}
-	
-	target.set_combination_sequence(sequence);
+		unsigned long num_instances = 0;
+		for(auto profile : sequence_profiles)
+			num_instances += profile->get_instances(false).size();
 
-}
+		for(auto strategy : strategies){
 
-void Fuse::calculate_calibration_tmds(
-		Fuse::Target& target
-		){
+			if(strategy == Fuse::Strategy::HEM){
+				spdlog::info("Cannot benchmark the combination of sequence profiles via HEM. Ignoring this strategy.");
+				continue;
+			}
 
-	if(Fuse::Config::lazy_load_references == false)
-		target.load_reference_distributions();
+			std::vector<Fuse::Event_set> overlapping_events;
+			if(strategy == Fuse::Strategy::BC || strategy == Fuse::Strategy::AUCTION)
+				overlapping_events = overlapping_events_per_part;
 
-	auto reference_pairs = target.get_reference_pairs();
+			auto start = std::chrono::steady_clock::now();
 
-	std::vector<unsigned int> reference_repeats_list(target.get_num_reference_repeats());
-	std::iota(reference_repeats_list.begin(), reference_repeats_list.end(), 0);
-	auto reference_repeat_combinations = Fuse::Util::get_unique_combinations(reference_repeats_list, 2);
+			Fuse::Profile_p combined_profile = Fuse::Combination::combine_profiles_via_strategy(
+				sequence_profiles,
+				strategy,
+				target.get_combination_filename(strategy, repeat_idx),
+				target.get_target_binary(),
+				overlapping_events,
+				target.get_statistics()
+			);
 
-	spdlog::info("Calculating calibration TMDs for {} reference pairs and {} combinations of the reference repeats.",
-		reference_pairs.size(),
-		reference_repeat_combinations.size()
-	);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			double residual = Fuse::Combination::summarise_residuals(combined_profile->get_combination_residuals());
+
+			spdlog::info("Combined {} instances of the {} sequence profiles for repeat index {} via strategy {} in {} seconds ({} instances per second), with mean relative residual {}.",
+				num_instances,
+				minimal_str,
+				repeat_idx,
+				Fuse::convert_strategy_to_string(strategy),
+				seconds,
+				(seconds > 0.0 ? num_instances / seconds : 0.0),
+				residual);
+
+			target.save_combination_benchmark_to_disk(strategy, repeat_idx, num_instances, seconds, residual);
+
+		}
 
-	// We always get calibration TMDs for all symbols, and optionally for each individual symbol
-	std::vector<Fuse::Symbol> symbols = {"all_symbols"};
-	if(Fuse::Config::calculate_per_workfunction_tmds){
-		auto all_symbols = target.get_statistics()->get_unique_symbols(false);
-		symbols.insert(symbols.end(), all_symbols.begin(), all_symbols.end());
 	}
 
-	unsigned int pair_idx = 0;
-	for(auto reference_pair : reference_pairs){
+}
+
+/* Accuracy as per-event 1-D Wasserstein distances between the combined profile's marginals and the references' marginals
+*  Each event's distance is calibrated by the mean distance between the reference repeats themselves, computed here,
+*  then the calibrated distances are weighted-averaged across the symbols and geometric-averaged across the events
+*  Items are indexed by event_idx * num_symbols + symbol_idx, and the reference marginals are then ordered by repeat
+*/
+void prepare_marginal_references(
+		Fuse::Target& target,
+		const Fuse::Event_set& events,
+		const std::vector<Fuse::Symbol>& symbols,
+		const std::vector<unsigned int>& reference_repeats_list,
+		std::vector<std::vector<double> >& reference_marginals,
+		std::vector<double>& calibrations,
+		std::vector<double>& weights
+		){
 
-		// Map of symbol to (list of the symbol's reference tmds for each combination of repeats)
-		std::map<Fuse::Symbol, std::vector<double> > reference_tmd_per_combination_per_symbol;
+	if(reference_repeats_list.size() < 2)
+		throw std::runtime_error(fmt::format(
+			"Calibrating the {} metric requires at least two reference repeats, but there are {}.",
+			Fuse::convert_metric_to_string(Fuse::Accuracy_metric::MARGINAL_W1),
+			reference_repeats_list.size()));
 
-		// Map of symbol to (list of the number of instances of that symbol for each combination of repeats)
-		std::map<Fuse::Symbol, std::vector<double> > num_instances_per_combination_per_symbol;
+	unsigned int num_symbols = symbols.size();
+	unsigned int num_items = events.size() * num_symbols;
+	unsigned int num_repeats = reference_repeats_list.size();
 
-		// Check if we have already calibrated this reference pair (assume if we have one symbol, we have all)
-		auto calibration_tmd_pair = target.get_or_load_calibration_tmd(reference_pair, "all_symbols");
-		if(calibration_tmd_pair.first >= 0.0){
-			spdlog::debug("Already calibrated the event pair {}:{}.", pair_idx, Fuse::Util::vector_to_string(reference_pair));
-			pair_idx++;
-			continue;
-		}
+	reference_marginals.assign(num_items * num_repeats, std::vector<double>());
+	calibrations.assign(num_items, 0.0);
+	weights.assign(num_items, 0.0);
+	std::exception_ptr analysis_exception = nullptr;
 
-		spdlog::debug("Running calibration for the event pair {}:{}.", pair_idx, Fuse::Util::vector_to_string(reference_pair));
-		for(auto combination : reference_repeat_combinations){
+	#pragma omp parallel for schedule(dynamic)
+	for(unsigned int item_idx = 0; item_idx < num_items; item_idx++){
 
-			for(auto symbol : symbols){
+		try {
+
+			Fuse::Event_set event = {events.at(item_idx / num_symbols)};
+			Fuse::Symbol symbol = symbols.at(item_idx % num_symbols);
+			auto bounds = target.get_statistics()->get_bounds(event.front(), symbol);
+
+			double summed_num_instances = 0.0;
+			for(unsigned int repeat_idx = 0; repeat_idx < num_repeats; repeat_idx++){
 
 				std::vector<Fuse::Symbol> constrained_symbols;
 				if(symbol != "all_symbols")
 					constrained_symbols = {symbol};
 
-				auto distribution_one = target.get_or_load_reference_distribution(reference_pair, combination.at(0), constrained_symbols);
-				auto distribution_two = target.get_or_load_reference_distribution(reference_pair, combination.at(1), constrained_symbols);
+				auto distribution = target.get_or_load_reference_distribution(
+					event, reference_repeats_list.at(repeat_idx), constrained_symbols);
 
-				std::vector<std::pair<int64_t, int64_t> > bounds_per_event;
-				for(auto event : reference_pair)
-					bounds_per_event.push_back(target.get_statistics()->get_bounds(event, symbol));
+				reference_marginals.at(item_idx * num_repeats + repeat_idx) = Fuse::Analysis::construct_sorted_marginal(distribution, 0, bounds);
+				summed_num_instances += distribution.size();
 
-				auto tmd = Fuse::Analysis::calculate_uncalibrated_tmd(distribution_one, distribution_two, bounds_per_event, Fuse::Config::tmd_bin_count);
+			}
 
-				auto symbol_iter = reference_tmd_per_combination_per_symbol.find(symbol);
-				if(symbol_iter == reference_tmd_per_combination_per_symbol.end()){
+			double summed_distance = 0.0;
+			unsigned int num_distances = 0;
+			for(unsigned int repeat_one = 0; repeat_one < num_repeats; repeat_one++){
+				for(unsigned int repeat_two = repeat_one+1; repeat_two < num_repeats; repeat_two++){
+					summed_distance += Fuse::Transport::calculate_sorted_1d_emd(
+						reference_marginals.at(item_idx * num_repeats + repeat_one),
+						reference_marginals.at(item_idx * num_repeats + repeat_two));
+					num_distances++;
+				}
+			}
 
-					std::vector<double> tmds_per_combination_for_this_symbol = {tmd};
-					std::vector<double> num_instances_per_combination_for_this_symbol = {static_cast<double>(distribution_one.size())};
+			calibrations.at(item_idx) = summed_distance / num_distances;
+			weights.at(item_idx) = summed_num_instances / num_repeats;
 
-					reference_tmd_per_combination_per_symbol.insert(std::make_pair(symbol, tmds_per_combination_for_this_symbol));
-					num_instances_per_combination_per_symbol.insert(std::make_pair(symbol, num_instances_per_combination_for_this_symbol));
+		} catch(...){
+			#pragma omp critical (analysis_exception)
+			analysis_exception = std::current_exception();
+		}
 
-				} else {
+	}
 
-					symbol_iter->second.push_back(tmd);
-					num_instances_per_combination_per_symbol.find(symbol)->second.push_back(static_cast<double>(distribution_one.size()));
+	if(analysis_exception != nullptr)
+		std::rethrow_exception(analysis_exception);
 
-				}
+}
 
-			}
+// The median, across the reference repeats, of the distance between the combined profile's marginal and each reference marginal
+double calculate_uncalibrated_marginal_distance(
+		Fuse::Target& target,
+		Fuse::Profile_p profile,
+		const Fuse::Event& event,
+		const Fuse::Symbol& symbol,
+		std::vector<std::vector<double> >::const_iterator reference_marginals_begin,
+		unsigned int num_repeats
+		){
 
-		}
+	std::vector<Fuse::Symbol> constrained_symbols;
+	if(symbol != "all_symbols")
+		constrained_symbols = {symbol};
 
-		// Now, for each symbol, average the tmds across the combinations to give the calibration tmd for the symbol for the pair
+	auto distribution_per_symbol = profile->get_value_distribution({event}, false, constrained_symbols);
+	auto marginal = Fuse::Analysis::construct_sorted_marginal(
+		distribution_per_symbol.begin()->second,
+		0,
+		target.get_statistics()->get_bounds(event, symbol));
 
-		for(auto symbol : symbols){
+	// As for the TMDs, take the median across the reference repeats
+	std::vector<double> distances_per_reference_repeat;
+	distances_per_reference_repeat.reserve(num_repeats);
+	for(unsigned int repeat_idx = 0; repeat_idx < num_repeats; repeat_idx++)
+		distances_per_reference_repeat.push_back(Fuse::Transport::calculate_sorted_1d_emd(*(reference_marginals_begin + repeat_idx), marginal));
 
-			auto tmds = reference_tmd_per_combination_per_symbol.find(symbol)->second;
-			auto num_instances_list = num_instances_per_combination_per_symbol.find(symbol)->second;
+	return Fuse::calculate_median_from_values(distances_per_reference_repeat);
 
-			Fuse::Stats tmd_stats = Fuse::calculate_stats_from_values(tmds);
-			auto median_tmd = Fuse::calculate_median_from_values(tmds);
+}
 
-			Fuse::Stats num_instances_stats = Fuse::calculate_stats_from_values(num_instances_list);
+// Calibrates and averages one combined profile's marginal distances (ordered by item) and saves the results
+void report_marginal_accuracy(
+		Fuse::Target& target,
+		Fuse::Strategy strategy,
+		unsigned int repeat_idx,
+		const Fuse::Event_set& events,
+		const std::vector<Fuse::Symbol>& symbols,
+		std::vector<double>::const_iterator uncalibrated_distances_begin,
+		const std::vector<double>& calibrations,
+		const std::vector<double>& weights
+		){
 
-			if(num_instances_stats.min != num_instances_stats.max)
-				spdlog::warn("Reference distribution for {} and symbol '{}' has variable instance counts across combinations (from {} to {}).",
-					Fuse::Util::vector_to_string(reference_pair),
-					symbol,
-					num_instances_stats.min,
-					num_instances_stats.max
-				);
+	unsigned int num_symbols = symbols.size();
+	std::map<unsigned int, double> distance_per_event;
 
-			target.save_reference_calibration_tmd_to_disk(
-				symbol,
-				reference_pair,
-				pair_idx,
-				tmd_stats.min,
-				tmd_stats.max,
-				tmd_stats.mean,
-				tmd_stats.std,
-				median_tmd,
-				num_instances_stats.mean
-			);
+	for(unsigned int event_idx = 0; event_idx < events.size(); event_idx++){
+
+		std::vector<double> calibrated_distances_per_symbol;
+		std::vector<double> weights_per_symbol;
+
+		for(unsigned int symbol_idx = 0; symbol_idx < num_symbols; symbol_idx++){
+
+			unsigned int item_idx = event_idx * num_symbols + symbol_idx;
+
+			double calibration = calibrations.at(item_idx);
+			if(calibration == 0.0){
+				spdlog::warn("Calibration distance for event {} and symbol '{}' was 0.0.", events.at(event_idx), symbols.at(symbol_idx));
+				calibration = 1.0; // Let it be equal to the uncalibrated distance in this case
+			}
+
+			calibrated_distances_per_symbol.push_back(*(uncalibrated_distances_begin + item_idx) / calibration);
+
+			if(Fuse::Config::weighted_tmd)
+				weights_per_symbol.push_back(weights.at(item_idx));
 
 		}
 
-		pair_idx++;
+		distance_per_event.insert(std::make_pair(event_idx,
+			Fuse::calculate_weighted_geometric_mean(calibrated_distances_per_symbol, weights_per_symbol)));
+
 	}
 
-	spdlog::info("Finished calculating calibration TMDs.");
+	std::vector<double> distances;
+	distances.reserve(distance_per_event.size());
+	for(auto event_result : distance_per_event)
+		distances.push_back(event_result.second);
+
+	double overall_distance = Fuse::calculate_weighted_geometric_mean(distances);
+
+	spdlog::info("Overall {} of {} repeat {} is: {}.",
+		Fuse::convert_metric_to_string(Fuse::Accuracy_metric::MARGINAL_W1),
+		Fuse::convert_strategy_to_string(strategy),
+		repeat_idx,
+		overall_distance
+	);
+
+	target.save_accuracy_results_to_disk(Fuse::Accuracy_metric::MARGINAL_W1, strategy, repeat_idx, overall_distance, distance_per_event);
+
+}
+
+/* Accuracy as the error in each reference pair's Spearman's rank correlation, per symbol
+*  The error is the absolute difference between the combined profile's correlation and that of each reference repeat (taking the median)
+*  These are weighted-averaged across the symbols, and then averaged across the pairs
+*  An arithmetic mean is used as, unlike a TMD, a correlation error of 0 is expected for pairs that were measured together
+*  Items are indexed by pair_idx * num_symbols + symbol_idx, and the reference correlations are then ordered by repeat
+*/
+void prepare_rank_correlation_references(
+		Fuse::Target& target,
+		const std::vector<Fuse::Event_set>& reference_pairs,
+		const std::vector<Fuse::Symbol>& symbols,
+		const std::vector<unsigned int>& reference_repeats_list,
+		std::vector<double>& reference_correlations,
+		std::vector<double>& weights
+		){
+
+	unsigned int num_symbols = symbols.size();
+	unsigned int num_items = reference_pairs.size() * num_symbols;
+	unsigned int num_repeats = reference_repeats_list.size();
+
+	reference_correlations.assign(num_items * num_repeats, 0.0);
+	weights.assign(num_items, 0.0);
+	std::exception_ptr analysis_exception = nullptr;
+
+	#pragma omp parallel for schedule(dynamic)
+	for(unsigned int item_idx = 0; item_idx < num_items; item_idx++){
+
+		try {
+
+			Fuse::Symbol symbol = symbols.at(item_idx % num_symbols);
+
+			double summed_num_instances = 0.0;
+			for(unsigned int repeat_idx = 0; repeat_idx < num_repeats; repeat_idx++){
+
+				std::vector<Fuse::Symbol> constrained_symbols;
+				if(symbol != "all_symbols")
+					constrained_symbols = {symbol};
+
+				auto distribution = target.get_or_load_reference_distribution(
+					reference_pairs.at(item_idx / num_symbols), reference_repeats_list.at(repeat_idx), constrained_symbols);
+
+				reference_correlations.at(item_idx * num_repeats + repeat_idx) = Fuse::Analysis::calculate_spearmans_rank_correlation(distribution);
+				summed_num_instances += distribution.size();
+
+			}
+
+			weights.at(item_idx) = summed_num_instances / num_repeats;
+
+		} catch(...){
+			#pragma omp critical (analysis_exception)
+			analysis_exception = std::current_exception();
+		}
+
+	}
+
+	if(analysis_exception != nullptr)
+		std::rethrow_exception(analysis_exception);
+
+}
+
+// Averages one combined profile's correlation errors (ordered by item) and saves the results
+void report_rank_correlation_accuracy(
+		Fuse::Target& target,
+		Fuse::Strategy strategy,
+		unsigned int repeat_idx,
+		const std::vector<Fuse::Event_set>& reference_pairs,
+		unsigned int num_symbols,
+		std::vector<double>::const_iterator correlation_errors_begin,
+		const std::vector<double>& weights
+		){
+
+	std::map<unsigned int, double> error_per_reference_pair;
+	double summed_error = 0.0;
+
+	for(unsigned int pair_idx = 0; pair_idx < reference_pairs.size(); pair_idx++){
+
+		double summed_weighted_error = 0.0;
+		double summed_weights = 0.0;
+
+		for(unsigned int symbol_idx = 0; symbol_idx < num_symbols; symbol_idx++){
+			unsigned int item_idx = pair_idx * num_symbols + symbol_idx;
+			double weight = Fuse::Config::weighted_tmd ? weights.at(item_idx) : 1.0;
+			summed_weighted_error += weight * *(correlation_errors_begin + item_idx);
+			summed_weights += weight;
+		}
+
+		double error = summed_weights > 0.0 ? summed_weighted_error / summed_weights : 0.0;
+		error_per_reference_pair.insert(std::make_pair(pair_idx, error));
+		summed_error += error;
+
+	}
+
+	double overall_error = reference_pairs.size() > 0 ? summed_error / reference_pairs.size() : 0.0;
+
+	spdlog::info("Overall {} of {} repeat {} is: {}.",
+		Fuse::convert_metric_to_string(Fuse::Accuracy_metric::SPEARMANS),
+		Fuse::convert_strategy_to_string(strategy),
+		repeat_idx,
+		overall_error
+	);
+
+	target.save_accuracy_results_to_disk(Fuse::Accuracy_metric::SPEARMANS, strategy, repeat_idx, overall_error, error_per_reference_pair);
+
+}
+
+// FNV-1a, continuing from the given hash
+uint64_t hash_bytes(
+		uint64_t hash,
+		const void* data,
+		size_t num_bytes
+		){
+
+	auto bytes = static_cast<const unsigned char*>(data);
+	for(size_t byte_idx = 0; byte_idx < num_bytes; byte_idx++){
+		hash ^= bytes[byte_idx];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+
+}
+
+/* Fingerprint of everything that a combined profile's uncalibrated TMDs depend on, other than the statistics bounds
+*  This is the combined profile's file contents, the TMD parameters, and the number of reference repeats
+*  The TMD-based metrics share the same TMDs, so the metric is not part of the fingerprint
+*  Returns 0 if the combined profile has not been saved, in which case its results are not cached
+*/
+uint64_t calculate_accuracy_fingerprint_for_profile(
+		Fuse::Target& target,
+		Fuse::Strategy strategy,
+		unsigned int repeat_idx
+		){
+
+	auto filename = target.get_combination_filename(strategy, repeat_idx);
+
+	auto file_stream = std::ifstream(filename, std::ios::in | std::ios::binary);
+	if(file_stream.is_open() == false)
+		return 0;
+
+	uint64_t hash = 14695981039346656037ULL;
+
+	std::vector<char> buffer(1 << 20);
+	while(file_stream){
+		file_stream.read(buffer.data(), buffer.size());
+		hash = hash_bytes(hash, buffer.data(), file_stream.gcount());
+	}
+
+	unsigned int num_reference_repeats = target.get_num_reference_repeats();
+	unsigned int solver_idx = static_cast<unsigned int>(Fuse::Config::tmd_solver);
+
+	hash = hash_bytes(hash, &num_reference_repeats, sizeof(num_reference_repeats));
+	hash = hash_bytes(hash, &Fuse::Config::tmd_bin_count, sizeof(Fuse::Config::tmd_bin_count));
+	hash = hash_bytes(hash, &solver_idx, sizeof(solver_idx));
+	if(Fuse::Config::tmd_solver == Fuse::Tmd_solver::SINKHORN){
+		hash = hash_bytes(hash, &Fuse::Config::sinkhorn_epsilon, sizeof(Fuse::Config::sinkhorn_epsilon));
+		hash = hash_bytes(hash, &Fuse::Config::sinkhorn_tolerance, sizeof(Fuse::Config::sinkhorn_tolerance));
+		hash = hash_bytes(hash, &Fuse::Config::sinkhorn_max_iterations, sizeof(Fuse::Config::sinkhorn_max_iterations));
+	}
+
+	// Reserve 0 for 'not cached'
+	return std::max<uint64_t>(hash, 1);
+
+}
+
+// Extends the profile's fingerprint with the statistics bounds of the symbol's reference pair
+uint64_t calculate_accuracy_fingerprint_for_pair(
+		Fuse::Target& target,
+		uint64_t profile_fingerprint,
+		const Fuse::Event_set& reference_pair,
+		const Fuse::Symbol& symbol
+		){
+
+	uint64_t hash = profile_fingerprint;
+	for(auto event : reference_pair){
+		auto bounds = target.get_statistics()->get_bounds(event, symbol);
+		hash = hash_bytes(hash, &bounds.first, sizeof(bounds.first));
+		hash = hash_bytes(hash, &bounds.second, sizeof(bounds.second));
+	}
+
+	return std::max<uint64_t>(hash, 1);
+
+}
+
+// Linearly interpolated percentile of the sorted values, where fraction is in [0,1]
+double calculate_percentile_from_sorted_values(
+		const std::vector<double>& sorted_values,
+		double fraction
+		){
+
+	double position = fraction * (sorted_values.size() - 1);
+	auto lower_idx = static_cast<size_t>(std::floor(position));
+	auto upper_idx = std::min(lower_idx + 1, sorted_values.size() - 1);
+
+	return sorted_values.at(lower_idx) + (position - lower_idx) * (sorted_values.at(upper_idx) - sorted_values.at(lower_idx));
+
+}
+
+/* Percentile bootstrap confidence interval of a combined profile's EPD
+*  Each replicate resamples the instances of the combined and reference distributions via their signatures, so the binning
+*  is done once and reused by every replicate. The calibration TMDs are not resampled
+*/
+std::pair<double, double> calculate_epd_bootstrap_confidence_interval(
+		Fuse::Target& target,
+		Fuse::Profile_p profile,
+		const std::vector<Fuse::Event_set>& reference_pairs,
+		const std::vector<Fuse::Symbol>& symbols,
+		const std::vector<unsigned int>& reference_repeats_list,
+		unsigned int num_replicates,
+		double confidence
+		){
+
+	unsigned int num_pairs = reference_pairs.size();
+	unsigned int num_symbols = symbols.size();
+	unsigned int num_references = reference_repeats_list.size();
+
+	// Ordered by pair then symbol, with the reference signatures then ordered by repeat
+	std::vector<Fuse::Analysis::Tmd_signature> profile_signatures(num_pairs * num_symbols);
+	std::vector<std::shared_ptr<const Fuse::Analysis::Tmd_signature> > reference_signatures(num_pairs * num_symbols * num_references);
+	std::exception_ptr bootstrap_exception = nullptr;
+
+	#pragma omp parallel for schedule(dynamic)
+	for(unsigned int signature_idx = 0; signature_idx < num_pairs * num_symbols; signature_idx++){
+
+		auto& reference_pair = reference_pairs.at(signature_idx / num_symbols);
+		auto& symbol = symbols.at(signature_idx % num_symbols);
+
+		try {
+
+			profile_signatures.at(signature_idx) = Fuse::Analysis::construct_profile_signature_for_symbol(
+				target, symbol, reference_pair, profile, Fuse::Config::tmd_bin_count);
+
+			std::vector<std::pair<int64_t, int64_t> > bounds_per_event;
+			for(auto event : reference_pair)
+				bounds_per_event.push_back(target.get_statistics()->get_bounds(event, symbol));
+
+			for(unsigned int reference_idx = 0; reference_idx < num_references; reference_idx++)
+				reference_signatures.at(signature_idx * num_references + reference_idx) = target.get_or_build_reference_signature(
+					reference_pair, reference_repeats_list.at(reference_idx), symbol, bounds_per_event, Fuse::Config::tmd_bin_count);
+
+		} catch(...){
+			#pragma omp critical (bootstrap_exception)
+			bootstrap_exception = std::current_exception();
+		}
+
+	}
+
+	if(bootstrap_exception != nullptr)
+		std::rethrow_exception(bootstrap_exception);
+
+	// Each (replicate, pair) is seeded independently, so the replicates do not depend on the scheduling
+	std::vector<double> calibrated_tmds(num_replicates * num_pairs, 0.0);
+
+	#pragma omp parallel for schedule(dynamic)
+	for(unsigned int tmd_idx = 0; tmd_idx < num_replicates * num_pairs; tmd_idx++){
+
+		unsigned int replicate_idx = tmd_idx / num_pairs;
+		unsigned int pair_idx = tmd_idx % num_pairs;
+
+		try {
+
+			std::seed_seq seed = {replicate_idx, pair_idx};
+			std::mt19937_64 random_engine(seed);
+
+			std::map<Fuse::Symbol, double> uncalibrated_tmd_per_symbol;
+			for(unsigned int symbol_idx = 0; symbol_idx < num_symbols; symbol_idx++){
+
+				unsigned int signature_idx = pair_idx * num_symbols + symbol_idx;
+				auto profile_signature = Fuse::Analysis::resample_tmd_signature(profile_signatures.at(signature_idx), random_engine);
+
+				std::vector<double> uncalibrated_tmds_per_reference_repeat;
+				uncalibrated_tmds_per_reference_repeat.reserve(num_references);
+				for(unsigned int reference_idx = 0; reference_idx < num_references; reference_idx++){
+					auto reference_signature = Fuse::Analysis::resample_tmd_signature(
+						*reference_signatures.at(signature_idx * num_references + reference_idx), random_engine);
+					uncalibrated_tmds_per_reference_repeat.push_back(
+						Fuse::Analysis::calculate_tmd_between_signatures(reference_signature, profile_signature, Fuse::Config::tmd_solver));
+				}
+
+				uncalibrated_tmd_per_symbol[symbols.at(symbol_idx)] = Fuse::calculate_median_from_values(uncalibrated_tmds_per_reference_repeat);
+
+			}
+
+			calibrated_tmds.at(tmd_idx) = Fuse::Analysis::calibrate_tmds_for_pair(
+				target,
+				reference_pairs.at(pair_idx),
+				uncalibrated_tmd_per_symbol,
+				Fuse::Config::weighted_tmd);
+
+		} catch(...){
+			#pragma omp critical (bootstrap_exception)
+			bootstrap_exception = std::current_exception();
+		}
+
+	}
+
+	if(bootstrap_exception != nullptr)
+		std::rethrow_exception(bootstrap_exception);
+
+	std::vector<double> epds;
+	epds.reserve(num_replicates);
+	for(unsigned int replicate_idx = 0; replicate_idx < num_replicates; replicate_idx++){
+		std::vector<double> tmds(calibrated_tmds.begin() + replicate_idx * num_pairs, calibrated_tmds.begin() + (replicate_idx + 1) * num_pairs);
+		epds.push_back(Fuse::calculate_weighted_geometric_mean(tmds));
+	}
+
+	std::sort(epds.begin(), epds.end());
+
+	double tail = (1.0 - confidence) / 2.0;
+	return std::make_pair(
+		calculate_percentile_from_sorted_values(epds, tail),
+		calculate_percentile_from_sorted_values(epds, 1.0 - tail)
+	);
+
+}
+
+/* Calibrates and averages one combined profile's uncalibrated TMDs (ordered by pair then symbol), and saves the results
+*  The TMD-based metrics are calculated identically, so the same result (and confidence interval) is saved for each
+*  The TMDs that were newly calculated (i.e. with a non-zero fingerprint) are then cached
+*/
+void report_tmd_accuracy(
+		Fuse::Target& target,
+		const std::vector<Fuse::Accuracy_metric>& metrics,
+		Fuse::Strategy strategy,
+		unsigned int repeat_idx,
+		const std::vector<Fuse::Event_set>& reference_pairs,
+		const std::vector<Fuse::Symbol>& symbols,
+		const std::vector<unsigned int>& reference_repeats_list,
+		std::vector<double>::const_iterator uncalibrated_tmds_begin,
+		std::vector<uint64_t>::const_iterator fingerprints_begin
+		){
+
+	unsigned int num_pairs = reference_pairs.size();
+	unsigned int num_symbols = symbols.size();
+
+	std::map<unsigned int, double> tmd_per_reference_pair;
+
+	for(unsigned int pair_idx = 0; pair_idx < num_pairs; pair_idx++){
+
+		std::map<Fuse::Symbol, double> uncalibrated_tmd_per_symbol;
+		for(unsigned int symbol_idx = 0; symbol_idx < num_symbols; symbol_idx++)
+			uncalibrated_tmd_per_symbol.insert(std::make_pair(symbols.at(symbol_idx),
+				*(uncalibrated_tmds_begin + pair_idx * num_symbols + symbol_idx)));
+
+		double calibrated_tmd_wrt_pair = Fuse::Analysis::calibrate_tmds_for_pair(
+			target,
+			reference_pairs.at(pair_idx),
+			uncalibrated_tmd_per_symbol,
+			Fuse::Config::weighted_tmd);
+
+		tmd_per_reference_pair.insert(std::make_pair(pair_idx, calibrated_tmd_wrt_pair));
+	}
+
+	// Calculate the overall epd
+	std::vector<double> tmds;
+	tmds.reserve(tmd_per_reference_pair.size());
+	for(auto pair_result : tmd_per_reference_pair){
+		tmds.push_back(pair_result.second);
+	}
+	double epd = Fuse::calculate_weighted_geometric_mean(tmds);
+
+	for(auto metric : metrics){
+
+		spdlog::info("Overall {} of {} repeat {} is: {}.",
+			Fuse::convert_metric_to_string(metric),
+			Fuse::convert_strategy_to_string(strategy),
+			repeat_idx,
+			epd
+		);
+
+		target.save_accuracy_results_to_disk(metric, strategy, repeat_idx, epd, tmd_per_reference_pair);
+
+	}
+
+	if(Fuse::Config::epd_bootstrap_replicates > 0){
+
+		auto profile = target.get_or_load_combined_profile(strategy, repeat_idx);
+
+		auto confidence_interval = calculate_epd_bootstrap_confidence_interval(
+			target,
+			profile,
+			reference_pairs,
+			symbols,
+			reference_repeats_list,
+			Fuse::Config::epd_bootstrap_replicates,
+			Fuse::Config::epd_bootstrap_confidence
+		);
+
+		for(auto metric : metrics){
+
+			spdlog::info("The {}% bootstrap confidence interval of the {} of {} repeat {} is [{}, {}].",
+				100.0 * Fuse::Config::epd_bootstrap_confidence,
+				Fuse::convert_metric_to_string(metric),
+				Fuse::convert_strategy_to_string(strategy),
+				repeat_idx,
+				confidence_interval.first,
+				confidence_interval.second
+			);
+
+			target.save_accuracy_confidence_interval_to_disk(metric, strategy, repeat_idx, epd,
+				Fuse::Config::epd_bootstrap_replicates, Fuse::Config::epd_bootstrap_confidence, confidence_interval);
+
+		}
+
+	}
+
+	// Cache the newly calculated TMDs, per combined profile so that progress is kept if the analysis is interrupted
+	std::vector<std::pair<Fuse::Accuracy_cache_key, Fuse::Accuracy_cache_entry> > new_entries;
+	for(unsigned int item_idx = 0; item_idx < num_pairs * num_symbols; item_idx++){
+		auto fingerprint = *(fingerprints_begin + item_idx);
+		if(fingerprint == 0)
+			continue;
+
+		auto key = std::make_tuple(strategy, repeat_idx, item_idx / num_symbols, symbols.at(item_idx % num_symbols));
+		new_entries.push_back(std::make_pair(key, std::make_pair(fingerprint, *(uncalibrated_tmds_begin + item_idx))));
+	}
+
+	if(new_entries.size() > 0)
+		target.save_accuracy_cache_entries_to_disk(new_entries);
+
+}
+
+void Fuse::analyse_sequence_combinations(
+		Fuse::Target& target,
+		std::vector<Fuse::Strategy> strategies,
+		std::vector<unsigned int> repeat_indexes,
+		Fuse::Accuracy_metric metric){
+
+	Fuse::analyse_sequence_combinations(target, strategies, repeat_indexes, std::vector<Fuse::Accuracy_metric>{metric});
+
+}
+
+void Fuse::analyse_sequence_combinations(
+		Fuse::Target& target,
+		std::vector<Fuse::Strategy> strategies,
+		std::vector<unsigned int> repeat_indexes,
+		std::vector<Fuse::Accuracy_metric> metrics){
+
+	if(Fuse::Config::lazy_load_references == false)
+		target.load_reference_distributions();
+
+	auto reference_pairs = target.get_reference_pairs();
+	auto events = target.get_target_events();
+
+	std::vector<unsigned int> reference_repeats_list(target.get_num_reference_repeats());
+	std::iota(reference_repeats_list.begin(), reference_repeats_list.end(), 0);
+
+	std::vector<Fuse::Symbol> symbols = {"all_symbols"};
+	if(Fuse::Config::calculate_per_workfunction_tmds){
+		auto all_symbols = target.get_statistics()->get_unique_symbols(false);
+		symbols.insert(symbols.end(), all_symbols.begin(), all_symbols.end());
+	}
+
+	std::vector<std::pair<Fuse::Strategy, unsigned int> > profiles_to_analyse;
+	for(auto strategy : strategies)
+		for(auto repeat_idx : repeat_indexes) // Combined profile repeats, we report value for each
+			profiles_to_analyse.push_back(std::make_pair(strategy, repeat_idx));
+
+	// Every other metric is TMD-based
+	std::vector<Fuse::Accuracy_metric> unique_metrics;
+	std::vector<Fuse::Accuracy_metric> tmd_metrics;
+	bool rank_correlation = false;
+	bool marginals = false;
+	for(auto metric : metrics){
+		if(std::find(unique_metrics.begin(), unique_metrics.end(), metric) != unique_metrics.end())
+			continue;
+
+		unique_metrics.push_back(metric);
+		if(metric == Fuse::Accuracy_metric::SPEARMANS)
+			rank_correlation = true;
+		else if(metric == Fuse::Accuracy_metric::MARGINAL_W1)
+			marginals = true;
+		else
+			tmd_metrics.push_back(metric);
+	}
+
+	std::vector<std::string> metric_strs;
+	for(auto metric : unique_metrics)
+		metric_strs.push_back(Fuse::convert_metric_to_string(metric));
+
+	unsigned int num_profiles = profiles_to_analyse.size();
+	unsigned int num_symbols = symbols.size();
+	unsigned int num_repeats = reference_repeats_list.size();
+	unsigned int num_pair_items = reference_pairs.size() * num_symbols; // indexed by pair_idx * num_symbols + symbol_idx
+	unsigned int num_event_items = events.size() * num_symbols; // indexed by event_idx * num_symbols + symbol_idx
+
+	/* The references of the non-TMD metrics are prepared up front, whereas reference signatures are built and cached on first use */
+
+	std::vector<std::vector<double> > reference_marginals;
+	std::vector<double> marginal_calibrations;
+	std::vector<double> marginal_weights;
+	if(marginals)
+		prepare_marginal_references(target, events, symbols, reference_repeats_list, reference_marginals, marginal_calibrations, marginal_weights);
+
+	std::vector<double> reference_correlations;
+	std::vector<double> correlation_weights;
+	if(rank_correlation)
+		prepare_rank_correlation_references(target, reference_pairs, symbols, reference_repeats_list, reference_correlations, correlation_weights);
+
+	/* Uncalibrated TMDs from previous analyses are reused if nothing they were calculated from has changed
+	*  Calibration is cheap and is always reapplied, so that recalibrating the references does not invalidate the cache
+	*/
+	std::map<Fuse::Accuracy_cache_key, Fuse::Accuracy_cache_entry> accuracy_cache;
+	if(Fuse::Config::cache_accuracy_results && tmd_metrics.size() > 0)
+		accuracy_cache = target.load_accuracy_cache_from_disk();
+
+	// The TMD-based metrics share the same TMDs, which are calculated once and ordered by profile then item
+	bool calculate_tmds = tmd_metrics.size() > 0;
+	std::vector<double> uncalibrated_tmds(calculate_tmds ? num_profiles * num_pair_items : 0, 0.0);
+	std::vector<uint64_t> fingerprints(uncalibrated_tmds.size(), 0); // 0 if the TMD was reused or is not to be cached
+	std::vector<double> correlation_errors(rank_correlation ? num_profiles * num_pair_items : 0, 0.0);
+	std::vector<double> uncalibrated_distances(marginals ? num_profiles * num_event_items : 0, 0.0);
+	std::exception_ptr analysis_exception = nullptr;
+
+	// Each (strategy, repeat) combined profile is loaded once by its own task, which then spawns a task per item
+	// Every task writes only its own slots of the results, which are reduced serially afterwards in a fixed order
+	#pragma omp parallel
+	#pragma omp single
+	{
+		for(unsigned int profile_idx = 0; profile_idx < num_profiles; profile_idx++){
+
+			#pragma omp task firstprivate(profile_idx) shared(target, profiles_to_analyse, reference_pairs, events, symbols, reference_repeats_list, metric_strs, accuracy_cache, reference_marginals, reference_correlations, uncalibrated_tmds, fingerprints, correlation_errors, uncalibrated_distances, analysis_exception)
+			{
+				auto strategy = profiles_to_analyse.at(profile_idx).first;
+				auto repeat_idx = profiles_to_analyse.at(profile_idx).second;
+
+				// Per pair item, whether its TMD is still to be calculated
+				std::vector<bool> pending_tmds(num_pair_items, false);
+				unsigned int num_reused_tmds = 0;
+
+				Fuse::Profile_p profile;
+				try {
+
+					uint64_t profile_fingerprint = 0;
+					if(calculate_tmds && Fuse::Config::cache_accuracy_results)
+						profile_fingerprint = calculate_accuracy_fingerprint_for_profile(target, strategy, repeat_idx);
+
+					for(unsigned int item_idx = 0; calculate_tmds && item_idx < num_pair_items; item_idx++){
+
+						unsigned int tmd_idx = profile_idx * num_pair_items + item_idx;
+						unsigned int pair_idx = item_idx / num_symbols;
+						auto& symbol = symbols.at(item_idx % num_symbols);
+
+						if(profile_fingerprint != 0){
+							auto fingerprint = calculate_accuracy_fingerprint_for_pair(
+								target, profile_fingerprint, reference_pairs.at(pair_idx), symbol);
+
+							auto cache_iter = accuracy_cache.find(std::make_tuple(strategy, repeat_idx, pair_idx, symbol));
+							if(cache_iter != accuracy_cache.end() && cache_iter->second.first == fingerprint){
+								uncalibrated_tmds.at(tmd_idx) = cache_iter->second.second;
+								num_reused_tmds++;
+								continue;
+							}
+
+							fingerprints.at(tmd_idx) = fingerprint;
+						}
+
+						pending_tmds.at(item_idx) = true;
+
+					}
+
+					spdlog::info("Calculating {} accuracy for combination repeat {} by strategy {} ({}/{}), reusing {} of {} cached TMDs.",
+						Fuse::Util::vector_to_string(metric_strs),
+						repeat_idx,
+						Fuse::convert_strategy_to_string(strategy),
+						profile_idx,
+						num_profiles-1,
+						num_reused_tmds,
+						calculate_tmds ? num_pair_items : 0
+					);
+
+					// Only load the combined profile if there is anything to calculate
+					bool requires_profile = rank_correlation || marginals
+						|| std::find(pending_tmds.begin(), pending_tmds.end(), true) != pending_tmds.end();
+
+					if(requires_profile)
+						profile = target.get_or_load_combined_profile(strategy, repeat_idx);
+
+				} catch(...){
+					#pragma omp critical (analysis_exception)
+					analysis_exception = std::current_exception();
+				}
+
+				if(profile != nullptr){
+
+					// Each (pair, symbol) distribution is extracted once, and given to every metric that needs it
+					for(unsigned int item_idx = 0; item_idx < num_pair_items; item_idx++){
+
+						bool pending_tmd = pending_tmds.at(item_idx);
+						if(pending_tmd == false && rank_correlation == false)
+							continue;
+
+						#pragma omp task firstprivate(profile, item_idx, pending_tmd) shared(target, reference_pairs, symbols, reference_repeats_list, reference_correlations, uncalibrated_tmds, correlation_errors, analysis_exception)
+						{
+							try {
+
+								auto& reference_pair = reference_pairs.at(item_idx / num_symbols);
+								auto& symbol = symbols.at(item_idx % num_symbols);
+
+								std::vector<Fuse::Symbol> constrained_symbols;
+								if(symbol != "all_symbols")
+									constrained_symbols = {symbol};
+
+								// We are guaranteed one if no exception
+								auto distribution_per_symbol = profile->get_value_distribution(reference_pair, false, constrained_symbols);
+								auto& distribution = distribution_per_symbol.begin()->second;
+
+								if(pending_tmd){
+
+									std::vector<std::pair<int64_t, int64_t> > bounds_per_event;
+									for(auto event : reference_pair)
+										bounds_per_event.push_back(target.get_statistics()->get_bounds(event, symbol));
+
+									auto signature = Fuse::Analysis::construct_tmd_signature(distribution, bounds_per_event, Fuse::Config::tmd_bin_count);
+
+									/* The uncalibrated tmds of one symbol for each reference repeat, of which we take the median
+									*  These are later calibrated to the per-symbol calibration tmds
+									*  Then weighted-averaged across the symbols, to give a final TMD value for the pair
+									*/
+									uncalibrated_tmds.at(profile_idx * num_pair_items + item_idx) =
+										Fuse::Analysis::calculate_uncalibrated_tmd_for_signature(
+											target,
+											symbol,
+											reference_pair,
+											signature,
+											reference_repeats_list,
+											Fuse::Config::tmd_bin_count,
+											Fuse::Config::tmd_solver
+										);
+
+								}
+
+								if(rank_correlation){
+
+									double correlation = Fuse::Analysis::calculate_spearmans_rank_correlation(distribution);
+
+									std::vector<double> errors_per_reference_repeat;
+									errors_per_reference_repeat.reserve(num_repeats);
+									for(unsigned int repeat_idx = 0; repeat_idx < num_repeats; repeat_idx++)
+										errors_per_reference_repeat.push_back(
+											std::fabs(correlation - reference_correlations.at(item_idx * num_repeats + repeat_idx)));
+
+									correlation_errors.at(profile_idx * num_pair_items + item_idx) =
+										Fuse::calculate_median_from_values(errors_per_reference_repeat);
+
+								}
+
+							} catch(...){
+								#pragma omp critical (analysis_exception)
+								analysis_exception = std::current_exception();
+							}
+						}
+
+					}
+
+					// The marginal metric compares each event's own distribution, so it has a task per (event, symbol)
+					for(unsigned int item_idx = 0; marginals && item_idx < num_event_items; item_idx++){
+
+						#pragma omp task firstprivate(profile, item_idx) shared(target, events, symbols, reference_marginals, uncalibrated_distances, analysis_exception)
+						{
+							try {
+								uncalibrated_distances.at(profile_idx * num_event_items + item_idx) = calculate_uncalibrated_marginal_distance(
+									target,
+									profile,
+									events.at(item_idx / num_symbols),
+									symbols.at(item_idx % num_symbols),
+									reference_marginals.cbegin() + item_idx * num_repeats,
+									num_repeats
+								);
+							} catch(...){
+								#pragma omp critical (analysis_exception)
+								analysis_exception = std::current_exception();
+							}
+						}
+
+					}
+
+				}
+
+			}
+
+		}
+	}
+
+	if(analysis_exception != nullptr)
+		std::rethrow_exception(analysis_exception);
+
+	// Results are reported per metric, in the requested order, with all of the TMD-based metrics reported together
+	for(auto metric : unique_metrics){
+
+		bool tmd_metric = std::find(tmd_metrics.begin(), tmd_metrics.end(), metric) != tmd_metrics.end();
+		if(tmd_metric && metric != tmd_metrics.front())
+			continue;
+
+		for(unsigned int profile_idx = 0; profile_idx < num_profiles; profile_idx++){
+
+			auto strategy = profiles_to_analyse.at(profile_idx).first;
+			auto repeat_idx = profiles_to_analyse.at(profile_idx).second;
+
+			if(metric == Fuse::Accuracy_metric::SPEARMANS){
+				report_rank_correlation_accuracy(target, strategy, repeat_idx, reference_pairs, num_symbols,
+					correlation_errors.cbegin() + profile_idx * num_pair_items, correlation_weights);
+
+			} else if(metric == Fuse::Accuracy_metric::MARGINAL_W1){
+				report_marginal_accuracy(target, strategy, repeat_idx, events, symbols,
+					uncalibrated_distances.cbegin() + profile_idx * num_event_items, marginal_calibrations, marginal_weights);
+
+			} else {
+				unsigned int first_tmd_idx = profile_idx * num_pair_items;
+				report_tmd_accuracy(target, tmd_metrics, strategy, repeat_idx, reference_pairs, symbols, reference_repeats_list,
+					uncalibrated_tmds.cbegin() + first_tmd_idx, fingerprints.cbegin() + first_tmd_idx);
+			}
+
+		}
+
+	}
+
+	spdlog::info("Finished analysing the accuracy of the combined profiles.");
+
+}
+
+void Fuse::generate_bc_sequence(
+		Fuse::Target& target
+		){
+
+	std::vector<std::pair<Fuse::Event_set, Fuse::Event_set> > combination_sequence =
+		Fuse::Sequence_generator::generate_bc_sequence(target, 3, 3);
+
+	// Convert to a proper combination sequence
+	Fuse::Combination_sequence sequence;
+	unsigned int next_part_idx = 0;
+	for(auto pair : combination_sequence){
+
+		Fuse::Sequence_part part;
+		part.part_idx = next_part_idx;
+		part.overlapping = pair.first;
+		part.unique = pair.second;
+
+		sequence.push_back(part);
+
+		next_part_idx++;
+	}
+	
+	target.set_combination_sequence(sequence);
+
+}
+
+// Stored TMDs between combinations of reference repeats, keyed by (pair index, symbol, repeat, repeat)
+typedef std::map<std::tuple<unsigned int, Fuse::Symbol, unsigned int, unsigned int>, Fuse::Calibration_combination_tmd>
+	Combination_tmd_store;
+
+/* A stored TMD is only reused if the statistics bounds are unchanged, as new reference repeats may have widened them
+*  It must also have been calculated with the current bin count and solver
+*/
+bool is_stored_combination_tmd_current(
+		const Fuse::Calibration_combination_tmd& combination_tmd,
+		const std::vector<std::pair<int64_t, int64_t> >& bounds_per_event
+		){
+
+	return combination_tmd.bounds_per_event == bounds_per_event
+		&& combination_tmd.bin_count == Fuse::Config::tmd_bin_count
+		&& combination_tmd.solver == Fuse::Config::tmd_solver;
+
+}
+
+/* Gets the symbol's TMD between a combination of reference repeats
+*  Returns true if the TMD was calculated, in which case it should be stored
+*/
+bool get_or_calculate_calibration_combination_tmd(
+		Fuse::Target& target,
+		const Fuse::Event_set& reference_pair,
+		unsigned int pair_idx,
+		const Fuse::Symbol& symbol,
+		const std::vector<unsigned int>& combination,
+		const Combination_tmd_store& stored_combination_tmds,
+		Fuse::Calibration_combination_tmd& combination_tmd
+		){
+
+	std::vector<std::pair<int64_t, int64_t> > bounds_per_event;
+	for(auto event : reference_pair)
+		bounds_per_event.push_back(target.get_statistics()->get_bounds(event, symbol));
+
+	auto stored_iter = stored_combination_tmds.find(std::make_tuple(pair_idx, symbol, combination.at(0), combination.at(1)));
+	if(stored_iter != stored_combination_tmds.end() && is_stored_combination_tmd_current(stored_iter->second, bounds_per_event)){
+		combination_tmd = stored_iter->second;
+		return false;
+	}
+
+	// Each repeat's signature appears in several combinations, so it is built once and cached by the target
+	auto signature_one = target.get_or_build_reference_signature(reference_pair, combination.at(0), symbol, bounds_per_event, Fuse::Config::tmd_bin_count);
+	auto signature_two = target.get_or_build_reference_signature(reference_pair, combination.at(1), symbol, bounds_per_event, Fuse::Config::tmd_bin_count);
+
+	combination_tmd.symbol = symbol;
+	combination_tmd.reference_idx = pair_idx;
+	combination_tmd.repeat_one = combination.at(0);
+	combination_tmd.repeat_two = combination.at(1);
+	combination_tmd.bounds_per_event = bounds_per_event;
+	combination_tmd.bin_count = Fuse::Config::tmd_bin_count;
+	combination_tmd.solver = Fuse::Config::tmd_solver;
+	combination_tmd.tmd = Fuse::Analysis::calculate_tmd_between_signatures(*signature_one, *signature_two, Fuse::Config::tmd_solver);
+	combination_tmd.num_instances = static_cast<double>(signature_one->num_instances);
+
+	return true;
+
+}
+
+/* Half-width of the distribution-free 95% confidence interval of the median, relative to the median
+*  The interval is between the order statistics given by the normal approximation to the binomial
+*/
+double calculate_median_relative_confidence(
+		std::vector<double> values
+		){
+
+	if(values.size() == 0)
+		return std::numeric_limits<double>::infinity();
+
+	std::sort(values.begin(), values.end());
+
+	double n = static_cast<double>(values.size());
+	double spread = 1.96 * std::sqrt(n) / 2.0;
+	int lower_idx = std::max(0, static_cast<int>(std::floor(n / 2.0 - spread)) - 1);
+	int upper_idx = std::min(static_cast<int>(values.size()) - 1, static_cast<int>(std::ceil(n / 2.0 + spread)) - 1);
+
+	double half_width = (values.at(upper_idx) - values.at(lower_idx)) / 2.0;
+	double median = Fuse::calculate_median_from_values(values);
+
+	if(half_width == 0.0)
+		return 0.0;
+	if(median <= 0.0)
+		return std::numeric_limits<double>::infinity();
+
+	return half_width / median;
+
+}
+
+Fuse::Calibration_tmd aggregate_calibration_tmd(
+		unsigned int pair_idx,
+		const Fuse::Event_set& reference_pair,
+		const Fuse::Symbol& symbol,
+		const std::vector<double>& tmds_per_combination,
+		const std::vector<double>& num_instances_list
+		){
+
+	Fuse::Stats tmd_stats = Fuse::calculate_stats_from_values(tmds_per_combination);
+	auto median_tmd = Fuse::calculate_median_from_values(tmds_per_combination);
+
+	Fuse::Stats num_instances_stats = Fuse::calculate_stats_from_values(num_instances_list);
+
+	if(num_instances_stats.min != num_instances_stats.max)
+		spdlog::warn("Reference distribution for {} and symbol '{}' has variable instance counts across combinations (from {} to {}).",
+			Fuse::Util::vector_to_string(reference_pair),
+			symbol,
+			num_instances_stats.min,
+			num_instances_stats.max
+		);
+
+	Fuse::Calibration_tmd calibration;
+	calibration.symbol = symbol;
+	calibration.events = reference_pair;
+	calibration.reference_idx = pair_idx;
+	calibration.min = tmd_stats.min;
+	calibration.max = tmd_stats.max;
+	calibration.mean = tmd_stats.mean;
+	calibration.std = tmd_stats.std;
+	calibration.median = median_tmd;
+	calibration.mean_num_instances = num_instances_stats.mean;
+	calibration.num_combinations = tmds_per_combination.size();
+	calibration.median_relative_confidence = calculate_median_relative_confidence(tmds_per_combination);
+
+	return calibration;
+
+}
+
+/* Orders the combinations of the repeats into rounds, where each round pairs every repeat at most once (the circle method)
+*  Sampling round by round therefore stratifies the sampled combinations evenly across the repeats
+*  The repeats and rounds are shuffled by the seed, and each combination is ordered by ascending repeat index
+*/
+std::vector<std::vector<std::vector<unsigned int> > > get_stratified_repeat_combination_rounds(
+		std::vector<unsigned int> repeats,
+		unsigned int seed
+		){
+
+	std::vector<std::vector<std::vector<unsigned int> > > rounds;
+	if(repeats.size() < 2)
+		return rounds;
+
+	std::mt19937 random_engine(seed);
+	std::shuffle(repeats.begin(), repeats.end(), random_engine);
+
+	// With an odd number of repeats, the repeat paired with the dummy sits out of the round
+	const unsigned int dummy = std::numeric_limits<unsigned int>::max();
+	if(repeats.size() % 2 == 1)
+		repeats.push_back(dummy);
+
+	unsigned int num_positions = repeats.size();
+	for(unsigned int round_idx = 0; round_idx < num_positions - 1; round_idx++){
+
+		// Position 0 is fixed, and the others rotate by one each round
+		std::vector<unsigned int> positions(num_positions);
+		positions.at(0) = repeats.at(0);
+		for(unsigned int position_idx = 1; position_idx < num_positions; position_idx++)
+			positions.at(position_idx) = repeats.at((round_idx + position_idx - 1) % (num_positions - 1) + 1);
+
+		std::vector<std::vector<unsigned int> > round;
+		for(unsigned int position_idx = 0; position_idx < num_positions / 2; position_idx++){
+			auto repeat_one = positions.at(position_idx);
+			auto repeat_two = positions.at(num_positions - 1 - position_idx);
+			if(repeat_one == dummy || repeat_two == dummy)
+				continue;
+			round.push_back({std::min(repeat_one, repeat_two), std::max(repeat_one, repeat_two)});
+		}
+
+		rounds.push_back(round);
+
+	}
+
+	std::shuffle(rounds.begin(), rounds.end(), random_engine);
+
+	return rounds;
+
+}
+
+/* Calibrates from a sample of the repeat combinations, rather than all of them
+*  Each (pair, symbol) samples a round of combinations at a time, until the median's confidence interval is within
+*  the tolerance, or all combinations have been sampled
+*  The sampling is deterministic, so rerunning after a complete calibration only reuses stored TMDs, and the pair is not
+*  recalibrated unless a TMD needed calculating
+*/
+void calculate_calibration_tmds_adaptively(
+		Fuse::Target& target,
+		const std::vector<Fuse::Event_set>& reference_pairs,
+		const std::vector<Fuse::Symbol>& symbols,
+		const std::vector<unsigned int>& reference_repeats_list,
+		const Combination_tmd_store& stored_combination_tmds
+		){
+
+	unsigned int num_symbols = symbols.size();
+
+	// Each pair is processed with a batch of others, so that the threads are occupied by the batch's sampled rounds
+	const unsigned int min_units_per_batch = 256;
+	unsigned int pairs_per_batch = std::max(1u, min_units_per_batch / std::max(1u, num_symbols));
+
+	unsigned long num_sampled = 0;
+	unsigned long num_calculated = 0;
+
+	for(unsigned int batch_start = 0; batch_start < reference_pairs.size(); batch_start += pairs_per_batch){
+
+		unsigned int batch_end = std::min(batch_start + pairs_per_batch, static_cast<unsigned int>(reference_pairs.size()));
+		unsigned int num_units = (batch_end - batch_start) * num_symbols;
+
+		// Per (pair, symbol) unit, ordered by pair then symbol
+		std::vector<std::vector<std::vector<std::vector<unsigned int> > > > rounds_per_unit(num_units);
+		std::vector<std::vector<Fuse::Calibration_combination_tmd> > sampled_per_unit(num_units);
+		std::vector<unsigned int> next_round_per_unit(num_units, 0);
+		std::vector<bool> converged_per_unit(num_units, false);
+		std::vector<bool> calculated_per_unit(num_units, false);
+
+		for(unsigned int unit_idx = 0; unit_idx < num_units; unit_idx++){
+			rounds_per_unit.at(unit_idx) = get_stratified_repeat_combination_rounds(reference_repeats_list, batch_start * num_symbols + unit_idx);
+			converged_per_unit.at(unit_idx) = rounds_per_unit.at(unit_idx).empty();
+		}
+
+		while(true){
+
+			// The next round of combinations of each unconverged unit
+			std::vector<std::pair<unsigned int, std::vector<unsigned int> > > sampled_combinations;
+			for(unsigned int unit_idx = 0; unit_idx < num_units; unit_idx++){
+				if(converged_per_unit.at(unit_idx))
+					continue;
+				for(auto& combination : rounds_per_unit.at(unit_idx).at(next_round_per_unit.at(unit_idx)))
+					sampled_combinations.push_back(std::make_pair(unit_idx, combination));
+				next_round_per_unit.at(unit_idx)++;
+			}
+
+			if(sampled_combinations.size() == 0)
+				break;
+
+			std::vector<Fuse::Calibration_combination_tmd> combination_tmds(sampled_combinations.size());
+			std::vector<char> calculated(sampled_combinations.size(), 0);
+			std::exception_ptr calibration_exception = nullptr;
+
+			#pragma omp parallel for schedule(dynamic)
+			for(unsigned int sample_idx = 0; sample_idx < sampled_combinations.size(); sample_idx++){
+
+				auto unit_idx = sampled_combinations.at(sample_idx).first;
+				auto pair_idx = batch_start + unit_idx / num_symbols;
+
+				try {
+					calculated.at(sample_idx) = get_or_calculate_calibration_combination_tmd(
+						target,
+						reference_pairs.at(pair_idx),
+						pair_idx,
+						symbols.at(unit_idx % num_symbols),
+						sampled_combinations.at(sample_idx).second,
+						stored_combination_tmds,
+						combination_tmds.at(sample_idx)
+					);
+				} catch(...){
+					#pragma omp critical (calibration_exception)
+					calibration_exception = std::current_exception();
+				}
+
+			}
+
+			if(calibration_exception != nullptr)
+				std::rethrow_exception(calibration_exception);
+
+			std::vector<Fuse::Calibration_combination_tmd> combination_tmds_to_store;
+			for(unsigned int sample_idx = 0; sample_idx < sampled_combinations.size(); sample_idx++){
+				auto unit_idx = sampled_combinations.at(sample_idx).first;
+				sampled_per_unit.at(unit_idx).push_back(combination_tmds.at(sample_idx));
+				if(calculated.at(sample_idx)){
+					combination_tmds_to_store.push_back(combination_tmds.at(sample_idx));
+					calculated_per_unit.at(unit_idx) = true;
+				}
+			}
+
+			target.save_calibration_combination_tmds_to_disk(combination_tmds_to_store);
+			num_sampled += sampled_combinations.size();
+			num_calculated += combination_tmds_to_store.size();
+
+			for(unsigned int unit_idx = 0; unit_idx < num_units; unit_idx++){
+
+				if(converged_per_unit.at(unit_idx))
+					continue;
+
+				if(next_round_per_unit.at(unit_idx) == rounds_per_unit.at(unit_idx).size()){
+					converged_per_unit.at(unit_idx) = true;
+					continue;
+				}
+
+				auto& sampled = sampled_per_unit.at(unit_idx);
+				if(sampled.size() < Fuse::Config::calibration_min_combinations)
+					continue;
+
+				std::vector<double> tmds;
+				tmds.reserve(sampled.size());
+				for(auto& combination_tmd : sampled)
+					tmds.push_back(combination_tmd.tmd);
+
+				if(calculate_median_relative_confidence(tmds) <= Fuse::Config::calibration_tolerance)
+					converged_per_unit.at(unit_idx) = true;
+
+			}
+
+		}
+
+		// Only pairs that are uncalibrated or needed a new TMD are (re)calibrated
+		std::vector<Fuse::Calibration_tmd> calibrations;
+		for(unsigned int pair_idx = batch_start; pair_idx < batch_end; pair_idx++){
+
+			auto& reference_pair = reference_pairs.at(pair_idx);
+			unsigned int first_unit_idx = (pair_idx - batch_start) * num_symbols;
+
+			bool requires_calibration = target.get_or_load_calibration_tmd(reference_pair, "all_symbols").first < 0.0;
+			for(unsigned int unit_idx = first_unit_idx; unit_idx < first_unit_idx + num_symbols; unit_idx++)
+				if(calculated_per_unit.at(unit_idx))
+					requires_calibration = true;
+
+			if(requires_calibration == false)
+				continue;
+
+			for(unsigned int unit_idx = first_unit_idx; unit_idx < first_unit_idx + num_symbols; unit_idx++){
+
+				std::vector<double> tmds;
+				std::vector<double> num_instances_list;
+				for(auto& combination_tmd : sampled_per_unit.at(unit_idx)){
+					tmds.push_back(combination_tmd.tmd);
+					num_instances_list.push_back(combination_tmd.num_instances);
+				}
+
+				calibrations.push_back(aggregate_calibration_tmd(pair_idx, reference_pair, symbols.at(unit_idx % num_symbols), tmds, num_instances_list));
+
+			}
+
+		}
+
+		target.save_reference_calibration_tmds_to_disk(calibrations);
+
+		spdlog::info("Adaptively calibrated {}/{} reference pairs, from {} sampled TMDs between reference repeats ({} newly calculated).",
+			batch_end,
+			reference_pairs.size(),
+			num_sampled,
+			num_calculated
+		);
+
+	}
+
+}
+
+void Fuse::calculate_calibration_tmds(
+		Fuse::Target& target
+		){
+
+	if(Fuse::Config::lazy_load_references == false)
+		target.load_reference_distributions();
+
+	auto reference_pairs = target.get_reference_pairs();
+
+	std::vector<unsigned int> reference_repeats_list(target.get_num_reference_repeats());
+	std::iota(reference_repeats_list.begin(), reference_repeats_list.end(), 0);
+	auto reference_repeat_combinations = Fuse::Util::get_unique_combinations(reference_repeats_list, 2);
+
+	spdlog::info("Calculating calibration TMDs for {} reference pairs and {} combinations of the reference repeats.",
+		reference_pairs.size(),
+		reference_repeat_combinations.size()
+	);
+
+	// We always get calibration TMDs for all symbols, and optionally for each individual symbol
+	std::vector<Fuse::Symbol> symbols = {"all_symbols"};
+	if(Fuse::Config::calculate_per_workfunction_tmds){
+		auto all_symbols = target.get_statistics()->get_unique_symbols(false);
+		symbols.insert(symbols.end(), all_symbols.begin(), all_symbols.end());
+	}
+
+	/* The TMD of each (pair, symbol, combination of repeats) is stored as it is calculated
+	*  So when reference repeats are added, only the combinations including a new repeat need to be calculated
+	*/
+	Combination_tmd_store stored_combination_tmds;
+	for(auto& combination_tmd : target.load_calibration_combination_tmds_from_disk()){
+		auto key = std::make_tuple(combination_tmd.reference_idx, combination_tmd.symbol, combination_tmd.repeat_one, combination_tmd.repeat_two);
+		stored_combination_tmds[key] = combination_tmd;
+	}
+
+	if(Fuse::Config::adaptive_calibration){
+		calculate_calibration_tmds_adaptively(target, reference_pairs, symbols, reference_repeats_list, stored_combination_tmds);
+		spdlog::info("Finished calculating calibration TMDs.");
+		return;
+	}
+
+	// Check which pairs we have already calibrated with every combination (assume if we have one symbol, we have all)
+	std::vector<unsigned int> pairs_to_calibrate;
+	unsigned int num_stored_tmds_to_reuse = 0;
+	for(unsigned int pair_idx = 0; pair_idx < reference_pairs.size(); pair_idx++){
+
+		unsigned int num_stored_tmds = 0;
+		for(auto symbol : symbols){
+
+			std::vector<std::pair<int64_t, int64_t> > bounds_per_event;
+			for(auto event : reference_pairs.at(pair_idx))
+				bounds_per_event.push_back(target.get_statistics()->get_bounds(event, symbol));
+
+			for(auto& combination : reference_repeat_combinations){
+				auto stored_iter = stored_combination_tmds.find(std::make_tuple(pair_idx, symbol, combination.at(0), combination.at(1)));
+				if(stored_iter != stored_combination_tmds.end() && is_stored_combination_tmd_current(stored_iter->second, bounds_per_event))
+					num_stored_tmds++;
+			}
+
+		}
+
+		auto calibration_tmd_pair = target.get_or_load_calibration_tmd(reference_pairs.at(pair_idx), "all_symbols");
+		if(calibration_tmd_pair.first >= 0.0 && num_stored_tmds == reference_repeat_combinations.size() * symbols.size()){
+			spdlog::debug("Already calibrated the event pair {}:{}.", pair_idx, Fuse::Util::vector_to_string(reference_pairs.at(pair_idx)));
+			continue;
+		}
+
+		pairs_to_calibrate.push_back(pair_idx);
+		num_stored_tmds_to_reuse += num_stored_tmds;
+	}
+
+	spdlog::info("Calibrating {} reference pairs, reusing {} previously calculated TMDs between reference repeats.",
+		pairs_to_calibrate.size(),
+		num_stored_tmds_to_reuse
+	);
+
+	unsigned int num_combinations = reference_repeat_combinations.size();
+	unsigned int num_tmds_per_pair = num_combinations * symbols.size();
+
+	/* Each (pair, symbol, combination) TMD is computed concurrently
+	*  Pairs are processed in batches that each have enough TMDs to occupy the threads, and each batch is written to the
+	*  calibration file once complete, in pair then symbol order, so that progress is kept if the calibration is interrupted
+	*/
+	const unsigned int min_tmds_per_batch = 4096;
+	unsigned int pairs_per_batch = std::max(1u, min_tmds_per_batch / std::max(1u, num_tmds_per_pair));
+
+	for(unsigned int batch_start = 0; batch_start < pairs_to_calibrate.size(); batch_start += pairs_per_batch){
+
+		unsigned int batch_end = std::min(batch_start + pairs_per_batch, static_cast<unsigned int>(pairs_to_calibrate.size()));
+		unsigned int num_tmds = (batch_end - batch_start) * num_tmds_per_pair;
+
+		spdlog::debug("Running calibration for the event pairs {} to {}.", pairs_to_calibrate.at(batch_start), pairs_to_calibrate.at(batch_end-1));
+
+		// Ordered by pair, then symbol, then combination of repeats
+		std::vector<Fuse::Calibration_combination_tmd> combination_tmds(num_tmds);
+		std::vector<char> calculated(num_tmds, 0);
+		std::exception_ptr calibration_exception = nullptr;
+
+		#pragma omp parallel for schedule(dynamic)
+		for(unsigned int tmd_idx = 0; tmd_idx < num_tmds; tmd_idx++){
+
+			auto pair_idx = pairs_to_calibrate.at(batch_start + tmd_idx / num_tmds_per_pair);
+
+			try {
+				calculated.at(tmd_idx) = get_or_calculate_calibration_combination_tmd(
+					target,
+					reference_pairs.at(pair_idx),
+					pair_idx,
+					symbols.at((tmd_idx % num_tmds_per_pair) / num_combinations),
+					reference_repeat_combinations.at(tmd_idx % num_combinations),
+					stored_combination_tmds,
+					combination_tmds.at(tmd_idx)
+				);
+			} catch(...){
+				#pragma omp critical (calibration_exception)
+				calibration_exception = std::current_exception();
+			}
+
+		}
+
+		if(calibration_exception != nullptr)
+			std::rethrow_exception(calibration_exception);
+
+		std::vector<Fuse::Calibration_combination_tmd> combination_tmds_to_store;
+		for(unsigned int tmd_idx = 0; tmd_idx < num_tmds; tmd_idx++)
+			if(calculated.at(tmd_idx))
+				combination_tmds_to_store.push_back(combination_tmds.at(tmd_idx));
+
+		target.save_calibration_combination_tmds_to_disk(combination_tmds_to_store);
+
+		// Now, for each symbol, average the tmds across the combinations to give the calibration tmd for the symbol for the pair
+		std::vector<Fuse::Calibration_tmd> calibrations;
+		calibrations.reserve((batch_end - batch_start) * symbols.size());
+
+		for(unsigned int tmd_idx = 0; tmd_idx < num_tmds; tmd_idx += num_combinations){
+
+			auto pair_idx = pairs_to_calibrate.at(batch_start + tmd_idx / num_tmds_per_pair);
+			auto& symbol = symbols.at((tmd_idx % num_tmds_per_pair) / num_combinations);
+
+			std::vector<double> tmds_per_combination;
+			std::vector<double> num_instances_list;
+			for(unsigned int combination_idx = 0; combination_idx < num_combinations; combination_idx++){
+				tmds_per_combination.push_back(combination_tmds.at(tmd_idx + combination_idx).tmd);
+				num_instances_list.push_back(combination_tmds.at(tmd_idx + combination_idx).num_instances);
+			}
+
+			calibrations.push_back(aggregate_calibration_tmd(pair_idx, reference_pairs.at(pair_idx), symbol, tmds_per_combination, num_instances_list));
+
+		}
+
+		target.save_reference_calibration_tmds_to_disk(calibrations);
+
+		spdlog::info("Calibrated {}/{} reference pairs.", batch_end, pairs_to_calibrate.size());
+
+	}
+
+	spdlog::info("Finished calculating calibration TMDs.");
+
+}
+
+void Fuse::build_reference_pyramids(
+		Fuse::Target& target
+		){
+
+	auto reference_pairs = target.get_reference_pairs();
+	unsigned int num_repeats = target.get_num_reference_repeats();
+
+	std::vector<Fuse::Symbol> symbols = {"all_symbols"};
+	if(Fuse::Config::calculate_per_workfunction_tmds){
+		auto all_symbols = target.get_statistics()->get_unique_symbols(false);
+		symbols.insert(symbols.end(), all_symbols.begin(), all_symbols.end());
+	}
+
+	spdlog::info("Building reference histogram pyramids of up to {} bins per event for {} reference pairs and {} reference repeats.",
+		1u << Fuse::Config::reference_pyramid_max_level,
+		reference_pairs.size(),
+		num_repeats
+	);
+
+	unsigned int num_files = reference_pairs.size() * num_repeats;
+	unsigned int num_up_to_date = 0;
+	std::exception_ptr pyramid_exception = nullptr;
+
+	#pragma omp parallel for schedule(dynamic)
+	for(unsigned int file_idx = 0; file_idx < num_files; file_idx++){
+
+		unsigned int pair_idx = file_idx / num_repeats;
+		unsigned int repeat_idx = file_idx % num_repeats;
+		auto& reference_pair = reference_pairs.at(pair_idx);
+
+		try {
+
+			std::vector<std::vector<std::pair<int64_t, int64_t> > > bounds_per_symbol;
+			for(auto symbol : symbols){
+				std::vector<std::pair<int64_t, int64_t> > bounds_per_event;
+				for(auto event : reference_pair)
+					bounds_per_event.push_back(target.get_statistics()->get_bounds(event, symbol));
+				bounds_per_symbol.push_back(bounds_per_event);
+			}
+
+			// Existing pyramids are kept if every symbol's was binned within the current bounds, to the maximum level
+			auto existing_pyramids = target.get_or_load_reference_pyramids(pair_idx, repeat_idx);
+
+			bool up_to_date = true;
+			for(unsigned int symbol_idx = 0; symbol_idx < symbols.size() && up_to_date; symbol_idx++){
+				auto existing_iter = existing_pyramids.find(symbols.at(symbol_idx));
+				up_to_date = existing_iter != existing_pyramids.end()
+					&& existing_iter->second->bounds_per_dimension == bounds_per_symbol.at(symbol_idx)
+					&& existing_iter->second->levels.size() > Fuse::Config::reference_pyramid_max_level;
+			}
+
+			if(up_to_date){
+				#pragma omp atomic
+				num_up_to_date++;
+				continue;
+			}
+
+			std::map<Fuse::Symbol, Fuse::Analysis::Tmd_histogram_pyramid> pyramids_per_symbol;
+
+			for(unsigned int symbol_idx = 0; symbol_idx < symbols.size(); symbol_idx++){
+
+				auto& symbol = symbols.at(symbol_idx);
+				auto& bounds_per_event = bounds_per_symbol.at(symbol_idx);
+
+				std::vector<Fuse::Symbol> constrained_symbols;
+				if(symbol != "all_symbols")
+					constrained_symbols = {symbol};
+
+				auto distribution = target.get_or_load_reference_distribution(reference_pair, repeat_idx, constrained_symbols);
+
+				pyramids_per_symbol[symbol] = Fuse::Analysis::construct_tmd_histogram_pyramid(
+					distribution,
+					bounds_per_event,
+					Fuse::Config::reference_pyramid_max_level
+				);
+
+			}
+
+			target.save_reference_pyramids_to_disk(pair_idx, repeat_idx, pyramids_per_symbol);
+
+		} catch(...){
+			#pragma omp critical (pyramid_exception)
+			pyramid_exception = std::current_exception();
+		}
+
+	}
+
+	if(pyramid_exception != nullptr)
+		std::rethrow_exception(pyramid_exception);
+
+	spdlog::info("Finished building the reference histogram pyramids, of which {} of {} were already up to date.",
+		num_up_to_date, num_files);
+
+}
+
+void Fuse::evaluate_tmd_solver_error(
+		Fuse::Target& target,
+		Fuse::Tmd_solver solver
+		){
+
+	if(Fuse::Config::lazy_load_references == false)
+		target.load_reference_distributions();
+
+	auto reference_pairs = target.get_reference_pairs();
+
+	std::vector<unsigned int> reference_repeats_list(target.get_num_reference_repeats());
+	std::iota(reference_repeats_list.begin(), reference_repeats_list.end(), 0);
+	auto reference_repeat_combinations = Fuse::Util::get_unique_combinations(reference_repeats_list, 2);
+
+	std::vector<Fuse::Symbol> symbols = {"all_symbols"};
+	if(Fuse::Config::calculate_per_workfunction_tmds){
+		auto all_symbols = target.get_statistics()->get_unique_symbols(false);
+		symbols.insert(symbols.end(), all_symbols.begin(), all_symbols.end());
+	}
+
+	unsigned int num_combinations = reference_repeat_combinations.size();
+	unsigned int num_tmds_per_pair = num_combinations * symbols.size();
+	unsigned int num_tmds = reference_pairs.size() * num_tmds_per_pair;
+
+	spdlog::info("Evaluating the {} TMD solver against the exact solver over {} reference TMDs.",
+		Fuse::convert_tmd_solver_to_string(solver),
+		num_tmds
+	);
+
+	std::vector<double> exact_tmds(num_tmds, 0.0);
+	std::vector<double> solver_tmds(num_tmds, 0.0);
+	double exact_seconds = 0.0;
+	double solver_seconds = 0.0;
+	std::exception_ptr evaluation_exception = nullptr;
+
+	#pragma omp parallel for schedule(dynamic) reduction(+:exact_seconds,solver_seconds)
+	for(unsigned int tmd_idx = 0; tmd_idx < num_tmds; tmd_idx++){
+
+		auto& reference_pair = reference_pairs.at(tmd_idx / num_tmds_per_pair);
+		auto& symbol = symbols.at((tmd_idx % num_tmds_per_pair) / num_combinations);
+		auto& combination = reference_repeat_combinations.at(tmd_idx % num_combinations);
+
+		try {
+
+			std::vector<std::pair<int64_t, int64_t> > bounds_per_event;
+			for(auto event : reference_pair)
+				bounds_per_event.push_back(target.get_statistics()->get_bounds(event, symbol));
+
+			auto signature_one = target.get_or_build_reference_signature(reference_pair, combination.at(0), symbol, bounds_per_event, Fuse::Config::tmd_bin_count);
+			auto signature_two = target.get_or_build_reference_signature(reference_pair, combination.at(1), symbol, bounds_per_event, Fuse::Config::tmd_bin_count);
+
+			auto start = std::chrono::steady_clock::now();
+			exact_tmds.at(tmd_idx) = Fuse::Analysis::calculate_tmd_between_signatures(*signature_one, *signature_two, Fuse::Tmd_solver::TRANSPORT_SIMPLEX);
+			auto middle = std::chrono::steady_clock::now();
+			solver_tmds.at(tmd_idx) = Fuse::Analysis::calculate_tmd_between_signatures(*signature_one, *signature_two, solver);
+			auto end = std::chrono::steady_clock::now();
+
+			exact_seconds += std::chrono::duration<double>(middle - start).count();
+			solver_seconds += std::chrono::duration<double>(end - middle).count();
+
+		} catch(...){
+			#pragma omp critical (evaluation_exception)
+			evaluation_exception = std::current_exception();
+		}
+
+	}
+
+	if(evaluation_exception != nullptr)
+		std::rethrow_exception(evaluation_exception);
+
+	// Relative errors are only defined where the exact TMD is non-zero
+	double sum_absolute_error = 0.0;
+	double max_absolute_error = 0.0;
+	double sum_relative_error = 0.0;
+	double max_relative_error = 0.0;
+	unsigned int num_relative = 0;
+
+	for(unsigned int tmd_idx = 0; tmd_idx < num_tmds; tmd_idx++){
+
+		double absolute_error = std::fabs(solver_tmds.at(tmd_idx) - exact_tmds.at(tmd_idx));
+		sum_absolute_error += absolute_error;
+		max_absolute_error = std::max(max_absolute_error, absolute_error);
+
+		if(exact_tmds.at(tmd_idx) > 0.0){
+			double relative_error = absolute_error / exact_tmds.at(tmd_idx);
+			sum_relative_error += relative_error;
+			max_relative_error = std::max(max_relative_error, relative_error);
+			num_relative++;
+		}
+
+	}
+
+	double mean_absolute_error = num_tmds > 0 ? sum_absolute_error / num_tmds : 0.0;
+	double mean_relative_error = num_relative > 0 ? sum_relative_error / num_relative : 0.0;
+
+	spdlog::info("The {} TMD solver has mean absolute error {} (max {}) and mean relative error {} (max {}), taking {} seconds compared to {} seconds for the exact solver.",
+		Fuse::convert_tmd_solver_to_string(solver),
+		mean_absolute_error,
+		max_absolute_error,
+		mean_relative_error,
+		max_relative_error,
+		solver_seconds,
+		exact_seconds
+	);
+
+	target.save_tmd_solver_error_to_disk(solver, num_tmds, mean_absolute_error, max_absolute_error,
+		mean_relative_error, max_relative_error, exact_seconds, solver_seconds);
 
 }
 
@@ -26,6 +26,13 @@ Fuse::Strategy Fuse::convert_string_to_strategy(std::string strategy_string, boo
 			return Fuse::Strategy::BC;
 	}
 
+	if(strategy_string == "auction"){
+		if(minimal)
+			throw std::runtime_error("Combination strategy AUCTION cannot be performed with minimal profiles.");
+		else
+			return Fuse::Strategy::AUCTION;
+	}
+
 	throw std::invalid_argument(
 		fmt::format("Could not resolve provided strategy '{}' with minimal={} to a supported combination strategy.",
 			strategy_string,
@@ -47,6 +54,7 @@ Fuse::Strategy Fuse::convert_string_to_strategy(std::string strategy_string){
 
 	if(strategy_string == "hem") return Fuse::Strategy::HEM;
 	if(strategy_string == "bc") return Fuse::Strategy::BC;
+	if(strategy_string == "auction") return Fuse::Strategy::AUCTION;
 
 	throw std::invalid_argument(
 		fmt::format("Could not resolve strategy '{}' to a supported combination strategy.", strategy_string)
@@ -67,6 +75,7 @@ std::string Fuse::convert_strategy_to_string(Fuse::Strategy strategy){
 		case Fuse::Strategy::LGL_MINIMAL: return "lgl_minimal";
 		case Fuse::Strategy::BC: return "bc";
 		case Fuse::Strategy::HEM: return "hem";
+		case Fuse::Strategy::AUCTION: return "auction";
 		default:
 			throw std::logic_error(
 					fmt::format("Could not resolve a configured strategy (integer enum value is {}) to a string representation.",
@@ -81,6 +90,7 @@ Fuse::Accuracy_metric Fuse::convert_string_to_metric(std::string metric_string){
 	if(metric_string == "epd") return Fuse::Accuracy_metric::EPD;
 	if(metric_string == "epd_tt") return Fuse::Accuracy_metric::EPD_TT;
 	if(metric_string == "spearmans") return Fuse::Accuracy_metric::SPEARMANS;
+	if(metric_string == "marginal_w1") return Fuse::Accuracy_metric::MARGINAL_W1;
 
 	throw std::invalid_argument(
 		fmt::format("Could not resolve metric '{}' to a supported accuracy metric.", metric_string)
@@ -94,6 +104,7 @@ std::string Fuse::convert_metric_to_string(Fuse::Accuracy_metric metric){
 		case Fuse::Accuracy_metric::EPD: return "epd";
 		case Fuse::Accuracy_metric::EPD_TT: return "epd_tt";
 		case Fuse::Accuracy_metric::SPEARMANS: return "spearmans";
+		case Fuse::Accuracy_metric::MARGINAL_W1: return "marginal_w1";
 		default:
 			throw std::logic_error(
 				fmt::format("Could not resolve a configured metric (integer enum value is {}) to a string representation.",
@@ -103,6 +114,33 @@ std::string Fuse::convert_metric_to_string(Fuse::Accuracy_metric metric){
 
 }
 
+Fuse::Tmd_solver Fuse::convert_string_to_tmd_solver(std::string solver_string){
+
+	if(solver_string == "fast_emd") return Fuse::Tmd_solver::FAST_EMD;
+	if(solver_string == "transport") return Fuse::Tmd_solver::TRANSPORT_SIMPLEX;
+	if(solver_string == "sinkhorn") return Fuse::Tmd_solver::SINKHORN;
+
+	throw std::invalid_argument(
+		fmt::format("Could not resolve TMD solver '{}' to a supported solver.", solver_string)
+	);
+
+}
+
+std::string Fuse::convert_tmd_solver_to_string(Fuse::Tmd_solver solver){
+
+	switch(solver){
+		case Fuse::Tmd_solver::FAST_EMD: return "fast_emd";
+		case Fuse::Tmd_solver::TRANSPORT_SIMPLEX: return "transport";
+		case Fuse::Tmd_solver::SINKHORN: return "sinkhorn";
+		default:
+			throw std::logic_error(
+				fmt::format("Could not resolve a configured TMD solver (integer enum value is {}) to a string representation.",
+					static_cast<int>(solver))
+			);
+	};
+
+}
+
 std::vector<int> Fuse::convert_label_str_to_label(std::string label_str){
 
 	label_str = label_str.substr(1,label_str.size()); // assuming label of form "[int,int,...]"
@@ -67,6 +67,23 @@ bool Fuse::comp_instances_by_label_dfs(Fuse::Instance_p a, Fuse::Instance_p b){
 	return (a_depth < b_depth);
 }
 
+uint64_t Fuse::encode_label(const std::vector<int>& label){
+
+	// FNV-1a over the label's depth and elements
+	uint64_t encoding = 14695981039346656037ULL;
+
+	encoding ^= label.size();
+	encoding *= 1099511628211ULL;
+
+	for(auto element : label){
+		encoding ^= static_cast<uint32_t>(element);
+		encoding *= 1099511628211ULL;
+	}
+
+	return encoding;
+
+}
+
 Fuse::Event_set Fuse::Instance::get_events(){
 
 	Fuse::Event_set events;
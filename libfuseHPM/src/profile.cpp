@@ -82,6 +82,14 @@ void Fuse::Execution_profile::add_event(Fuse::Event event){
 
 }
 
+void Fuse::Execution_profile::set_combination_residuals(Fuse::Combination_residuals residuals){
+	this->combination_residuals = residuals;
+}
+
+Fuse::Combination_residuals Fuse::Execution_profile::get_combination_residuals(){
+	return this->combination_residuals;
+}
+
 // If symbols is empty (or not provided), then this will return all instances for all symbols
 std::vector<Fuse::Instance_p> Fuse::Execution_profile::get_instances(
 		bool include_runtime,
@@ -107,6 +115,22 @@ std::vector<Fuse::Instance_p> Fuse::Execution_profile::get_instances(
 
 }
 
+size_t Fuse::Execution_profile::get_num_instances(bool include_runtime){
+
+	size_t num_instances = 0;
+
+	for(auto& symbol_pair : this->instances){
+
+		if(include_runtime == false && symbol_pair.first == "runtime")
+			continue;
+
+		num_instances += symbol_pair.second.size();
+	}
+
+	return num_instances;
+
+}
+
 void Fuse::Execution_profile::print_to_file(std::string output_file){
 
 	spdlog::info("Dumping the execution profile {} to output file {}.", this->tracefile, output_file);
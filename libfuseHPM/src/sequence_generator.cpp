@@ -14,8 +14,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <exception>
 #include <fstream>
 #include <iomanip>
+#include <limits>
 #include <map>
 #include <optional>
 #include <sstream>
@@ -90,7 +92,8 @@ std::vector<std::pair<Fuse::Event_set, Fuse::Event_set> > Fuse::Sequence_generat
 	root_node->analyse_accuracy_and_compute_metrics(
 		target,
 		all_combined_events,
-		reference_pairs
+		reference_pairs,
+		std::numeric_limits<double>::infinity() // nothing to compare the root against
 	);
 
 	/* Build the priority list */
@@ -159,7 +162,9 @@ std::vector<std::pair<Fuse::Event_set, Fuse::Event_set> > Fuse::Sequence_generat
 			nodes_by_tmd_mse,
 			nodes_by_cross_profile_tmd_mse,
 			profiled_event_sets,
-			previous_combinations);
+			previous_combinations,
+			previously_evaluated_nodes,
+			best_value);
 
 		spdlog::info("Finished computing a node. There are currently {} leaves in the tree to compute.", target_priority_list->size());
 
@@ -510,7 +515,9 @@ std::vector<Node_p> Fuse::Sequence_generator::compute_leaf_node(
 		std::vector<std::pair<double, Node_p> >& nodes_by_tmd_mse,
 		std::vector<std::pair<double, Node_p> >& nodes_by_cross_profile_tmd_mse,
 		std::vector<std::pair<Fuse::Event_set, std::string> >& profiled_event_sets,
-		std::vector<std::pair<std::string, std::string> >& recorded_combinations
+		std::vector<std::pair<std::string, std::string> >& recorded_combinations,
+		const std::vector<std::pair<Fuse::Event_set, double> >& previously_evaluated_nodes,
+		double best_complete_tmd_mse
 		){
 
 	std::vector<Node_p> complete_nodes;
@@ -565,14 +572,37 @@ std::vector<Node_p> Fuse::Sequence_generator::compute_leaf_node(
 			
 				/* evaluate the node */
 
+				bool complete = (child_node->sorted_combined_events.size() == target_events.size());
+
+				// Nodes added to the lists by other tasks may only lower this, so a snapshot is safe to prune against
+				double tmd_mse_pruning_threshold = std::numeric_limits<double>::infinity();
+				if(Fuse::Config::sequence_generator_tmd_bounds){
+					#pragma omp critical (priority_list)
+					{
+						tmd_mse_pruning_threshold = Fuse::Sequence_generator::get_tmd_mse_pruning_threshold(
+							child_node,
+							complete,
+							nodes_by_tmd_mse,
+							previously_evaluated_nodes,
+							best_complete_tmd_mse);
+					}
+				}
+
 				spdlog::debug("Combination and evaluating child node {} of {}.", child_idx+1, child_nodes.size());
 				auto number_of_combinations = child_node->combine_and_evaluate_node_profiles(
 					node, // this is the parent to combine with
 					target,
 					recorded_combinations,
-					reference_pairs);
+					reference_pairs,
+					tmd_mse_pruning_threshold);
+
+				if(child_node->pruned){
 
-				if(child_node->sorted_combined_events.size() == target_events.size()){
+					// It would only be removed from the priority lists later, so release its profiles now
+					child_node->execution_profiles.clear();
+					child_node->loaded = false;
+
+				} else if(complete){
 
 					spdlog::info("Finished computing a complete branch, with combined profiles: {}.",
 						Fuse::Util::vector_to_string(child_node->filenames));
@@ -863,6 +893,32 @@ std::vector<Node_p> Fuse::Sequence_generator::get_child_nodes(
 
 }
 	
+double Fuse::Sequence_generator::get_tmd_mse_pruning_threshold(
+		Node_p node,
+		bool complete,
+		const std::vector<std::pair<double, Node_p> >& nodes_by_tmd_mse,
+		const std::vector<std::pair<Fuse::Event_set, double> >& previously_evaluated_nodes,
+		double best_complete_tmd_mse
+		){
+
+	// A complete node is only of use if it is better than the best complete node so far
+	double threshold = std::numeric_limits<double>::infinity();
+	if(complete)
+		threshold = best_complete_tmd_mse;
+
+	// As in prune_priority_list, a node is discarded if a node with the same events has been or will be expanded with a better TMD MSE
+	for(auto previous_node : previously_evaluated_nodes)
+		if(previous_node.first == node->sorted_combined_events)
+			threshold = std::min(threshold, previous_node.second);
+
+	for(auto queued_node : nodes_by_tmd_mse)
+		if(queued_node.second->sorted_combined_events == node->sorted_combined_events)
+			threshold = std::min(threshold, queued_node.second->tmd_mse);
+
+	return threshold;
+
+}
+
 void Fuse::Sequence_generator::prune_priority_list(
 		std::vector<std::pair<double, Node_p> >* priority_list,
 		std::vector<std::pair<Fuse::Event_set, double> > previously_evaluated_nodes
@@ -1047,6 +1103,7 @@ Fuse::Sequence_generator::Node::Node(
 			loaded(false),
 			combined(false),
 			evaluated(false),
+			pruned(false),
 			epd(0.0),
 			tmd_mse(0.0),
 			cross_profile_epd(0.0),
@@ -1155,10 +1212,111 @@ void Fuse::Sequence_generator::Node::load_node_profiles(
 
 }
 
+// The uncalibrated TMD (or lower bound) of each signature, indexed as the signatures are, against the first reference repeat
+std::vector<double> calculate_uncalibrated_tmds_for_signatures(
+		Fuse::Target& target,
+		const std::vector<Fuse::Symbol>& symbols,
+		const std::vector<Fuse::Event_set>& event_pairs,
+		const std::vector<Fuse::Analysis::Tmd_signature>& signatures,
+		bool lower_bound_only
+		){
+
+	std::vector<unsigned int> reference_repeats_list = {0}; // just use the first reference repeat to analyse accuracy
+
+	unsigned int num_pairs = event_pairs.size();
+	unsigned int num_symbols = symbols.size();
+
+	std::vector<double> uncalibrated_tmds(signatures.size(), 0.0);
+	std::exception_ptr evaluation_exception = nullptr;
+
+	#pragma omp taskloop shared(uncalibrated_tmds, evaluation_exception)
+	for(unsigned int signature_idx = 0; signature_idx < signatures.size(); signature_idx++){
+
+		unsigned int pair_idx = (signature_idx / num_symbols) % num_pairs;
+		unsigned int symbol_idx = signature_idx % num_symbols;
+
+		try {
+
+			if(lower_bound_only)
+				uncalibrated_tmds.at(signature_idx) = Fuse::Analysis::calculate_uncalibrated_tmd_lower_bound_for_signature(
+					target,
+					symbols.at(symbol_idx),
+					event_pairs.at(pair_idx),
+					signatures.at(signature_idx),
+					reference_repeats_list,
+					Fuse::Config::tmd_bin_count);
+			else
+				uncalibrated_tmds.at(signature_idx) = Fuse::Analysis::calculate_uncalibrated_tmd_for_signature(
+					target,
+					symbols.at(symbol_idx),
+					event_pairs.at(pair_idx),
+					signatures.at(signature_idx),
+					reference_repeats_list,
+					Fuse::Config::tmd_bin_count,
+					Fuse::Config::sequence_generator_tmd_solver);
+
+		} catch(...){
+			#pragma omp critical (evaluation_exception)
+			evaluation_exception = std::current_exception();
+		}
+
+	} // implicit task wait follows
+
+	if(evaluation_exception != nullptr)
+		std::rethrow_exception(evaluation_exception);
+
+	return uncalibrated_tmds;
+
+}
+
+// Calibrates each pair's TMDs across symbols, per profile, then averages them across the profiles to give one TMD per reference index
+std::map<unsigned int, double> calibrate_and_average_tmds(
+		Fuse::Target& target,
+		const std::vector<Fuse::Symbol>& symbols,
+		const std::vector<Fuse::Event_set>& event_pairs,
+		const std::vector<unsigned int>& reference_pair_indexes,
+		unsigned int num_profiles,
+		const std::vector<double>& uncalibrated_tmds
+		){
+
+	unsigned int num_pairs = event_pairs.size();
+	unsigned int num_symbols = symbols.size();
+
+	std::map<unsigned int, double> tmd_per_reference_index;
+
+	for(unsigned int pair_idx = 0; pair_idx < num_pairs; pair_idx++){
+
+		double summed_tmd = 0.0;
+		for(unsigned int profile_idx = 0; profile_idx < num_profiles; profile_idx++){
+
+			std::map<Fuse::Symbol, double> uncalibrated_tmd_per_symbol;
+			for(unsigned int symbol_idx = 0; symbol_idx < num_symbols; symbol_idx++)
+				uncalibrated_tmd_per_symbol.insert(std::make_pair(symbols.at(symbol_idx),
+					uncalibrated_tmds.at((profile_idx * num_pairs + pair_idx) * num_symbols + symbol_idx)));
+
+			summed_tmd += Fuse::Analysis::calibrate_tmds_for_pair(
+				target,
+				event_pairs.at(pair_idx),
+				uncalibrated_tmd_per_symbol,
+				Fuse::Config::weighted_tmd);
+
+		}
+
+		// take the mean because this an expectation of what we get when repeat the measurement,
+		// where the measurement itself is the median across reference instances
+		tmd_per_reference_index.insert(std::make_pair(reference_pair_indexes.at(pair_idx), summed_tmd / num_profiles));
+
+	}
+
+	return tmd_per_reference_index;
+
+}
+
 void Fuse::Sequence_generator::Node::analyse_accuracy_and_compute_metrics(
 		Fuse::Target& target,
 		Fuse::Event_set all_combined_events,
-		std::vector<Fuse::Event_set> reference_pairs
+		std::vector<Fuse::Event_set> reference_pairs,
+		double tmd_mse_pruning_threshold
 		){
 
 	auto spec = this->combination_spec.at(this->combination_spec.size()-1);
@@ -1197,18 +1355,12 @@ void Fuse::Sequence_generator::Node::analyse_accuracy_and_compute_metrics(
 	
 	spdlog::debug("There are {} newly combined event pairs to analyse.", new_combined_event_pairs.size());
 
-	// map a reference index to a vector of tmds, one per merged profile repeat
-	// so that we can average them later to produce a single value
-	std::map<unsigned int, std::vector<double> > tmd_per_reference_per_repeat;
-
-	// Pre-allocate the vectors so that I can access thread-safely
-	// (i.e. no mututation to the map structure, only appending to the vectors)
-	for(unsigned int combined_pair_idx = 0; combined_pair_idx < new_combined_event_pairs.size(); combined_pair_idx++){
+	// The reference index of each newly combined pair, whose events are put in the same order as in the reference pair
+	std::vector<unsigned int> reference_pair_indexes;
+	reference_pair_indexes.reserve(new_combined_event_pairs.size());
 
-		auto map_iter = new_combined_event_pairs.begin();
-		std::advance(map_iter,combined_pair_idx);
+	for(auto& combined_pair : new_combined_event_pairs){
 
-		Fuse::Event_set combined_pair = (*map_iter);
 		if(combined_pair.size() != 2)
 			throw std::runtime_error(fmt::format("Found a combined pair that does not have two events: {}.",
 				Fuse::Util::vector_to_string(combined_pair)));
@@ -1222,12 +1374,10 @@ void Fuse::Sequence_generator::Node::analyse_accuracy_and_compute_metrics(
 				throw std::runtime_error("Could not find the event pair in the reference pairs.");
 		}
 
-		unsigned int reference_pair_index = std::distance(reference_pairs.begin(),it);
-		std::vector<double> empty_tmd_set;
-		tmd_per_reference_per_repeat.insert(std::make_pair(reference_pair_index, empty_tmd_set));
+		reference_pair_indexes.push_back(std::distance(reference_pairs.begin(),it));
 
 	}
-	
+
 	std::vector<Fuse::Symbol> symbols = {"all_symbols"};
 	if(Fuse::Config::calculate_per_workfunction_tmds){
 		auto all_symbols = target.get_statistics()->get_unique_symbols(false);
@@ -1237,62 +1387,105 @@ void Fuse::Sequence_generator::Node::analyse_accuracy_and_compute_metrics(
 	if(this->combined == false && this->combination_spec.size() > 1)
 		throw std::runtime_error("Assertion failed: the profiles should be combined before evaluated.");
 
-	for(auto combined_profile : this->execution_profiles){
+	// The new pairs must be assigned as cross or within profile pairs before any TMD MSE can be computed
+	this->update_profile_indexes(reference_pairs);
 
-		/* Analyse the acccuracy of each of these pair-projections, within this profile */
+	/* Build the signature of each pair-projection within each profile, for each symbol
+	*  These are indexed by ((profile_idx * num_pairs) + pair_idx) * num_symbols + symbol_idx
+	*/
 
-		#pragma omp taskloop shared(tmd_per_reference_per_repeat)
-		for(unsigned int combined_pair_idx = 0; combined_pair_idx < new_combined_event_pairs.size(); combined_pair_idx++){
+	unsigned int num_pairs = new_combined_event_pairs.size();
+	unsigned int num_symbols = symbols.size();
+	unsigned int num_signatures = this->execution_profiles.size() * num_pairs * num_symbols;
 
-			auto map_iter = new_combined_event_pairs.begin();
-			std::advance(map_iter,combined_pair_idx);
-	
-			Fuse::Event_set event_pair = (*map_iter);
-		
-			// Get the reference pair index of this merged event pair
-			auto it = std::find(reference_pairs.begin(),reference_pairs.end(),event_pair);
-			if(it == reference_pairs.end()){
-				std::reverse(event_pair.begin(), event_pair.end());
-				it = std::find(reference_pairs.begin(),reference_pairs.end(),event_pair);
-			}
-			
-			unsigned int reference_pair_index = std::distance(reference_pairs.begin(),it);
-			unsigned int reference_execution_index = target.get_reference_set_index_for_events(event_pair);
+	std::vector<Fuse::Analysis::Tmd_signature> signatures(num_signatures);
+	std::exception_ptr evaluation_exception = nullptr;
 
-			// Now, calculate the TMD for this pair
+	#pragma omp taskloop shared(signatures, evaluation_exception)
+	for(unsigned int signature_idx = 0; signature_idx < num_signatures; signature_idx++){
 
-			std::vector<unsigned int> reference_repeats_list = {0}; // just use the first reference repeat to analyse accuracy
-				
-			double calibrated_tmd_wrt_pair = Fuse::Analysis::calculate_calibrated_tmd_for_pair(
+		unsigned int profile_idx = signature_idx / (num_pairs * num_symbols);
+		unsigned int pair_idx = (signature_idx / num_symbols) % num_pairs;
+		unsigned int symbol_idx = signature_idx % num_symbols;
+
+		try {
+
+			signatures.at(signature_idx) = Fuse::Analysis::construct_profile_signature_for_symbol(
 				target,
-				symbols,
-				event_pair,
-				combined_profile,
-				reference_repeats_list,
-				Config::tmd_bin_count,
-				Config::weighted_tmd);
+				symbols.at(symbol_idx),
+				new_combined_event_pairs.at(pair_idx),
+				this->execution_profiles.at(profile_idx),
+				Config::tmd_bin_count);
+
+		} catch(...){
+			#pragma omp critical (evaluation_exception)
+			evaluation_exception = std::current_exception();
+		}
 
-			// we have pre-allocated the vectors so we are guaranteed to find the reference index
-			auto iter = tmd_per_reference_per_repeat.find(reference_pair_index);
-			iter->second.push_back(calibrated_tmd_wrt_pair);
+	} // implicit task wait follows
 
-		} // for each combined pair (implicit task wait follows)
+	if(evaluation_exception != nullptr)
+		std::rethrow_exception(evaluation_exception);
 
-	} // for each combined profile
-	
-	/* Now average the TMDs over each repeat combination and save in this node's tmds */
+	/* If this node is only worth keeping below a threshold, first check that cheap lower bounds on its new TMDs don't rule it out
+	*  Each bound is calibrated and averaged exactly as the TMD would be, and every step is non-decreasing, so the node's TMD MSE
+	*  computed with the bounds (and the parent's exact TMDs) is a lower bound on its true TMD MSE
+	*/
 
-	for(auto results_pair : tmd_per_reference_per_repeat){
+	if(Fuse::Config::sequence_generator_tmd_bounds && std::isfinite(tmd_mse_pruning_threshold) && num_signatures > 0){
 
-		std::vector<double> tmd_values = results_pair.second;
-		// take the mean because this an expectation of what we get when repeat the measurement,
-		// where the measurement itself is the median across reference instances
+		auto uncalibrated_tmd_bounds = calculate_uncalibrated_tmds_for_signatures(
+			target,
+			symbols,
+			new_combined_event_pairs,
+			signatures,
+			true);
+
+		std::map<unsigned int, double> bounded_tmds = this->tmds;
+		auto new_tmd_bounds = calibrate_and_average_tmds(
+			target,
+			symbols,
+			new_combined_event_pairs,
+			reference_pair_indexes,
+			this->execution_profiles.size(),
+			uncalibrated_tmd_bounds);
+		bounded_tmds.insert(new_tmd_bounds.begin(), new_tmd_bounds.end());
+
+		double bounded_tmd_mse = this->calculate_tmd_mse(bounded_tmds);
+
+		if(bounded_tmd_mse >= tmd_mse_pruning_threshold){
 
-		double mean_tmd = std::accumulate(tmd_values.begin(), tmd_values.end(), 0.0) / tmd_values.size(); 
-		this->tmds.insert(std::make_pair(results_pair.first, mean_tmd));
+			spdlog::debug("Pruning node with combination sequence {} without computing its TMDs, as its TMD MSE is at least {}, and it must be below {}.",
+				this->get_combination_spec_as_string(),
+				bounded_tmd_mse,
+				tmd_mse_pruning_threshold);
+
+			this->pruned = true;
+			return;
+
+		}
 
 	}
 
+	/* Analyse the acccuracy of each of these pair-projections, within each profile */
+
+	auto uncalibrated_tmds = calculate_uncalibrated_tmds_for_signatures(
+		target,
+		symbols,
+		new_combined_event_pairs,
+		signatures,
+		false);
+
+	auto new_tmds = calibrate_and_average_tmds(
+		target,
+		symbols,
+		new_combined_event_pairs,
+		reference_pair_indexes,
+		this->execution_profiles.size(),
+		uncalibrated_tmds);
+
+	this->tmds.insert(new_tmds.begin(), new_tmds.end());
+
 	/* Now compute the results of the node */
 	
 	this->compute_resulting_metrics(reference_pairs);
@@ -1306,7 +1499,8 @@ unsigned int Fuse::Sequence_generator::Node::combine_and_evaluate_node_profiles(
 		Node_p parent_node,
 		Fuse::Target& target,
 		std::vector<std::pair<std::string, std::string> >& recorded_combinations,
-		std::vector<Fuse::Event_set> reference_pairs
+		std::vector<Fuse::Event_set> reference_pairs,
+		double tmd_mse_pruning_threshold
 		){
 
 	// Now see if we have already done this combination before:
@@ -1396,7 +1590,8 @@ unsigned int Fuse::Sequence_generator::Node::combine_and_evaluate_node_profiles(
 	this->analyse_accuracy_and_compute_metrics(
 		target,
 		this->sorted_combined_events,
-		reference_pairs
+		reference_pairs,
+		tmd_mse_pruning_threshold
 	);
 
 	return number_of_required_combinations;
@@ -1490,8 +1685,6 @@ void Fuse::Sequence_generator::Node::compute_resulting_metrics(
 		std::vector<Fuse::Event_set> reference_pairs
 		){
 	
-	this->update_profile_indexes(reference_pairs);
-
 	std::vector<double> cross_profile_tmds;
 	double summed_squared_tmds = 0.0;
 
@@ -1550,6 +1743,30 @@ void Fuse::Sequence_generator::Node::compute_resulting_metrics(
 
 }
 	
+double Fuse::Sequence_generator::Node::calculate_tmd_mse(
+		const std::map<unsigned int, double>& tmds_per_reference_index
+		){
+
+	double summed_squared_tmds = 0.0;
+	unsigned int num_tmds = 0;
+
+	for(auto indexes : {&this->cross_profile_reference_indexes, &this->within_profile_reference_indexes}){
+		for(auto ref_idx : *indexes){
+
+			auto it = tmds_per_reference_index.find(ref_idx);
+			if(it == tmds_per_reference_index.end())
+				throw std::runtime_error(fmt::format("Cannot find TMD for the reference pair index {}.", ref_idx));
+
+			summed_squared_tmds += std::pow((it->second),2.0);
+			num_tmds++;
+
+		}
+	}
+
+	return summed_squared_tmds / num_tmds;
+
+}
+
 std::string Fuse::Sequence_generator::Node::get_combination_spec_as_string(){
 
 	std::stringstream ss;
@@ -35,6 +35,30 @@ std::vector<Fuse::Symbol> Fuse::Statistics::get_unique_symbols(bool include_runt
 	return symbols;
 }
 
+Fuse::Statistics_p Fuse::Statistics::snapshot_events(
+		Fuse::Event_set events
+		){
+
+	// The snapshot has no running stats, so is not backed by the statistics file
+	Fuse::Statistics_p snapshot(new Fuse::Statistics(""));
+
+	#pragma omp critical (statistics)
+	{
+		for(auto symbol_iter : this->stats_by_symbol){
+			for(auto event : events){
+
+				auto event_iter = symbol_iter.second.find(event);
+				if(event_iter != symbol_iter.second.end())
+					snapshot->stats_by_symbol[symbol_iter.first][event] = event_iter->second;
+
+			}
+		}
+	}
+
+	return snapshot;
+
+}
+
 void Fuse::Statistics::load(){
 
 	spdlog::debug("Loading statistics from {}.", this->statistics_filename);
@@ -255,15 +279,36 @@ std::pair<int64_t,int64_t> Fuse::Statistics::get_bounds(
 		Fuse::Symbol symbol
 		){
 
-	auto symbol_iter = this->stats_by_symbol.find(symbol);
-	if(symbol_iter == this->stats_by_symbol.end())
+	Fuse::Stats stats;
+	if(this->find_stats(event, symbol, stats) == false)
 		throw std::runtime_error(fmt::format("No bounds exist for symbol {} and event {}.", symbol, event));
 
-	auto event_iter = symbol_iter->second.find(event);
-	if(event_iter == symbol_iter->second.end())
-		throw std::runtime_error(fmt::format("No bounds exist for symbol {} and event {}.", symbol, event));
+	return std::make_pair(static_cast<int64_t>(stats.min), static_cast<int64_t>(stats.max));
+
+}
+
+bool Fuse::Statistics::find_stats(
+		Fuse::Event event,
+		Fuse::Symbol symbol,
+		Fuse::Stats& stats
+		){
+
+	bool found = false;
+
+	// Readers may run concurrently, e.g. during parallel per-symbol combination
+	#pragma omp critical (statistics)
+	{
+		auto symbol_iter = this->stats_by_symbol.find(symbol);
+		if(symbol_iter != this->stats_by_symbol.end()){
+			auto event_iter = symbol_iter->second.find(event);
+			if(event_iter != symbol_iter->second.end()){
+				stats = event_iter->second;
+				found = true;
+			}
+		}
+	}
 
-	return std::make_pair(static_cast<int64_t>(event_iter->second.min), static_cast<int64_t>(event_iter->second.max));
+	return found;
 
 }
 
@@ -272,15 +317,11 @@ double Fuse::Statistics::get_mean(
 		Fuse::Symbol symbol
 		){
 
-	auto symbol_iter = this->stats_by_symbol.find(symbol);
-	if(symbol_iter == this->stats_by_symbol.end())
-		throw std::runtime_error(fmt::format("No mean statistic exists for symbol {} and event {}.", symbol, event));
-
-	auto event_iter = symbol_iter->second.find(event);
-	if(event_iter == symbol_iter->second.end())
+	Fuse::Stats stats;
+	if(this->find_stats(event, symbol, stats) == false)
 		throw std::runtime_error(fmt::format("No mean statistic exists for symbol {} and event {}.", symbol, event));
 
-	return event_iter->second.mean;
+	return stats.mean;
 
 }
 
@@ -289,15 +330,11 @@ double Fuse::Statistics::get_std(
 		Fuse::Symbol symbol
 		){
 
-	auto symbol_iter = this->stats_by_symbol.find(symbol);
-	if(symbol_iter == this->stats_by_symbol.end())
-		throw std::runtime_error(fmt::format("No std statistic exists for symbol {} and event {}.", symbol, event));
-
-	auto event_iter = symbol_iter->second.find(event);
-	if(event_iter == symbol_iter->second.end())
+	Fuse::Stats stats;
+	if(this->find_stats(event, symbol, stats) == false)
 		throw std::runtime_error(fmt::format("No std statistic exists for symbol {} and event {}.", symbol, event));
 
-	return event_iter->second.std;
+	return stats.std;
 
 }
 
@@ -361,17 +398,20 @@ void Fuse::Statistics::save_stats_for_symbol(
 	stats.mean = mean;
 	stats.std = std;
 
-	auto symbol_iter = this->stats_by_symbol.find(symbol);
-	if(symbol_iter == this->stats_by_symbol.end()){
+	#pragma omp critical (statistics)
+	{
+		auto symbol_iter = this->stats_by_symbol.find(symbol);
+		if(symbol_iter == this->stats_by_symbol.end()){
 
-		std::map<Fuse::Event, Fuse::Stats> stats_by_event;
-		stats_by_event.insert(std::make_pair(event, stats));
-		this->stats_by_symbol.insert(std::make_pair(symbol, stats_by_event));
+			std::map<Fuse::Event, Fuse::Stats> stats_by_event;
+			stats_by_event.insert(std::make_pair(event, stats));
+			this->stats_by_symbol.insert(std::make_pair(symbol, stats_by_event));
 
-	} else {
+		} else {
 
-		symbol_iter->second[event] = stats; // Will replace current values
+			symbol_iter->second[event] = stats; // Will replace current values
 
+		}
 	}
 }
 
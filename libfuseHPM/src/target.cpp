@@ -11,6 +11,7 @@
 #include "spdlog/spdlog.h"
 
 #include <algorithm>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 
@@ -326,30 +327,49 @@ void Fuse::Target::generate_json_optional(nlohmann::json& j){
 
 void Fuse::Target::save(){
 
-	if(modified == false){
-		spdlog::warn("Attempted to save a Fuse target JSON that hasn't been modified.");
-		return;
-	}
-
 	std::string json_filename = this->target_directory + "/fuse.json";
-	spdlog::trace("Saving Fuse target to json: {}.", json_filename);
 
-	nlohmann::json j;
+	bool was_modified = true;
+	bool opened = true;
 
-	this->generate_json_mandatory(j);
-	this->generate_json_optional(j);
+	/* Combinations may be registered concurrently, so the snapshot and the write are under the same lock as registration
+	*  Otherwise an older snapshot could be written over a newer one, losing the registrations in between
+	*/
+	#pragma omp critical (target_combinations)
+	{
+		if(modified == false){
+			was_modified = false;
+		} else {
 
-	std::ofstream out(json_filename);
+			nlohmann::json j;
+			this->generate_json_mandatory(j);
+			this->generate_json_optional(j);
 
-	if(out.is_open() == false)
-		throw std::runtime_error(fmt::format("Cannot open the JSON file for writing: {}", json_filename));
+			spdlog::trace("Saving Fuse target to json: {}.", json_filename);
+
+			std::ofstream out(json_filename);
+
+			if(out.is_open() == false){
+				opened = false;
+			} else {
+				out << std::setw(2) << j;
+				out.close();
+
+				// Save statistics too, if necessary
+				if(this->statistics != nullptr)
+					this->statistics->save();
+			}
+
+		}
+	}
 
-	out << std::setw(2) << j;
-	out.close();
+	if(was_modified == false){
+		spdlog::warn("Attempted to save a Fuse target JSON that hasn't been modified.");
+		return;
+	}
 
-	// Save statistics too, if necessary
-	if(this->statistics != nullptr)
-		this->statistics->save();
+	if(opened == false)
+		throw std::runtime_error(fmt::format("Cannot open the JSON file for writing: {}", json_filename));
 
 }
 
@@ -414,6 +434,21 @@ std::string Fuse::Target::get_combination_filename(
 	return ss.str();
 }
 
+std::string Fuse::Target::get_combination_residuals_filename(
+		Fuse::Strategy strategy,
+		unsigned int repeat_idx
+		){
+
+	std::stringstream ss;
+	ss << this->target_directory << "/" << this->combinations_directory << "/";
+	ss << Fuse::convert_strategy_to_string(strategy);
+
+	Fuse::Util::check_or_create_directory(ss.str());
+
+	ss << "/combination_" << repeat_idx << "_residuals.csv";
+	return ss.str();
+}
+
 std::string Fuse::Target::get_target_binary(){
 	return (this->binary_directory + "/" + this->binary);
 }
@@ -483,6 +518,16 @@ std::string Fuse::Target::get_calibration_tmds_filename(){
 	return ss.str();
 }
 
+std::string Fuse::Target::get_calibration_combination_tmds_filename(){
+
+	auto references_directory = this->get_references_directory();
+
+	std::stringstream ss;
+	ss << references_directory << "/calibration_combination_tmds_" << Fuse::Config::tmd_bin_count << ".bin";
+
+	return ss.str();
+}
+
 std::string Fuse::Target::get_results_filename(
 		Fuse::Accuracy_metric metric
 		){
@@ -495,6 +540,72 @@ std::string Fuse::Target::get_results_filename(
 	return ss.str();
 }
 
+std::string Fuse::Target::get_confidence_intervals_filename(
+		Fuse::Accuracy_metric metric
+		){
+
+	auto results_directory = this->get_results_directory();
+
+	std::stringstream ss;
+	ss << results_directory << "/" << Fuse::convert_metric_to_string(metric) << "_confidence_intervals.txt";
+
+	return ss.str();
+}
+
+std::string Fuse::Target::get_tmd_solver_error_filename(){
+
+	auto results_directory = this->get_results_directory();
+
+	std::stringstream ss;
+	ss << results_directory << "/tmd_solver_error_results.txt";
+
+	return ss.str();
+}
+
+std::string Fuse::Target::get_accuracy_cache_filename(){
+
+	auto results_directory = this->get_results_directory();
+
+	std::stringstream ss;
+	ss << results_directory << "/accuracy_cache.bin";
+
+	return ss.str();
+}
+
+std::string Fuse::Target::get_reference_signatures_filename_for(
+		unsigned int pair_idx,
+		unsigned int repeat_idx
+		){
+
+	auto references_dir = this->get_references_directory();
+	std::stringstream ss;
+	ss << references_dir << "/signatures_" << pair_idx << "_" << repeat_idx << ".bin";
+
+	return ss.str();
+}
+
+std::string Fuse::Target::get_reference_pyramids_filename_for(
+		unsigned int pair_idx,
+		unsigned int repeat_idx
+		){
+
+	auto references_dir = this->get_references_directory();
+	std::stringstream ss;
+	ss << references_dir << "/pyramids_" << pair_idx << "_" << repeat_idx << ".bin";
+
+	return ss.str();
+}
+
+std::string Fuse::Target::get_combination_benchmark_filename(){
+
+	auto results_directory = this->get_results_directory();
+
+	std::stringstream ss;
+	ss << results_directory << "/combination_benchmark_results.txt";
+
+	return ss.str();
+}
+
 Fuse::Statistics_p Fuse::Target::get_statistics(){
 	if(this->statistics == nullptr)
 		throw std::runtime_error("Tried to get event statistics, but they have not yet been initialized.");
@@ -509,37 +620,46 @@ void Fuse::Target::store_loaded_sequence_profile(
 		bool minimal
 		){
 
-	std::map<unsigned int, std::map<unsigned int, Fuse::Profile_p> >::iterator repeat_map_iter;
+	bool already_exists = false;
+
+	#pragma omp critical (target_sequence_profiles)
+	{
+		auto& loaded_sequence_profiles = minimal ? this->loaded_minimal_sequence_profiles : this->loaded_non_minimal_sequence_profiles;
 
-	bool repeat_profiles_exist = false;
+		auto repeat_map_iter = loaded_sequence_profiles.find(repeat_index);
+		if(repeat_map_iter != loaded_sequence_profiles.end()){
 
-	if(minimal){
-		repeat_map_iter = this->loaded_minimal_sequence_profiles.find(repeat_index);
-		if(repeat_map_iter != this->loaded_minimal_sequence_profiles.end())
-			repeat_profiles_exist = true;
-	} else {
-		repeat_map_iter = this->loaded_non_minimal_sequence_profiles.find(repeat_index);
-		if(repeat_map_iter != this->loaded_non_minimal_sequence_profiles.end())
-			repeat_profiles_exist = true;
+			auto part_iter = repeat_map_iter->second.find(part.part_idx);
+			if(part_iter == repeat_map_iter->second.end())
+				repeat_map_iter->second.insert(std::make_pair(part.part_idx, execution_profile));
+			else
+				already_exists = true;
+
+		} else {
+
+			std::map<unsigned int, Fuse::Profile_p> profiles_for_repeat_index;
+			profiles_for_repeat_index.insert(std::make_pair(part.part_idx, execution_profile));
+			loaded_sequence_profiles.insert(std::make_pair(repeat_index, profiles_for_repeat_index));
+
+		}
 	}
 
-	if(repeat_profiles_exist){
+	if(already_exists)
+		throw std::logic_error("Attempted to add a loaded sequence profile, which already exists.");
 
-		auto part_iter = repeat_map_iter->second.find(part.part_idx);
-		if(part_iter == repeat_map_iter->second.end())
-			repeat_map_iter->second.insert(std::make_pair(part.part_idx, execution_profile));
-		else
-			throw std::logic_error("Attempted to add a loaded sequence profile, which already exists.");
+}
 
-	} else {
+void Fuse::Target::release_sequence_profiles(
+		unsigned int repeat_index,
+		bool minimal
+		){
 
-		std::map<unsigned int, Fuse::Profile_p> profiles_for_repeat_index;
-		profiles_for_repeat_index.insert(std::make_pair(part.part_idx, execution_profile));
+	#pragma omp critical (target_sequence_profiles)
+	{
 		if(minimal)
-			this->loaded_minimal_sequence_profiles.insert(std::make_pair(repeat_index, profiles_for_repeat_index));
+			this->loaded_minimal_sequence_profiles.erase(repeat_index);
 		else
-			this->loaded_non_minimal_sequence_profiles.insert(std::make_pair(repeat_index, profiles_for_repeat_index));
-
+			this->loaded_non_minimal_sequence_profiles.erase(repeat_index);
 	}
 
 }
@@ -595,16 +715,15 @@ std::vector<Fuse::Profile_p> Fuse::Target::load_and_retrieve_sequence_profiles(
 	spdlog::info("Loading the {} sequence profiles for repeat index {}.", minimal_str, repeat_idx);
 
 	// Do I have any loaded profiles for this repeat index?
-	bool repeat_profiles_exist = false;
-	std::map<unsigned int, std::map<unsigned int, Fuse::Profile_p> >::iterator repeat_map_iter;
-	if(minimal){
-		repeat_map_iter = this->loaded_minimal_sequence_profiles.find(repeat_idx);
-		if(repeat_map_iter != this->loaded_minimal_sequence_profiles.end())
-			repeat_profiles_exist = true;
-	} else {
-		repeat_map_iter = this->loaded_non_minimal_sequence_profiles.find(repeat_idx);
-		if(repeat_map_iter != this->loaded_non_minimal_sequence_profiles.end())
-			repeat_profiles_exist = true;
+	std::map<unsigned int, Fuse::Profile_p> loaded_profiles_for_repeat;
+
+	#pragma omp critical (target_sequence_profiles)
+	{
+		auto& loaded_sequence_profiles = minimal ? this->loaded_minimal_sequence_profiles : this->loaded_non_minimal_sequence_profiles;
+
+		auto repeat_map_iter = loaded_sequence_profiles.find(repeat_idx);
+		if(repeat_map_iter != loaded_sequence_profiles.end())
+			loaded_profiles_for_repeat = repeat_map_iter->second;
 	}
 
 	std::vector<Fuse::Profile_p> sequence_profiles;
@@ -612,12 +731,10 @@ std::vector<Fuse::Profile_p> Fuse::Target::load_and_retrieve_sequence_profiles(
 	for(auto part : sequence){
 
 		// Have I already got the sequence profile loaded?
-		if(repeat_profiles_exist){
-			auto part_iter = repeat_map_iter->second.find(part.part_idx);
-			if(part_iter != repeat_map_iter->second.end()){
-				sequence_profiles.push_back(part_iter->second);
-				continue;
-			}
+		auto part_iter = loaded_profiles_for_repeat.find(part.part_idx);
+		if(part_iter != loaded_profiles_for_repeat.end()){
+			sequence_profiles.push_back(part_iter->second);
+			continue;
 		}
 
 		// If here, it is not loaded, so load it
@@ -646,19 +763,23 @@ void Fuse::Target::register_new_combined_profile(
 		Fuse::Profile_p execution_profile
 		){
 
-	auto strategy_iter = this->combined_indexes.find(strategy);
-	if(strategy_iter == this->combined_indexes.end()){
-		std::vector<unsigned int> indexes = {repeat_idx};
-		this->combined_indexes.insert(std::make_pair(strategy, indexes));
-	}
-	else
-		strategy_iter->second.push_back(repeat_idx);
-
-	// Now dump the execution profile to file
+	// Dump the execution profile to file, outside of the lock as each combination has its own file
 	std::string combined_instances_filename = this->get_combination_filename(strategy, repeat_idx);
 	execution_profile->print_to_file(combined_instances_filename);
+	this->save_combination_residuals_to_disk(strategy, repeat_idx, execution_profile->get_combination_residuals());
 
-	this->modified = true;
+	#pragma omp critical (target_combinations)
+	{
+		auto strategy_iter = this->combined_indexes.find(strategy);
+		if(strategy_iter == this->combined_indexes.end()){
+			std::vector<unsigned int> indexes = {repeat_idx};
+			this->combined_indexes.insert(std::make_pair(strategy, indexes));
+		}
+		else
+			strategy_iter->second.push_back(repeat_idx);
+
+		this->modified = true;
+	}
 }
 
 unsigned int Fuse::Target::get_num_combined_profiles(Fuse::Strategy strategy){
@@ -677,35 +798,40 @@ void Fuse::Target::store_combined_profile(
 			Fuse::Profile_p combined_profile
 		){
 
-	auto combined_iter = this->loaded_combined_profiles.find(strategy);
-	if(combined_iter == this->loaded_combined_profiles.end()){
+	#pragma omp critical (target_combinations)
+	{
+		auto combined_iter = this->loaded_combined_profiles.find(strategy);
+		if(combined_iter == this->loaded_combined_profiles.end()){
 
-		std::map<unsigned int, Fuse::Profile_p> combined_profiles;
-		combined_profiles.insert(std::make_pair(repeat_idx, combined_profile));
-		this->loaded_combined_profiles.insert(std::make_pair(strategy, combined_profiles));
+			std::map<unsigned int, Fuse::Profile_p> combined_profiles;
+			combined_profiles.insert(std::make_pair(repeat_idx, combined_profile));
+			this->loaded_combined_profiles.insert(std::make_pair(strategy, combined_profiles));
 
-	} else {
+		} else {
 
-		if(combined_iter->second.find(repeat_idx) != combined_iter->second.end())
-			spdlog::warn("When storing the combined profile for repeat index {} via strategy {}, a previously combined profile was found. The old combination will be overwritten.",
-				repeat_idx, Fuse::convert_strategy_to_string(strategy));
+			if(combined_iter->second.find(repeat_idx) != combined_iter->second.end())
+				spdlog::warn("When storing the combined profile for repeat index {} via strategy {}, a previously combined profile was found. The old combination will be overwritten.",
+					repeat_idx, Fuse::convert_strategy_to_string(strategy));
 
-		combined_iter->second[repeat_idx] = combined_profile;
+			combined_iter->second[repeat_idx] = combined_profile;
 
+		}
 	}
 
 }
 
 bool Fuse::Target::combined_profile_exists(Fuse::Strategy strategy, unsigned int repeat_idx){
 
-	auto strategy_iter = this->combined_indexes.find(strategy);
-	if(strategy_iter == this->combined_indexes.end())
-		return false;
+	bool exists = false;
 
-	if(std::find(strategy_iter->second.begin(), strategy_iter->second.end(), repeat_idx) == strategy_iter->second.end())
-		return false;
+	#pragma omp critical (target_combinations)
+	{
+		auto strategy_iter = this->combined_indexes.find(strategy);
+		if(strategy_iter != this->combined_indexes.end())
+			exists = std::find(strategy_iter->second.begin(), strategy_iter->second.end(), repeat_idx) != strategy_iter->second.end();
+	}
 
-	return true;
+	return exists;
 
 }
 
@@ -950,27 +1076,23 @@ std::vector<std::vector<int64_t> > Fuse::Target::get_or_load_reference_distribut
 	{
 		auto reference_set_iter = this->loaded_reference_distributions.find(reference_set_idx);
 
-		// Load it if it is not loaded
 		if(reference_set_iter == this->loaded_reference_distributions.end()){
-
-			reference_distribution_per_symbol = this->load_reference_distribution_from_disk(reference_set_idx, repeat_idx);
 			was_loaded = false;
-
 		} else {
 
 			auto repeat_iter = reference_set_iter->second.find(repeat_idx);
-			if(repeat_iter == reference_set_iter->second.end()){
-
-				reference_distribution_per_symbol = this->load_reference_distribution_from_disk(reference_set_idx, repeat_idx);
+			if(repeat_iter == reference_set_iter->second.end())
 				was_loaded = false;
-
-			} else {
-
+			else
 				reference_distribution_per_symbol = repeat_iter->second;
-			}
+
 		}
 	}
 
+	// Load it if it is not loaded, outside of the lock so that concurrent callers may read different files
+	if(was_loaded == false)
+		reference_distribution_per_symbol = this->load_reference_distribution_from_disk(reference_set_idx, repeat_idx);
+
 	// Now filter for symbols
 	if(symbols.size() == 0){
 		symbols.reserve(reference_distribution_per_symbol.size());
@@ -979,6 +1101,17 @@ std::vector<std::vector<int64_t> > Fuse::Target::get_or_load_reference_distribut
 		}
 	}
 
+	// The reference set may contain more events than were requested, so take only the requested events' values
+	auto reference_set = this->reference_sets.at(reference_set_idx);
+	std::vector<unsigned int> columns;
+	for(auto event : events)
+		columns.push_back(std::distance(reference_set.begin(), std::find(reference_set.begin(), reference_set.end(), event)));
+
+	bool requires_projection = (columns.size() != reference_set.size());
+	for(decltype(columns.size()) column_idx = 0; column_idx < columns.size(); column_idx++)
+		if(columns.at(column_idx) != column_idx)
+			requires_projection = true;
+
 	std::vector<std::vector<int64_t> > concatenated_distribution;
 	for(auto symbol : symbols){
 		auto values_iter = reference_distribution_per_symbol.find(symbol);
@@ -986,7 +1119,19 @@ std::vector<std::vector<int64_t> > Fuse::Target::get_or_load_reference_distribut
 			throw std::runtime_error(fmt::format("Cannot retrieve instances for symbol {} as this symbol does not exist.", symbol));
 
 		concatenated_distribution.reserve(concatenated_distribution.size() + values_iter->second.size());
-		concatenated_distribution.insert(concatenated_distribution.end(), values_iter->second.begin(), values_iter->second.end());
+
+		if(requires_projection == false){
+			concatenated_distribution.insert(concatenated_distribution.end(), values_iter->second.begin(), values_iter->second.end());
+			continue;
+		}
+
+		for(auto& instance_values : values_iter->second){
+			std::vector<int64_t> projected_values;
+			projected_values.reserve(columns.size());
+			for(auto column : columns)
+				projected_values.push_back(instance_values.at(column));
+			concatenated_distribution.push_back(projected_values);
+		}
 	}
 
 	if(was_loaded == false && Config::lazy_load_references == false)
@@ -1000,6 +1145,87 @@ std::vector<std::vector<int64_t> > Fuse::Target::get_or_load_reference_distribut
 
 }
 
+std::shared_ptr<const Fuse::Analysis::Tmd_signature> Fuse::Target::get_or_build_reference_signature(
+		Fuse::Event_set reference_pair,
+		unsigned int repeat_idx,
+		Fuse::Symbol symbol,
+		std::vector<std::pair<int64_t, int64_t> > bounds_per_event,
+		unsigned int bin_count
+		){
+
+	auto pair_idx = this->get_reference_pair_index_for_event_pair(reference_pair);
+	Fuse::Reference_signature_key key = std::make_tuple(pair_idx, repeat_idx, symbol, bounds_per_event, bin_count);
+
+	std::shared_ptr<const Fuse::Analysis::Tmd_signature> signature;
+	std::shared_ptr<const Fuse::Analysis::Tmd_histogram_pyramid> pyramid;
+
+	#pragma omp critical (target_signatures)
+	{
+		// The persisted signatures of a reference pair and repeat are read once, on first use
+		if(Fuse::Config::persist_reference_signatures
+				&& this->reference_signature_files_loaded.insert(std::make_pair(pair_idx, repeat_idx)).second){
+			auto persisted_signatures = this->load_reference_signatures_from_disk(pair_idx, repeat_idx);
+			this->reference_signatures.insert(persisted_signatures.begin(), persisted_signatures.end());
+		}
+
+		auto signature_iter = this->reference_signatures.find(key);
+		if(signature_iter != this->reference_signatures.end())
+			signature = signature_iter->second;
+
+		// As are the pyramids
+		if(signature == nullptr){
+			auto pyramids_iter = this->reference_pyramids.find(std::make_pair(pair_idx, repeat_idx));
+			if(pyramids_iter == this->reference_pyramids.end())
+				pyramids_iter = this->reference_pyramids.insert(std::make_pair(std::make_pair(pair_idx, repeat_idx),
+					this->load_reference_pyramids_from_disk(pair_idx, repeat_idx))).first;
+
+			auto pyramid_iter = pyramids_iter->second.find(symbol);
+			if(pyramid_iter != pyramids_iter->second.end())
+				pyramid = pyramid_iter->second;
+		}
+	}
+
+	if(signature != nullptr)
+		return signature;
+
+	// Build outside of the lock, so that other signatures can be retrieved meanwhile
+	std::shared_ptr<const Fuse::Analysis::Tmd_signature> built_signature;
+
+	// A pyramid is only usable if it was binned within the same bounds, which may since have widened, and has the bin count
+	const Fuse::Analysis::Tmd_histogram* histogram = nullptr;
+	if(pyramid != nullptr)
+		histogram = Fuse::Analysis::find_pyramid_histogram(*pyramid, bounds_per_event, bin_count);
+
+	if(histogram != nullptr){
+		built_signature.reset(new Fuse::Analysis::Tmd_signature(
+			Fuse::Analysis::construct_tmd_signature_from_histogram(*histogram, bounds_per_event)));
+	} else {
+		std::vector<Fuse::Symbol> constrained_symbols;
+		if(symbol != "all_symbols")
+			constrained_symbols = {symbol};
+
+		auto distribution = this->get_or_load_reference_distribution(reference_pair, repeat_idx, constrained_symbols);
+
+		built_signature.reset(new Fuse::Analysis::Tmd_signature(
+			Fuse::Analysis::construct_tmd_signature(distribution, bounds_per_event, bin_count)));
+	}
+
+	// If another thread built the same signature meanwhile, then use theirs
+	bool inserted = false;
+	#pragma omp critical (target_signatures)
+	{
+		auto insertion = this->reference_signatures.insert(std::make_pair(key, built_signature));
+		signature = insertion.first->second;
+		inserted = insertion.second;
+	}
+
+	if(inserted && Fuse::Config::persist_reference_signatures)
+		this->save_reference_signature_to_disk(key, *signature);
+
+	return signature;
+
+}
+
 std::pair<double, double> Fuse::Target::get_or_load_calibration_tmd(
 		Fuse::Event_set events,
 		Fuse::Symbol symbol
@@ -1007,46 +1233,44 @@ std::pair<double, double> Fuse::Target::get_or_load_calibration_tmd(
 
 	auto reference_idx = this->get_reference_pair_index_for_event_pair(events);
 
+	std::pair<double, double> calibration = std::make_pair(-1.0,-1.0);
+	std::exception_ptr loading_exception = nullptr;
+
 	#pragma omp critical (target_calibrations)
 	{
-		if(this->calibrations_loaded == false){
-			this->calibration_tmds = this->load_reference_calibrations_per_symbol();
+		try {
+
+			if(this->calibrations_loaded == false){
+				this->calibration_tmds = this->load_reference_calibrations_per_symbol();
+			}
+
+			auto symbol_iter = this->calibration_tmds.find(symbol);
+			if(symbol_iter != this->calibration_tmds.end()){
+				auto pair_iter = symbol_iter->second.find(reference_idx);
+				if(pair_iter != symbol_iter->second.end())
+					calibration = pair_iter->second;
+			}
+
+		} catch(...){
+			loading_exception = std::current_exception();
 		}
 	}
 
-	auto symbol_iter = this->calibration_tmds.find(symbol);
-	if(symbol_iter == this->calibration_tmds.end())
-		return std::make_pair(-1.0,-1.0);
-
-	auto pair_iter = symbol_iter->second.find(reference_idx);
-	if(pair_iter == symbol_iter->second.end())
-		return std::make_pair(-1.0,-1.0);
+	if(loading_exception)
+		std::rethrow_exception(loading_exception);
 
-	return pair_iter->second;
+	return calibration;
 
 }
 
-void Fuse::Target::save_reference_calibration_tmd_to_disk(
-		Fuse::Symbol symbol,
-		Fuse::Event_set events,
-		unsigned int reference_idx,
-		double min,
-		double max,
-		double mean,
-		double std,
-		double median,
-		double mean_num_instances // to be used as a 'weight' for the symbol
+void Fuse::Target::save_reference_calibration_tmds_to_disk(
+		std::vector<Fuse::Calibration_tmd> calibrations
 		){
 
-	spdlog::trace("Storing calibration TMD {} for symbol '{}' and reference {}:{}.",
-		median,
-		symbol,
-		reference_idx,
-		Fuse::Util::vector_to_string(events)
-	);
-
 	auto filename = this->get_calibration_tmds_filename();
 
+	spdlog::debug("Storing {} calibration TMDs to {}.", calibrations.size(), filename);
+
 	auto requires_header = true;
 	if(Fuse::Util::check_file_existance(filename))
 		requires_header = false;
@@ -1056,24 +1280,47 @@ void Fuse::Target::save_reference_calibration_tmd_to_disk(
 		throw std::runtime_error(fmt::format("Unable to open {} to store calibration tmds.", filename));
 
 	if(requires_header){
-		std::string header("reference_idx,events,min,max,mean,std,median,mean_num_instances\n");
+		std::string header("reference_idx,events,min,max,mean,std,median,mean_num_instances,num_combinations,median_relative_confidence\n");
 		file_stream << header;
 	}
 
-	auto events_str = Fuse::Util::vector_to_string(events,true,"-");
+	for(auto calibration : calibrations){
+
+		spdlog::trace("Storing calibration TMD {} for symbol '{}' and reference {}:{}.",
+			calibration.median,
+			calibration.symbol,
+			calibration.reference_idx,
+			Fuse::Util::vector_to_string(calibration.events)
+		);
+
+		auto events_str = Fuse::Util::vector_to_string(calibration.events,true,"-");
 
-	file_stream << symbol;
-	file_stream << "," << reference_idx;
-	file_stream << "," << events_str;
-	file_stream << "," << min;
-	file_stream << "," << max;
-	file_stream << "," << mean;
-	file_stream << "," << std;
-	file_stream << "," << median;
-	file_stream << "," << mean_num_instances << std::endl;
+		file_stream << calibration.symbol;
+		file_stream << "," << calibration.reference_idx;
+		file_stream << "," << events_str;
+		file_stream << "," << calibration.min;
+		file_stream << "," << calibration.max;
+		file_stream << "," << calibration.mean;
+		file_stream << "," << calibration.std;
+		file_stream << "," << calibration.median;
+		file_stream << "," << calibration.mean_num_instances;
+		file_stream << "," << calibration.num_combinations;
+		file_stream << "," << calibration.median_relative_confidence << "\n";
+
+	}
 
 	file_stream.close();
 
+	// Keep any previously loaded calibrations up to date, so they can be used without reloading the file
+	#pragma omp critical (target_calibrations)
+	{
+		if(this->calibrations_loaded){
+			for(auto calibration : calibrations)
+				this->calibration_tmds[calibration.symbol][calibration.reference_idx] =
+					std::make_pair(calibration.median, calibration.mean_num_instances);
+		}
+	}
+
 }
 
 std::map<Fuse::Symbol, std::map<unsigned int, std::pair<double, double> > >
@@ -1116,15 +1363,8 @@ std::map<Fuse::Symbol, std::map<unsigned int, std::pair<double, double> > >
 
 		} else {
 
-			auto reference_iter = symbol_iter->second.find(reference_idx);
-			if(reference_iter != symbol_iter->second.end())
-				spdlog::warn("When loading calibration TMDs from {}, inserted a calibration for '{}' and pair {} that already exists.",
-					filename,
-					symbol,
-					reference_idx
-				);
-
-			symbol_iter->second[reference_idx] = calibration_pair; // Will replace if exists
+			// Recalibrations (e.g. after adding reference repeats) are appended, so later rows replace earlier ones
+			symbol_iter->second[reference_idx] = calibration_pair;
 
 		}
 
@@ -1135,6 +1375,125 @@ std::map<Fuse::Symbol, std::map<unsigned int, std::pair<double, double> > >
 
 }
 
+/*
+* Each record is: symbol, reference pair index, the two repeat indexes, bounds per event, bin count, solver, TMD and number of instances
+* Records are only ever appended, so a truncated final record is ignored
+*/
+std::vector<Fuse::Calibration_combination_tmd> Fuse::Target::load_calibration_combination_tmds_from_disk(){
+
+	std::vector<Fuse::Calibration_combination_tmd> combination_tmds;
+
+	auto filename = this->get_calibration_combination_tmds_filename();
+
+	auto file_stream = std::fstream(filename, std::ios::in | std::ios::binary);
+	if(file_stream.is_open() == false)
+		return combination_tmds;
+
+	while(file_stream.peek() != std::char_traits<char>::eof()){
+
+		Fuse::Calibration_combination_tmd combination_tmd;
+
+		unsigned int num_chars = 0;
+		file_stream.read(reinterpret_cast<char*>(&num_chars), sizeof(num_chars));
+
+		combination_tmd.symbol.resize(num_chars);
+		file_stream.read(reinterpret_cast<char*>(&combination_tmd.symbol[0]), num_chars);
+
+		unsigned int num_dimensions = 0;
+		file_stream.read(reinterpret_cast<char*>(&combination_tmd.reference_idx), sizeof(combination_tmd.reference_idx));
+		file_stream.read(reinterpret_cast<char*>(&combination_tmd.repeat_one), sizeof(combination_tmd.repeat_one));
+		file_stream.read(reinterpret_cast<char*>(&combination_tmd.repeat_two), sizeof(combination_tmd.repeat_two));
+		file_stream.read(reinterpret_cast<char*>(&num_dimensions), sizeof(num_dimensions));
+
+		if(file_stream.fail())
+			break;
+
+		combination_tmd.bounds_per_event.resize(num_dimensions);
+		for(auto& bounds : combination_tmd.bounds_per_event){
+			file_stream.read(reinterpret_cast<char*>(&bounds.first), sizeof(bounds.first));
+			file_stream.read(reinterpret_cast<char*>(&bounds.second), sizeof(bounds.second));
+		}
+
+		unsigned int solver_idx = 0;
+		file_stream.read(reinterpret_cast<char*>(&combination_tmd.bin_count), sizeof(combination_tmd.bin_count));
+		file_stream.read(reinterpret_cast<char*>(&solver_idx), sizeof(solver_idx));
+		combination_tmd.solver = static_cast<Fuse::Tmd_solver>(solver_idx);
+
+		file_stream.read(reinterpret_cast<char*>(&combination_tmd.tmd), sizeof(combination_tmd.tmd));
+		file_stream.read(reinterpret_cast<char*>(&combination_tmd.num_instances), sizeof(combination_tmd.num_instances));
+
+		if(file_stream.fail()){
+			spdlog::warn("Ignoring a truncated calibration combination TMD record in {}.", filename);
+			break;
+		}
+
+		combination_tmds.push_back(combination_tmd);
+
+	}
+
+	spdlog::debug("Loaded {} calibration combination TMDs from {}.", combination_tmds.size(), filename);
+
+	return combination_tmds;
+
+}
+
+void Fuse::Target::save_calibration_combination_tmds_to_disk(
+		const std::vector<Fuse::Calibration_combination_tmd>& combination_tmds
+		){
+
+	auto filename = this->get_calibration_combination_tmds_filename();
+
+	auto file_stream = std::fstream(filename, std::ios::out | std::ios::binary | std::ios::app);
+	if(file_stream.is_open() == false)
+		throw std::runtime_error(fmt::format("Unable to open {} to store calibration combination TMDs.", filename));
+
+	for(auto& combination_tmd : combination_tmds){
+
+		unsigned int num_chars = combination_tmd.symbol.size();
+		unsigned int num_dimensions = combination_tmd.bounds_per_event.size();
+		unsigned int solver_idx = static_cast<unsigned int>(combination_tmd.solver);
+
+		file_stream.write(reinterpret_cast<const char*>(&num_chars), sizeof(num_chars));
+		file_stream.write(combination_tmd.symbol.data(), num_chars);
+		file_stream.write(reinterpret_cast<const char*>(&combination_tmd.reference_idx), sizeof(combination_tmd.reference_idx));
+		file_stream.write(reinterpret_cast<const char*>(&combination_tmd.repeat_one), sizeof(combination_tmd.repeat_one));
+		file_stream.write(reinterpret_cast<const char*>(&combination_tmd.repeat_two), sizeof(combination_tmd.repeat_two));
+		file_stream.write(reinterpret_cast<const char*>(&num_dimensions), sizeof(num_dimensions));
+		for(auto& bounds : combination_tmd.bounds_per_event){
+			file_stream.write(reinterpret_cast<const char*>(&bounds.first), sizeof(bounds.first));
+			file_stream.write(reinterpret_cast<const char*>(&bounds.second), sizeof(bounds.second));
+		}
+		file_stream.write(reinterpret_cast<const char*>(&combination_tmd.bin_count), sizeof(combination_tmd.bin_count));
+		file_stream.write(reinterpret_cast<const char*>(&solver_idx), sizeof(solver_idx));
+		file_stream.write(reinterpret_cast<const char*>(&combination_tmd.tmd), sizeof(combination_tmd.tmd));
+		file_stream.write(reinterpret_cast<const char*>(&combination_tmd.num_instances), sizeof(combination_tmd.num_instances));
+
+	}
+
+	file_stream.close();
+
+}
+
+// The lines of the file (if it exists) that do not start with the prefix
+std::vector<std::string> read_lines_without_prefix(
+		std::string filename,
+		std::string prefix
+		){
+
+	std::vector<std::string> lines;
+	if(Fuse::Util::check_file_existance(filename) == false)
+		return lines;
+
+	auto file_stream = std::ifstream(filename);
+	std::string line;
+	while(std::getline(file_stream, line))
+		if(line.compare(0, prefix.size(), prefix) != 0)
+			lines.push_back(line);
+
+	return lines;
+
+}
+
 void Fuse::Target::save_accuracy_results_to_disk(
 		Fuse::Accuracy_metric metric,
 		Fuse::Strategy strategy,
@@ -1150,23 +1509,34 @@ void Fuse::Target::save_accuracy_results_to_disk(
 	);
 
 	auto filename = this->get_results_filename(metric);
+	auto strategy_str = Fuse::convert_strategy_to_string(strategy);
 
-	auto requires_header = true;
-	if(Fuse::Util::check_file_existance(filename))
-		requires_header = false;
+	// Results of a previous analysis of the same combination are replaced rather than duplicated
+	auto retained_lines = read_lines_without_prefix(filename, fmt::format("{},{},", strategy_str, repeat_idx));
 
-	auto file_stream = std::ofstream(filename, std::ios_base::app);
+	auto requires_header = retained_lines.empty();
+
+	auto file_stream = std::ofstream(filename, std::ios_base::trunc);
 	if(file_stream.is_open() == false)
 		throw std::runtime_error(fmt::format("Unable to open {} to store accuracy results.", filename));
 
-	// TODO should condition on metric
+	for(auto& line : retained_lines)
+		file_stream << line << "\n";
+
+	// The marginal metric reports a value per target event, whereas the others report a TMD per reference pair
+	bool per_event = (metric == Fuse::Accuracy_metric::MARGINAL_W1);
+
 	if(requires_header){
 		std::string header("strategy,repeat,pair_idx,events,calibrated_tmd\n");
+		if(per_event)
+			header = "strategy,repeat,event_idx,event,calibrated_distance\n";
+		else if(metric == Fuse::Accuracy_metric::SPEARMANS)
+			header = "strategy,repeat,pair_idx,events,rank_correlation_error\n";
 		file_stream << header;
 	}
 
-	auto strategy_str = Fuse::convert_strategy_to_string(strategy);
 	auto event_pairs = this->get_reference_pairs();
+	auto events = this->get_target_events();
 
 	// Overall
 	file_stream << strategy_str;
@@ -1180,7 +1550,10 @@ void Fuse::Target::save_accuracy_results_to_disk(
 		file_stream << strategy_str;
 		file_stream << "," << repeat_idx;
 		file_stream << "," << pair.first;
-		file_stream << "," << Fuse::Util::vector_to_string(event_pairs.at(pair.first), true, "-");
+		if(per_event)
+			file_stream << "," << events.at(pair.first);
+		else
+			file_stream << "," << Fuse::Util::vector_to_string(event_pairs.at(pair.first), true, "-");
 		file_stream << "," << pair.second << std::endl;
 	}
 
@@ -1188,6 +1561,43 @@ void Fuse::Target::save_accuracy_results_to_disk(
 
 }
 
+void Fuse::Target::save_accuracy_confidence_interval_to_disk(
+		Fuse::Accuracy_metric metric,
+		Fuse::Strategy strategy,
+		unsigned int repeat_idx,
+		double epd,
+		unsigned int num_replicates,
+		double confidence,
+		std::pair<double, double> confidence_interval
+		){
+
+	auto filename = this->get_confidence_intervals_filename(metric);
+	auto strategy_str = Fuse::convert_strategy_to_string(strategy);
+
+	auto retained_lines = read_lines_without_prefix(filename, fmt::format("{},{},", strategy_str, repeat_idx));
+
+	auto file_stream = std::ofstream(filename, std::ios_base::trunc);
+	if(file_stream.is_open() == false)
+		throw std::runtime_error(fmt::format("Unable to open {} to store accuracy confidence intervals.", filename));
+
+	if(retained_lines.empty())
+		file_stream << "strategy,repeat,value,num_replicates,confidence,lower,upper\n";
+
+	for(auto& line : retained_lines)
+		file_stream << line << "\n";
+
+	file_stream << strategy_str;
+	file_stream << "," << repeat_idx;
+	file_stream << "," << epd;
+	file_stream << "," << num_replicates;
+	file_stream << "," << confidence;
+	file_stream << "," << confidence_interval.first;
+	file_stream << "," << confidence_interval.second << std::endl;
+
+	file_stream.close();
+
+}
+
 unsigned int Fuse::Target::get_reference_pair_index_for_event_pair(
 		Fuse::Event_set pair
 		){
@@ -1320,6 +1730,357 @@ std::map<Fuse::Symbol, std::vector<std::vector<int64_t> > > Fuse::Target::load_r
 
 }
 
+/*
+* Each persisted signature is a record of: symbol, bin count, bounds per event, number of instances, number of bins, then
+* the bin coordinates and weights. Records are only ever appended, so a truncated final record is ignored
+* This is called within a critical section, so failures are logged rather than thrown
+*/
+std::map<Fuse::Reference_signature_key, std::shared_ptr<const Fuse::Analysis::Tmd_signature> >
+		Fuse::Target::load_reference_signatures_from_disk(
+		unsigned int pair_idx,
+		unsigned int repeat_idx
+		){
+
+	std::map<Fuse::Reference_signature_key, std::shared_ptr<const Fuse::Analysis::Tmd_signature> > signatures;
+
+	auto filename = this->get_reference_signatures_filename_for(pair_idx, repeat_idx);
+
+	auto file_stream = std::fstream(filename, std::ios::in | std::ios::binary);
+	if(file_stream.is_open() == false)
+		return signatures;
+
+	while(file_stream.peek() != std::char_traits<char>::eof()){
+
+		unsigned int num_chars = 0;
+		file_stream.read(reinterpret_cast<char*>(&num_chars), sizeof(num_chars));
+
+		Fuse::Symbol symbol;
+		symbol.resize(num_chars);
+		file_stream.read(reinterpret_cast<char*>(&symbol[0]), num_chars);
+
+		unsigned int bin_count = 0;
+		unsigned int num_dimensions = 0;
+		file_stream.read(reinterpret_cast<char*>(&bin_count), sizeof(bin_count));
+		file_stream.read(reinterpret_cast<char*>(&num_dimensions), sizeof(num_dimensions));
+
+		std::vector<std::pair<int64_t, int64_t> > bounds_per_event(num_dimensions);
+		for(auto& bounds : bounds_per_event){
+			file_stream.read(reinterpret_cast<char*>(&bounds.first), sizeof(bounds.first));
+			file_stream.read(reinterpret_cast<char*>(&bounds.second), sizeof(bounds.second));
+		}
+
+		std::shared_ptr<Fuse::Analysis::Tmd_signature> signature(new Fuse::Analysis::Tmd_signature());
+		signature->num_dimensions = num_dimensions;
+
+		unsigned int num_bins = 0;
+		file_stream.read(reinterpret_cast<char*>(&signature->num_instances), sizeof(signature->num_instances));
+		file_stream.read(reinterpret_cast<char*>(&num_bins), sizeof(num_bins));
+
+		if(file_stream.fail())
+			break;
+
+		signature->coords.resize(num_bins * num_dimensions);
+		signature->weights.resize(num_bins);
+		file_stream.read(reinterpret_cast<char*>(signature->coords.data()), signature->coords.size()*sizeof(double));
+		file_stream.read(reinterpret_cast<char*>(signature->weights.data()), signature->weights.size()*sizeof(double));
+
+		if(file_stream.fail()){
+			spdlog::warn("Ignoring a truncated reference signature record in {}.", filename);
+			break;
+		}
+
+		auto key = std::make_tuple(pair_idx, repeat_idx, symbol, bounds_per_event, bin_count);
+		signatures.insert(std::make_pair(key, std::shared_ptr<const Fuse::Analysis::Tmd_signature>(signature)));
+
+	}
+
+	spdlog::debug("Loaded {} persisted reference signatures from {}.", signatures.size(), filename);
+
+	return signatures;
+
+}
+
+void Fuse::Target::save_reference_signature_to_disk(
+		const Fuse::Reference_signature_key& key,
+		const Fuse::Analysis::Tmd_signature& signature
+		){
+
+	auto filename = this->get_reference_signatures_filename_for(std::get<0>(key), std::get<1>(key));
+
+	const Fuse::Symbol& symbol = std::get<2>(key);
+	const std::vector<std::pair<int64_t, int64_t> >& bounds_per_event = std::get<3>(key);
+	unsigned int bin_count = std::get<4>(key);
+	unsigned int num_chars = symbol.size();
+	unsigned int num_dimensions = bounds_per_event.size();
+	unsigned int num_bins = signature.weights.size();
+
+	// Signatures of the same file may be built concurrently, so serialise whole records
+	#pragma omp critical (target_signature_files)
+	{
+		auto file_stream = std::fstream(filename, std::ios::out | std::ios::binary | std::ios::app);
+		if(file_stream.is_open() == false){
+			spdlog::warn("Unable to open {} to persist a reference signature.", filename);
+		} else {
+			file_stream.write(reinterpret_cast<const char*>(&num_chars), sizeof(num_chars));
+			file_stream.write(symbol.data(), num_chars);
+			file_stream.write(reinterpret_cast<const char*>(&bin_count), sizeof(bin_count));
+			file_stream.write(reinterpret_cast<const char*>(&num_dimensions), sizeof(num_dimensions));
+			for(auto& bounds : bounds_per_event){
+				file_stream.write(reinterpret_cast<const char*>(&bounds.first), sizeof(bounds.first));
+				file_stream.write(reinterpret_cast<const char*>(&bounds.second), sizeof(bounds.second));
+			}
+			file_stream.write(reinterpret_cast<const char*>(&signature.num_instances), sizeof(signature.num_instances));
+			file_stream.write(reinterpret_cast<const char*>(&num_bins), sizeof(num_bins));
+			file_stream.write(reinterpret_cast<const char*>(signature.coords.data()), signature.coords.size()*sizeof(double));
+			file_stream.write(reinterpret_cast<const char*>(signature.weights.data()), signature.weights.size()*sizeof(double));
+			file_stream.close();
+		}
+	}
+
+}
+
+/*
+* Each persisted pyramid is a record of: symbol, number of dimensions, bounds per dimension, number of instances, number of
+* levels, then per level the bin count, number of populated bins, and the populated bins' coordinates, counts and sums
+* As for signatures, this is called within a critical section, so failures are logged rather than thrown
+*/
+std::map<Fuse::Symbol, std::shared_ptr<const Fuse::Analysis::Tmd_histogram_pyramid> >
+		Fuse::Target::load_reference_pyramids_from_disk(
+		unsigned int pair_idx,
+		unsigned int repeat_idx
+		){
+
+	std::map<Fuse::Symbol, std::shared_ptr<const Fuse::Analysis::Tmd_histogram_pyramid> > pyramids;
+
+	auto filename = this->get_reference_pyramids_filename_for(pair_idx, repeat_idx);
+
+	auto file_stream = std::fstream(filename, std::ios::in | std::ios::binary);
+	if(file_stream.is_open() == false)
+		return pyramids;
+
+	while(file_stream.peek() != std::char_traits<char>::eof()){
+
+		unsigned int num_chars = 0;
+		file_stream.read(reinterpret_cast<char*>(&num_chars), sizeof(num_chars));
+
+		Fuse::Symbol symbol;
+		symbol.resize(num_chars);
+		file_stream.read(reinterpret_cast<char*>(&symbol[0]), num_chars);
+
+		unsigned int num_dimensions = 0;
+		file_stream.read(reinterpret_cast<char*>(&num_dimensions), sizeof(num_dimensions));
+
+		std::shared_ptr<Fuse::Analysis::Tmd_histogram_pyramid> pyramid(new Fuse::Analysis::Tmd_histogram_pyramid());
+		pyramid->bounds_per_dimension.resize(num_dimensions);
+		for(auto& bounds : pyramid->bounds_per_dimension){
+			file_stream.read(reinterpret_cast<char*>(&bounds.first), sizeof(bounds.first));
+			file_stream.read(reinterpret_cast<char*>(&bounds.second), sizeof(bounds.second));
+		}
+
+		unsigned int num_levels = 0;
+		file_stream.read(reinterpret_cast<char*>(&pyramid->num_instances), sizeof(pyramid->num_instances));
+		file_stream.read(reinterpret_cast<char*>(&num_levels), sizeof(num_levels));
+
+		pyramid->levels.resize(num_levels);
+		for(auto& histogram : pyramid->levels){
+
+			unsigned int num_bins = 0;
+			file_stream.read(reinterpret_cast<char*>(&histogram.num_bins_per_dimension), sizeof(histogram.num_bins_per_dimension));
+			file_stream.read(reinterpret_cast<char*>(&num_bins), sizeof(num_bins));
+
+			if(file_stream.fail())
+				break;
+
+			histogram.coords.resize(num_bins * num_dimensions);
+			histogram.counts.resize(num_bins);
+			histogram.sums.resize(num_bins * num_dimensions);
+			file_stream.read(reinterpret_cast<char*>(histogram.coords.data()), histogram.coords.size()*sizeof(int32_t));
+			file_stream.read(reinterpret_cast<char*>(histogram.counts.data()), histogram.counts.size()*sizeof(uint32_t));
+			file_stream.read(reinterpret_cast<char*>(histogram.sums.data()), histogram.sums.size()*sizeof(int64_t));
+
+		}
+
+		if(file_stream.fail()){
+			spdlog::warn("Ignoring a truncated reference pyramid record in {}.", filename);
+			break;
+		}
+
+		pyramids[symbol] = pyramid;
+
+	}
+
+	spdlog::debug("Loaded {} reference pyramids from {}.", pyramids.size(), filename);
+
+	return pyramids;
+
+}
+
+std::map<Fuse::Symbol, std::shared_ptr<const Fuse::Analysis::Tmd_histogram_pyramid> >
+		Fuse::Target::get_or_load_reference_pyramids(
+			unsigned int pair_idx,
+			unsigned int repeat_idx
+		){
+
+	std::map<Fuse::Symbol, std::shared_ptr<const Fuse::Analysis::Tmd_histogram_pyramid> > pyramids;
+
+	#pragma omp critical (target_signatures)
+	{
+		auto pyramids_iter = this->reference_pyramids.find(std::make_pair(pair_idx, repeat_idx));
+		if(pyramids_iter == this->reference_pyramids.end())
+			pyramids_iter = this->reference_pyramids.insert(std::make_pair(std::make_pair(pair_idx, repeat_idx),
+				this->load_reference_pyramids_from_disk(pair_idx, repeat_idx))).first;
+
+		pyramids = pyramids_iter->second;
+	}
+
+	return pyramids;
+
+}
+
+void Fuse::Target::save_reference_pyramids_to_disk(
+		unsigned int pair_idx,
+		unsigned int repeat_idx,
+		const std::map<Fuse::Symbol, Fuse::Analysis::Tmd_histogram_pyramid>& pyramids_per_symbol
+		){
+
+	auto filename = this->get_reference_pyramids_filename_for(pair_idx, repeat_idx);
+
+	auto file_stream = std::fstream(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if(file_stream.is_open() == false)
+		throw std::runtime_error(fmt::format("Unable to open {} to save the reference pyramids.", filename));
+
+	std::map<Fuse::Symbol, std::shared_ptr<const Fuse::Analysis::Tmd_histogram_pyramid> > saved_pyramids;
+
+	for(auto& pyramid_iter : pyramids_per_symbol){
+
+		const Fuse::Symbol& symbol = pyramid_iter.first;
+		const Fuse::Analysis::Tmd_histogram_pyramid& pyramid = pyramid_iter.second;
+
+		unsigned int num_chars = symbol.size();
+		unsigned int num_dimensions = pyramid.bounds_per_dimension.size();
+		unsigned int num_levels = pyramid.levels.size();
+
+		file_stream.write(reinterpret_cast<const char*>(&num_chars), sizeof(num_chars));
+		file_stream.write(symbol.data(), num_chars);
+		file_stream.write(reinterpret_cast<const char*>(&num_dimensions), sizeof(num_dimensions));
+		for(auto& bounds : pyramid.bounds_per_dimension){
+			file_stream.write(reinterpret_cast<const char*>(&bounds.first), sizeof(bounds.first));
+			file_stream.write(reinterpret_cast<const char*>(&bounds.second), sizeof(bounds.second));
+		}
+		file_stream.write(reinterpret_cast<const char*>(&pyramid.num_instances), sizeof(pyramid.num_instances));
+		file_stream.write(reinterpret_cast<const char*>(&num_levels), sizeof(num_levels));
+
+		for(auto& histogram : pyramid.levels){
+			unsigned int num_bins = histogram.counts.size();
+			file_stream.write(reinterpret_cast<const char*>(&histogram.num_bins_per_dimension), sizeof(histogram.num_bins_per_dimension));
+			file_stream.write(reinterpret_cast<const char*>(&num_bins), sizeof(num_bins));
+			file_stream.write(reinterpret_cast<const char*>(histogram.coords.data()), histogram.coords.size()*sizeof(int32_t));
+			file_stream.write(reinterpret_cast<const char*>(histogram.counts.data()), histogram.counts.size()*sizeof(uint32_t));
+			file_stream.write(reinterpret_cast<const char*>(histogram.sums.data()), histogram.sums.size()*sizeof(int64_t));
+		}
+
+		saved_pyramids[symbol] = std::make_shared<const Fuse::Analysis::Tmd_histogram_pyramid>(pyramid);
+
+	}
+
+	file_stream.close();
+
+	// Any previously loaded pyramids of the pair and repeat are now stale
+	#pragma omp critical (target_signatures)
+	this->reference_pyramids[std::make_pair(pair_idx, repeat_idx)] = saved_pyramids;
+
+}
+
+/*
+* Each cached accuracy result is a record of: strategy, combination repeat index, reference pair index, symbol, fingerprint
+* and value. Records are only ever appended, so a truncated final record is ignored
+*/
+std::map<Fuse::Accuracy_cache_key, Fuse::Accuracy_cache_entry> Fuse::Target::load_accuracy_cache_from_disk(){
+
+	std::map<Fuse::Accuracy_cache_key, Fuse::Accuracy_cache_entry> entries;
+
+	auto filename = this->get_accuracy_cache_filename();
+
+	auto file_stream = std::fstream(filename, std::ios::in | std::ios::binary);
+	if(file_stream.is_open() == false)
+		return entries;
+
+	unsigned int num_records = 0;
+	while(file_stream.peek() != std::char_traits<char>::eof()){
+
+		unsigned int num_strategy_chars = 0;
+		file_stream.read(reinterpret_cast<char*>(&num_strategy_chars), sizeof(num_strategy_chars));
+
+		std::string strategy_str;
+		strategy_str.resize(num_strategy_chars);
+		file_stream.read(reinterpret_cast<char*>(&strategy_str[0]), num_strategy_chars);
+
+		unsigned int repeat_idx = 0;
+		unsigned int pair_idx = 0;
+		unsigned int num_symbol_chars = 0;
+		file_stream.read(reinterpret_cast<char*>(&repeat_idx), sizeof(repeat_idx));
+		file_stream.read(reinterpret_cast<char*>(&pair_idx), sizeof(pair_idx));
+		file_stream.read(reinterpret_cast<char*>(&num_symbol_chars), sizeof(num_symbol_chars));
+
+		Fuse::Symbol symbol;
+		symbol.resize(num_symbol_chars);
+		file_stream.read(reinterpret_cast<char*>(&symbol[0]), num_symbol_chars);
+
+		Fuse::Accuracy_cache_entry entry;
+		file_stream.read(reinterpret_cast<char*>(&entry.first), sizeof(entry.first));
+		file_stream.read(reinterpret_cast<char*>(&entry.second), sizeof(entry.second));
+
+		if(file_stream.fail()){
+			spdlog::warn("Ignoring a truncated accuracy cache record in {}.", filename);
+			break;
+		}
+
+		auto key = std::make_tuple(Fuse::convert_string_to_strategy(strategy_str), repeat_idx, pair_idx, symbol);
+		entries[key] = entry;
+		num_records++;
+
+	}
+
+	spdlog::debug("Loaded {} cached accuracy results from {} records in {}.", entries.size(), num_records, filename);
+
+	return entries;
+
+}
+
+void Fuse::Target::save_accuracy_cache_entries_to_disk(
+		const std::vector<std::pair<Fuse::Accuracy_cache_key, Fuse::Accuracy_cache_entry> >& entries
+		){
+
+	auto filename = this->get_accuracy_cache_filename();
+
+	auto file_stream = std::fstream(filename, std::ios::out | std::ios::binary | std::ios::app);
+	if(file_stream.is_open() == false)
+		throw std::runtime_error(fmt::format("Unable to open {} to cache accuracy results.", filename));
+
+	for(auto& entry_iter : entries){
+
+		auto strategy_str = Fuse::convert_strategy_to_string(std::get<0>(entry_iter.first));
+		unsigned int repeat_idx = std::get<1>(entry_iter.first);
+		unsigned int pair_idx = std::get<2>(entry_iter.first);
+		const Fuse::Symbol& symbol = std::get<3>(entry_iter.first);
+		unsigned int num_strategy_chars = strategy_str.size();
+		unsigned int num_symbol_chars = symbol.size();
+
+		file_stream.write(reinterpret_cast<const char*>(&num_strategy_chars), sizeof(num_strategy_chars));
+		file_stream.write(strategy_str.data(), num_strategy_chars);
+		file_stream.write(reinterpret_cast<const char*>(&repeat_idx), sizeof(repeat_idx));
+		file_stream.write(reinterpret_cast<const char*>(&pair_idx), sizeof(pair_idx));
+		file_stream.write(reinterpret_cast<const char*>(&num_symbol_chars), sizeof(num_symbol_chars));
+		file_stream.write(symbol.data(), num_symbol_chars);
+		file_stream.write(reinterpret_cast<const char*>(&entry_iter.second.first), sizeof(entry_iter.second.first));
+		file_stream.write(reinterpret_cast<const char*>(&entry_iter.second.second), sizeof(entry_iter.second.second));
+
+	}
+
+	file_stream.close();
+
+}
+
 void Fuse::Target::increment_num_reference_repeats(){
 
 	this->num_reference_repeats++;
@@ -1412,10 +2173,7 @@ Fuse::Profile_p Fuse::Target::get_or_load_combined_profile(
 		){
 
 	// Check if it has been combined and thus able to be loaded
-	auto indexes_iter = this->combined_indexes.find(strategy);
-	if(indexes_iter == this->combined_indexes.end()
-			|| std::find(indexes_iter->second.begin(), indexes_iter->second.end(), repeat_idx)
-				== indexes_iter->second.end()){
+	if(this->combined_profile_exists(strategy, repeat_idx) == false){
 
 		throw std::invalid_argument(fmt::format(
 			"Cannot load combined profile for strategy {} and repeat {}, as this combination does not exist.",
@@ -1427,43 +2185,34 @@ Fuse::Profile_p Fuse::Target::get_or_load_combined_profile(
 
 	Fuse::Profile_p profile;
 
-	auto strategy_iter = this->loaded_combined_profiles.find(strategy);
-	if(strategy_iter == this->loaded_combined_profiles.end()){
-
-		std::string combined_instances_filename = this->get_combination_filename(strategy, repeat_idx);
-		profile = this->load_combined_profile_from_disk(combined_instances_filename);
-	
-		spdlog::debug("Loaded combined profile for strategy {} and repeat {} from disk.",
-			Fuse::convert_strategy_to_string(strategy),
-			repeat_idx
-		);
-
-		std::map<unsigned int, Fuse::Profile_p> profiles;
-		profiles.insert(std::make_pair(repeat_idx, profile));
-
-		this->loaded_combined_profiles.insert(std::make_pair(strategy, profiles));
-
-	} else {
-
-		auto repeat_iter = strategy_iter->second.find(repeat_idx);
-		if(repeat_iter == strategy_iter->second.end()){
-
-			std::string combined_instances_filename = this->get_combination_filename(strategy, repeat_idx);
-			profile = this->load_combined_profile_from_disk(combined_instances_filename);
-		
-			spdlog::debug("Loaded combined profile for strategy {} and repeat {} from disk.",
-				Fuse::convert_strategy_to_string(strategy),
-				repeat_idx
-			);
-
-			strategy_iter->second.insert(std::make_pair(repeat_idx, profile));
+	#pragma omp critical (target_combinations)
+	{
+		auto strategy_iter = this->loaded_combined_profiles.find(strategy);
+		if(strategy_iter != this->loaded_combined_profiles.end()){
+			auto repeat_iter = strategy_iter->second.find(repeat_idx);
+			if(repeat_iter != strategy_iter->second.end())
+				profile = repeat_iter->second;
+		}
+	}
 
-		} else {
+	if(profile != nullptr)
+		return profile;
 
-			profile = repeat_iter->second;
+	// Load outside of the lock, as each combination has its own file
+	std::string combined_instances_filename = this->get_combination_filename(strategy, repeat_idx);
+	profile = this->load_combined_profile_from_disk(combined_instances_filename);
+	profile->set_combination_residuals(this->load_combination_residuals_from_disk(strategy, repeat_idx));
 
-		}
+	spdlog::debug("Loaded combined profile for strategy {} and repeat {} from disk.",
+		Fuse::convert_strategy_to_string(strategy),
+		repeat_idx
+	);
 
+	// If another thread loaded the same profile meanwhile, then use theirs
+	#pragma omp critical (target_combinations)
+	{
+		auto insertion = this->loaded_combined_profiles[strategy].insert(std::make_pair(repeat_idx, profile));
+		profile = insertion.first->second;
 	}
 
 	return profile;
@@ -1587,28 +2336,91 @@ std::map<unsigned int, double> Fuse::Target::get_or_load_pairwise_mis(
 
 		unsigned int repeat_index = 0; // this is the repeat reference index that we'll use to calculate MI
 
-		#pragma omp parallel for
+		/* Each pair is analysed within the reference set that contains it
+		*  So first bin every event column of each of those reference sets once, rather than binning both events for every pair
+		*/
+
+		std::vector<unsigned int> reference_set_indexes;
+		std::vector<unsigned int> reference_set_index_per_pair;
+		for(auto event_pair : reference_pairs){
+			auto reference_set_idx = this->get_reference_set_index_for_events(event_pair);
+			reference_set_index_per_pair.push_back(reference_set_idx);
+			if(std::find(reference_set_indexes.begin(), reference_set_indexes.end(), reference_set_idx) == reference_set_indexes.end())
+				reference_set_indexes.push_back(reference_set_idx);
+		}
+
+		auto reference_sets = this->get_or_generate_reference_sets();
+
+		// Map from reference set index to its binned columns, in the order of the set's events
+		std::map<unsigned int, std::vector<std::vector<int32_t> > > bins_per_reference_set;
+		for(auto reference_set_idx : reference_set_indexes)
+			bins_per_reference_set[reference_set_idx].resize(reference_sets.at(reference_set_idx).size());
+
+		std::exception_ptr mi_exception = nullptr;
+
+		#pragma omp parallel for schedule(dynamic)
+		for(unsigned int set_position = 0; set_position < reference_set_indexes.size(); set_position++){
+
+			try {
+
+				auto reference_set_idx = reference_set_indexes.at(set_position);
+
+				std::vector<Fuse::Symbol> symbols; // Empty to return a joint distribution
+				std::vector<std::vector<int64_t> > reference_values = this->get_or_load_reference_distribution(
+					reference_sets.at(reference_set_idx),
+					repeat_index,
+					symbols
+				);
+
+				// The map itself is not modified here, so each thread may write to its own set's columns
+				auto& bins_per_event = bins_per_reference_set.at(reference_set_idx);
+				for(unsigned int event_idx = 0; event_idx < bins_per_event.size(); event_idx++)
+					bins_per_event.at(event_idx) = Fuse::Analysis::bin_values_for_mutual_information(reference_values, event_idx);
+
+			} catch(...){
+				#pragma omp critical (mi_exception)
+				mi_exception = std::current_exception();
+			}
+
+		}
+
+		if(mi_exception != nullptr)
+			std::rethrow_exception(mi_exception);
+
+		// Now compute the whole set of pairwise values in one parallel sweep
+		std::vector<double> mi_per_pair(reference_pairs.size(), 0.0);
+
+		#pragma omp parallel for schedule(dynamic)
 		for(unsigned int event_pair_idx = 0; event_pair_idx < reference_pairs.size(); event_pair_idx++){
-			
-			auto event_pair = reference_pairs.at(event_pair_idx);
 
-			// for this pair, find the reference execution that I should load
-			auto reference_execution_index = this->get_reference_set_index_for_events(event_pair);
+			try {
 
-			std::vector<Fuse::Symbol> symbols; // Empty to return a joint distribution
-			std::vector<std::vector<int64_t> > reference_values = this->get_or_load_reference_distribution(
-				event_pair,
-				repeat_index,
-				symbols
-			);
+				auto reference_set_idx = reference_set_index_per_pair.at(event_pair_idx);
+				auto& reference_set = reference_sets.at(reference_set_idx);
+				auto& bins_per_event = bins_per_reference_set.at(reference_set_idx);
+
+				auto event_pair = reference_pairs.at(event_pair_idx);
+				auto column_one = std::distance(reference_set.begin(), std::find(reference_set.begin(), reference_set.end(), event_pair.at(0)));
+				auto column_two = std::distance(reference_set.begin(), std::find(reference_set.begin(), reference_set.end(), event_pair.at(1)));
 
-			double mi = Fuse::Analysis::calculate_normalised_mutual_information(reference_values);
+				mi_per_pair.at(event_pair_idx) = Fuse::Analysis::calculate_normalised_mutual_information_of_bins(
+					bins_per_event.at(column_one),
+					bins_per_event.at(column_two)
+				);
 
-			#pragma omp critical
-			this->loaded_pairwise_mis.insert(std::make_pair(event_pair_idx, mi));
+			} catch(...){
+				#pragma omp critical (mi_exception)
+				mi_exception = std::current_exception();
+			}
 
 		}
 
+		if(mi_exception != nullptr)
+			std::rethrow_exception(mi_exception);
+
+		for(unsigned int event_pair_idx = 0; event_pair_idx < reference_pairs.size(); event_pair_idx++)
+			this->loaded_pairwise_mis.insert(std::make_pair(event_pair_idx, mi_per_pair.at(event_pair_idx)));
+
 		this->pairwise_mi_loaded = true;
 
 		this->save_pairwise_mis_to_disk(this->loaded_pairwise_mis);
@@ -1698,3 +2510,160 @@ Fuse::Profile_p Fuse::Target::load_combined_profile_from_disk(
 
 }
 
+void Fuse::Target::save_tmd_solver_error_to_disk(
+		Fuse::Tmd_solver solver,
+		unsigned long num_tmds,
+		double mean_absolute_error,
+		double max_absolute_error,
+		double mean_relative_error,
+		double max_relative_error,
+		double exact_seconds,
+		double solver_seconds
+		){
+
+	auto filename = this->get_tmd_solver_error_filename();
+
+	auto requires_header = true;
+	if(Fuse::Util::check_file_existance(filename))
+		requires_header = false;
+
+	auto file_stream = std::ofstream(filename, std::ios_base::app);
+	if(file_stream.is_open() == false)
+		throw std::runtime_error(fmt::format("Unable to open {} to store TMD solver error results.", filename));
+
+	if(requires_header){
+		std::string header("solver,bin_count,sinkhorn_epsilon,sinkhorn_tolerance,num_tmds,mean_absolute_error,max_absolute_error,mean_relative_error,max_relative_error,exact_seconds,solver_seconds\n");
+		file_stream << header;
+	}
+
+	file_stream << Fuse::convert_tmd_solver_to_string(solver);
+	file_stream << "," << Fuse::Config::tmd_bin_count;
+	file_stream << "," << Fuse::Config::sinkhorn_epsilon;
+	file_stream << "," << Fuse::Config::sinkhorn_tolerance;
+	file_stream << "," << num_tmds;
+	file_stream << "," << mean_absolute_error;
+	file_stream << "," << max_absolute_error;
+	file_stream << "," << mean_relative_error;
+	file_stream << "," << max_relative_error;
+	file_stream << "," << exact_seconds;
+	file_stream << "," << solver_seconds << std::endl;
+
+	file_stream.close();
+
+}
+
+void Fuse::Target::save_combination_benchmark_to_disk(
+		Fuse::Strategy strategy,
+		unsigned int repeat_idx,
+		unsigned long num_instances,
+		double seconds,
+		double mean_relative_residual
+		){
+
+	auto filename = this->get_combination_benchmark_filename();
+
+	auto requires_header = true;
+	if(Fuse::Util::check_file_existance(filename))
+		requires_header = false;
+
+	auto file_stream = std::ofstream(filename, std::ios_base::app);
+	if(file_stream.is_open() == false)
+		throw std::runtime_error(fmt::format("Unable to open {} to store combination benchmark results.", filename));
+
+	if(requires_header){
+		std::string header("strategy,repeat,num_instances,seconds,instances_per_second,mean_relative_residual\n");
+		file_stream << header;
+	}
+
+	file_stream << Fuse::convert_strategy_to_string(strategy);
+	file_stream << "," << repeat_idx;
+	file_stream << "," << num_instances;
+	file_stream << "," << seconds;
+	file_stream << "," << (seconds > 0.0 ? num_instances / seconds : 0.0);
+	file_stream << "," << mean_relative_residual << std::endl;
+
+	file_stream.close();
+
+}
+
+void Fuse::Target::save_combination_residuals_to_disk(
+		Fuse::Strategy strategy,
+		unsigned int repeat_idx,
+		const Fuse::Combination_residuals& residuals
+		){
+
+	auto filename = this->get_combination_residuals_filename(strategy, repeat_idx);
+
+	auto file_stream = std::ofstream(filename);
+	if(file_stream.is_open() == false)
+		throw std::runtime_error(fmt::format("Unable to open {} to store combination residuals.", filename));
+
+	// Sums are stored rather than means, so that residuals can be accumulated exactly after loading
+	file_stream << "symbol,event,num_matches,sum_absolute_difference,sum_relative_difference,max_absolute_difference,";
+	file_stream << "num_granularity_matches,sum_granularity,min_granularity\n";
+	file_stream << std::setprecision(17);
+
+	for(auto symbol_iter : residuals){
+		for(auto event_iter : symbol_iter.second){
+
+			auto residual = event_iter.second;
+
+			file_stream << symbol_iter.first;
+			file_stream << "," << event_iter.first;
+			file_stream << "," << residual.num_matches;
+			file_stream << "," << residual.sum_absolute_difference;
+			file_stream << "," << residual.sum_relative_difference;
+			file_stream << "," << residual.max_absolute_difference;
+			file_stream << "," << residual.num_granularity_matches;
+			file_stream << "," << residual.sum_granularity;
+			file_stream << "," << residual.min_granularity << "\n";
+
+		}
+	}
+
+	file_stream.close();
+
+}
+
+Fuse::Combination_residuals Fuse::Target::load_combination_residuals_from_disk(
+		Fuse::Strategy strategy,
+		unsigned int repeat_idx
+		){
+
+	Fuse::Combination_residuals residuals;
+
+	auto filename = this->get_combination_residuals_filename(strategy, repeat_idx);
+
+	auto file_stream = std::ifstream(filename);
+	if(file_stream.is_open() == false)
+		return residuals;
+
+	std::string header;
+	file_stream >> header;
+
+	std::string line;
+	while(file_stream >> line){
+
+		auto split_line = Fuse::Util::split_string_to_vector(line, ',');
+
+		if(split_line.size() != 9)
+			throw std::runtime_error(fmt::format("Incorrect number of values in {}. Line was: '{}'", filename, line));
+
+		Fuse::Linking_residual residual;
+		residual.num_matches = std::stoul(split_line.at(2));
+		residual.sum_absolute_difference = std::stod(split_line.at(3));
+		residual.sum_relative_difference = std::stod(split_line.at(4));
+		residual.max_absolute_difference = std::stod(split_line.at(5));
+		residual.num_granularity_matches = std::stoul(split_line.at(6));
+		residual.sum_granularity = std::stod(split_line.at(7));
+		residual.min_granularity = static_cast<unsigned int>(std::stoul(split_line.at(8)));
+
+		residuals[split_line.at(0)][split_line.at(1)] = residual;
+
+	}
+
+	file_stream.close();
+	return residuals;
+
+}
+
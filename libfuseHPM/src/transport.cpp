@@ -0,0 +1,659 @@
+#include "transport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+/* The transportation problem is solved by the transportation (MODI) simplex:
+*  The basis is a spanning tree over the supply (row) and demand (column) nodes, with one basic cell per tree edge
+*  Each iteration prices the non-basic cells against the node potentials, and pivots the most negative of a block of cells into the basis
+*/
+
+// Buffers are kept per thread and only ever grow, so repeated solves do not allocate
+struct Transport_workspace {
+	std::vector<double> costs;
+	std::vector<double> supply;
+	std::vector<double> demand;
+
+	// Basic cells
+	std::vector<int32_t> cell_row;
+	std::vector<int32_t> cell_col;
+	std::vector<double> cell_flow;
+
+	// Tree adjacency, as linked lists of cell ends (2*cell for the row end, 2*cell+1 for the column end)
+	std::vector<int32_t> adjacency_head;
+	std::vector<int32_t> adjacency_next;
+
+	// Per node, from the traversal of the tree
+	std::vector<double> potentials;
+	std::vector<int32_t> parent_node;
+	std::vector<int32_t> parent_cell;
+	std::vector<int32_t> depth;
+	std::vector<int32_t> stack;
+
+	// The cells on the pivot cycle, excluding the entering cell
+	std::vector<int32_t> cycle_cells;
+
+	// Sinkhorn: the stabilised kernel, the absorbed potentials and current scalings per row and column, and column sums
+	std::vector<double> kernel;
+	std::vector<double> row_potentials;
+	std::vector<double> col_potentials;
+	std::vector<double> row_scalings;
+	std::vector<double> col_scalings;
+	std::vector<double> col_sums;
+
+	// Lower bound: the points of both marginals along one dimension, with the second distribution's weights negated
+	std::vector<std::pair<double, double> > marginal_points;
+};
+
+thread_local Transport_workspace transport_workspace;
+
+template<unsigned int D>
+void calculate_transport_costs(
+		const double* coords_one,
+		unsigned int num_one,
+		const double* coords_two,
+		unsigned int num_two,
+		double* costs
+		){
+
+	for(unsigned int i = 0; i < num_one; i++){
+		const double* a = coords_one + static_cast<size_t>(i) * D;
+		for(unsigned int j = 0; j < num_two; j++){
+			const double* b = coords_two + static_cast<size_t>(j) * D;
+			double square_distance = 0.0;
+			for(unsigned int dim_idx = 0; dim_idx < D; dim_idx++){
+				double difference = b[dim_idx] - a[dim_idx];
+				square_distance += difference * difference;
+			}
+			costs[static_cast<size_t>(i) * num_two + j] = std::sqrt(square_distance);
+		}
+	}
+
+}
+
+void calculate_transport_costs(
+		unsigned int num_dimensions,
+		const double* coords_one,
+		unsigned int num_one,
+		const double* coords_two,
+		unsigned int num_two,
+		double* costs
+		){
+
+	for(unsigned int i = 0; i < num_one; i++){
+		const double* a = coords_one + static_cast<size_t>(i) * num_dimensions;
+		for(unsigned int j = 0; j < num_two; j++){
+			const double* b = coords_two + static_cast<size_t>(j) * num_dimensions;
+			double square_distance = 0.0;
+			for(unsigned int dim_idx = 0; dim_idx < num_dimensions; dim_idx++){
+				double difference = b[dim_idx] - a[dim_idx];
+				square_distance += difference * difference;
+			}
+			costs[static_cast<size_t>(i) * num_two + j] = std::sqrt(square_distance);
+		}
+	}
+
+}
+
+void calculate_transport_costs_for_dimensions(
+		unsigned int num_dimensions,
+		const double* coords_one,
+		unsigned int num_one,
+		const double* coords_two,
+		unsigned int num_two,
+		double* costs
+		){
+
+	// Fixed-dimension kernels for the common cases, so that the distance loop is unrolled
+	switch(num_dimensions){
+		case 1: calculate_transport_costs<1>(coords_one, num_one, coords_two, num_two, costs); break;
+		case 2: calculate_transport_costs<2>(coords_one, num_one, coords_two, num_two, costs); break;
+		case 3: calculate_transport_costs<3>(coords_one, num_one, coords_two, num_two, costs); break;
+		default: calculate_transport_costs(num_dimensions, coords_one, num_one, coords_two, num_two, costs);
+	}
+
+}
+
+void calculate_costs_for_dimensions(
+		Transport_workspace& ws,
+		unsigned int num_dimensions,
+		const std::vector<double>& coords_one,
+		unsigned int num_rows,
+		const std::vector<double>& coords_two,
+		unsigned int num_cols
+		){
+
+	size_t num_cells = static_cast<size_t>(num_rows) * num_cols;
+	if(ws.costs.size() < num_cells)
+		ws.costs.resize(num_cells);
+
+	calculate_transport_costs_for_dimensions(num_dimensions, coords_one.data(), num_rows, coords_two.data(), num_cols, ws.costs.data());
+
+}
+
+void add_cell_to_tree(Transport_workspace& ws, int32_t cell, int32_t num_rows){
+
+	int32_t row_node = ws.cell_row[cell];
+	int32_t col_node = num_rows + ws.cell_col[cell];
+
+	ws.adjacency_next[2*cell] = ws.adjacency_head[row_node];
+	ws.adjacency_head[row_node] = 2*cell;
+	ws.adjacency_next[2*cell+1] = ws.adjacency_head[col_node];
+	ws.adjacency_head[col_node] = 2*cell+1;
+
+}
+
+void remove_end_from_tree(Transport_workspace& ws, int32_t node, int32_t end){
+
+	int32_t* link = &ws.adjacency_head[node];
+	while(*link != end)
+		link = &ws.adjacency_next[*link];
+	*link = ws.adjacency_next[end];
+
+}
+
+// Recomputes the potentials (u_i + v_j = c_ij on every basic cell) and the rooted tree, from the first row
+void traverse_tree(Transport_workspace& ws, int32_t num_rows, int32_t num_cols){
+
+	ws.parent_node[0] = -1;
+	ws.parent_cell[0] = -1;
+	ws.depth[0] = 0;
+	ws.potentials[0] = 0.0;
+
+	int32_t stack_size = 0;
+	ws.stack[stack_size++] = 0;
+
+	while(stack_size > 0){
+
+		int32_t node = ws.stack[--stack_size];
+
+		for(int32_t end = ws.adjacency_head[node]; end != -1; end = ws.adjacency_next[end]){
+
+			int32_t cell = end / 2;
+			if(cell == ws.parent_cell[node])
+				continue;
+
+			int32_t row = ws.cell_row[cell];
+			int32_t col = ws.cell_col[cell];
+			double cost = ws.costs[static_cast<size_t>(row) * num_cols + col];
+
+			int32_t child;
+			if(end % 2 == 0){
+				child = num_rows + col;
+				ws.potentials[child] = cost - ws.potentials[node];
+			} else {
+				child = row;
+				ws.potentials[child] = cost - ws.potentials[node];
+			}
+
+			ws.parent_node[child] = node;
+			ws.parent_cell[child] = cell;
+			ws.depth[child] = ws.depth[node] + 1;
+			ws.stack[stack_size++] = child;
+
+		}
+	}
+
+}
+
+double Fuse::Transport::calculate_emd(
+		unsigned int num_dimensions,
+		const std::vector<double>& coords_one,
+		const std::vector<double>& weights_one,
+		const std::vector<double>& coords_two,
+		const std::vector<double>& weights_two
+		){
+
+	int32_t num_rows = weights_one.size();
+	int32_t num_cols = weights_two.size();
+	if(num_rows == 0 || num_cols == 0)
+		return 0.0;
+
+	Transport_workspace& ws = transport_workspace;
+
+	size_t num_cells = static_cast<size_t>(num_rows) * num_cols;
+	int32_t num_nodes = num_rows + num_cols;
+	int32_t num_basic = num_nodes - 1;
+
+	if(ws.cell_row.size() < static_cast<size_t>(num_basic)){
+		ws.cell_row.resize(num_basic);
+		ws.cell_col.resize(num_basic);
+		ws.cell_flow.resize(num_basic);
+		ws.adjacency_next.resize(2*num_basic);
+	}
+	if(ws.potentials.size() < static_cast<size_t>(num_nodes)){
+		ws.adjacency_head.resize(num_nodes);
+		ws.potentials.resize(num_nodes);
+		ws.parent_node.resize(num_nodes);
+		ws.parent_cell.resize(num_nodes);
+		ws.depth.resize(num_nodes);
+		ws.stack.resize(num_nodes);
+		ws.cycle_cells.resize(num_nodes);
+	}
+
+	ws.supply.assign(weights_one.begin(), weights_one.end());
+	ws.demand.assign(weights_two.begin(), weights_two.end());
+
+	calculate_costs_for_dimensions(ws, num_dimensions, coords_one, num_rows, coords_two, num_cols);
+
+	double max_cost = 0.0;
+	for(size_t cell_idx = 0; cell_idx < num_cells; cell_idx++)
+		max_cost = std::max(max_cost, ws.costs[cell_idx]);
+
+	if(max_cost == 0.0)
+		return 0.0;
+
+	/* Initial basis by the north-west corner rule, which always gives num_rows + num_cols - 1 cells forming a spanning tree
+	*  The signatures' bins are in lexicographic order of their coordinates, so this already matches along the first dimension
+	*/
+	std::fill(ws.adjacency_head.begin(), ws.adjacency_head.begin() + num_nodes, -1);
+
+	int32_t row = 0;
+	int32_t col = 0;
+	for(int32_t cell = 0; cell < num_basic; cell++){
+
+		double flow = std::max(0.0, std::min(ws.supply[row], ws.demand[col]));
+		ws.supply[row] -= flow;
+		ws.demand[col] -= flow;
+
+		ws.cell_row[cell] = row;
+		ws.cell_col[cell] = col;
+		ws.cell_flow[cell] = flow;
+		add_cell_to_tree(ws, cell, num_rows);
+
+		if(row == num_rows - 1)
+			col++;
+		else if(col == num_cols - 1)
+			row++;
+		else if(ws.supply[row] <= ws.demand[col])
+			row++;
+		else
+			col++;
+
+	}
+
+	// Reduced costs within this tolerance of zero are treated as optimal
+	double tolerance = max_cost * 1e-12;
+
+	// Price blocks of about sqrt(cells) cells, cycling through all cells
+	size_t block_size = std::max(static_cast<size_t>(std::sqrt(static_cast<double>(num_cells))), static_cast<size_t>(16));
+	size_t next_cell_to_price = 0;
+
+	size_t max_iterations = 100 * num_cells + 1000;
+	bool converged = false;
+
+	for(size_t iteration = 0; iteration < max_iterations; iteration++){
+
+		traverse_tree(ws, num_rows, num_cols);
+
+		int32_t entering_row = -1;
+		int32_t entering_col = -1;
+		double min_reduced_cost = -tolerance;
+
+		size_t num_priced = 0;
+		while(num_priced < num_cells){
+
+			size_t block_end = std::min(num_priced + block_size, num_cells);
+			for(; num_priced < block_end; num_priced++){
+
+				int32_t priced_row = next_cell_to_price / num_cols;
+				int32_t priced_col = next_cell_to_price % num_cols;
+
+				double reduced_cost = ws.costs[next_cell_to_price] - ws.potentials[priced_row] - ws.potentials[num_rows + priced_col];
+				if(reduced_cost < min_reduced_cost){
+					min_reduced_cost = reduced_cost;
+					entering_row = priced_row;
+					entering_col = priced_col;
+				}
+
+				if(++next_cell_to_price == num_cells)
+					next_cell_to_price = 0;
+			}
+
+			if(entering_row != -1)
+				break;
+		}
+
+		if(entering_row == -1){
+			converged = true;
+			break;
+		}
+
+		/* The cycle is the entering cell, then the tree path from its column back to its row
+		*  Flow decreases on the cells at odd positions along this path (starting from the column end), and increases on the even
+		*/
+		int32_t row_side = entering_row;
+		int32_t col_side = num_rows + entering_col;
+		int32_t num_row_side = 0;
+		int32_t num_col_side = 0;
+
+		// Column-side cells are stored from the front, and row-side cells from the back, so that the cycle is in order
+		while(row_side != col_side){
+			if(ws.depth[row_side] >= ws.depth[col_side]){
+				ws.cycle_cells[num_nodes - 1 - num_row_side++] = ws.parent_cell[row_side];
+				row_side = ws.parent_node[row_side];
+			} else {
+				ws.cycle_cells[num_col_side++] = ws.parent_cell[col_side];
+				col_side = ws.parent_node[col_side];
+			}
+		}
+		for(int32_t row_side_idx = 0; row_side_idx < num_row_side; row_side_idx++)
+			ws.cycle_cells[num_col_side + row_side_idx] = ws.cycle_cells[num_nodes - num_row_side + row_side_idx];
+
+		int32_t cycle_length = num_col_side + num_row_side;
+
+		int32_t leaving_position = -1;
+		double theta = std::numeric_limits<double>::max();
+		for(int32_t position = 0; position < cycle_length; position += 2){
+			double flow = ws.cell_flow[ws.cycle_cells[position]];
+			if(flow < theta){
+				theta = flow;
+				leaving_position = position;
+			}
+		}
+
+		for(int32_t position = 0; position < cycle_length; position++){
+			int32_t cell = ws.cycle_cells[position];
+			if(position % 2 == 0)
+				ws.cell_flow[cell] = std::max(0.0, ws.cell_flow[cell] - theta);
+			else
+				ws.cell_flow[cell] += theta;
+		}
+
+		// The entering cell takes the leaving cell's slot
+		int32_t leaving_cell = ws.cycle_cells[leaving_position];
+		remove_end_from_tree(ws, ws.cell_row[leaving_cell], 2*leaving_cell);
+		remove_end_from_tree(ws, num_rows + ws.cell_col[leaving_cell], 2*leaving_cell+1);
+
+		ws.cell_row[leaving_cell] = entering_row;
+		ws.cell_col[leaving_cell] = entering_col;
+		ws.cell_flow[leaving_cell] = theta;
+		add_cell_to_tree(ws, leaving_cell, num_rows);
+
+	}
+
+	if(converged == false)
+		return -1.0;
+
+	double total_cost = 0.0;
+	for(int32_t cell = 0; cell < num_basic; cell++)
+		total_cost += ws.cell_flow[cell] * ws.costs[static_cast<size_t>(ws.cell_row[cell]) * num_cols + ws.cell_col[cell]];
+
+	return total_cost;
+
+}
+
+double Fuse::Transport::calculate_sinkhorn_emd(
+		unsigned int num_dimensions,
+		const std::vector<double>& coords_one,
+		const std::vector<double>& weights_one,
+		const std::vector<double>& coords_two,
+		const std::vector<double>& weights_two,
+		double epsilon,
+		double tolerance,
+		unsigned int max_iterations
+		){
+
+	unsigned int num_rows = weights_one.size();
+	unsigned int num_cols = weights_two.size();
+	if(num_rows == 0 || num_cols == 0)
+		return 0.0;
+
+	Transport_workspace& ws = transport_workspace;
+
+	size_t num_cells = static_cast<size_t>(num_rows) * num_cols;
+
+	calculate_costs_for_dimensions(ws, num_dimensions, coords_one, num_rows, coords_two, num_cols);
+
+	double max_cost = 0.0;
+	for(size_t cell_idx = 0; cell_idx < num_cells; cell_idx++)
+		max_cost = std::max(max_cost, ws.costs[cell_idx]);
+
+	if(max_cost == 0.0)
+		return 0.0;
+
+	double regularisation = epsilon * max_cost;
+
+	if(ws.kernel.size() < num_cells)
+		ws.kernel.resize(num_cells);
+
+	/* Stabilised (log-domain) Sinkhorn: the plan is P_ij = u_i * K_ij * v_j, with K_ij = exp((f_i + g_j - C_ij) / reg)
+	*  Iterations only update the scalings u and v by matrix-vector products, and whenever a scaling becomes extreme its
+	*  logarithm is absorbed into the potentials f and g, and the kernel is recomputed, so nothing overflows or underflows
+	*/
+	ws.row_potentials.assign(num_rows, 0.0);
+	ws.col_potentials.assign(num_cols, 0.0);
+	ws.row_scalings.assign(num_rows, 1.0);
+	ws.col_scalings.assign(num_cols, 1.0);
+
+	double* f = ws.row_potentials.data();
+	double* g = ws.col_potentials.data();
+	double* u = ws.row_scalings.data();
+	double* v = ws.col_scalings.data();
+	double* kernel = ws.kernel.data();
+	const double* costs = ws.costs.data();
+
+	const double absorption_threshold = 1e50;
+
+	auto recompute_kernel = [&](){
+		for(unsigned int i = 0; i < num_rows; i++){
+			double* kernel_row = kernel + static_cast<size_t>(i) * num_cols;
+			const double* cost_row = costs + static_cast<size_t>(i) * num_cols;
+			for(unsigned int j = 0; j < num_cols; j++)
+				kernel_row[j] = std::exp((f[i] + g[j] - cost_row[j]) / regularisation);
+		}
+	};
+
+	recompute_kernel();
+
+	ws.col_sums.resize(num_cols);
+	double* col_sums = ws.col_sums.data();
+
+	for(unsigned int iteration = 0; iteration < max_iterations; iteration++){
+
+		// u = a / (K v)
+		for(unsigned int i = 0; i < num_rows; i++){
+			const double* kernel_row = kernel + static_cast<size_t>(i) * num_cols;
+			double row_sum = 0.0;
+			#pragma omp simd reduction(+:row_sum)
+			for(unsigned int j = 0; j < num_cols; j++)
+				row_sum += kernel_row[j] * v[j];
+			u[i] = row_sum > 0.0 ? weights_one[i] / row_sum : 0.0;
+		}
+
+		// v = b / (K^T u), accumulated row by row so that the kernel is read contiguously
+		std::fill(col_sums, col_sums + num_cols, 0.0);
+		for(unsigned int i = 0; i < num_rows; i++){
+			const double* kernel_row = kernel + static_cast<size_t>(i) * num_cols;
+			double u_i = u[i];
+			#pragma omp simd
+			for(unsigned int j = 0; j < num_cols; j++)
+				col_sums[j] += kernel_row[j] * u_i;
+		}
+		for(unsigned int j = 0; j < num_cols; j++)
+			v[j] = col_sums[j] > 0.0 ? weights_two[j] / col_sums[j] : 0.0;
+
+		double max_scaling = 0.0;
+		for(unsigned int i = 0; i < num_rows; i++)
+			max_scaling = std::max(max_scaling, std::max(u[i], u[i] > 0.0 ? 1.0 / u[i] : 0.0));
+		for(unsigned int j = 0; j < num_cols; j++)
+			max_scaling = std::max(max_scaling, std::max(v[j], v[j] > 0.0 ? 1.0 / v[j] : 0.0));
+
+		if(max_scaling > absorption_threshold){
+			for(unsigned int i = 0; i < num_rows; i++){
+				if(u[i] > 0.0)
+					f[i] += regularisation * std::log(u[i]);
+				u[i] = 1.0;
+			}
+			for(unsigned int j = 0; j < num_cols; j++){
+				if(v[j] > 0.0)
+					g[j] += regularisation * std::log(v[j]);
+				v[j] = 1.0;
+			}
+			recompute_kernel();
+		}
+
+		// The columns are exactly matched after each iteration, so convergence is measured on the rows, periodically
+		if(iteration % 10 != 9)
+			continue;
+
+		double marginal_error = 0.0;
+		for(unsigned int i = 0; i < num_rows; i++){
+			const double* kernel_row = kernel + static_cast<size_t>(i) * num_cols;
+			double row_sum = 0.0;
+			#pragma omp simd reduction(+:row_sum)
+			for(unsigned int j = 0; j < num_cols; j++)
+				row_sum += kernel_row[j] * v[j];
+			marginal_error += std::fabs(u[i] * row_sum - weights_one[i]);
+		}
+
+		if(marginal_error <= tolerance)
+			break;
+
+	}
+
+	double total_cost = 0.0;
+	for(unsigned int i = 0; i < num_rows; i++){
+		const double* kernel_row = kernel + static_cast<size_t>(i) * num_cols;
+		const double* cost_row = costs + static_cast<size_t>(i) * num_cols;
+		double row_cost = 0.0;
+		#pragma omp simd reduction(+:row_cost)
+		for(unsigned int j = 0; j < num_cols; j++)
+			row_cost += kernel_row[j] * v[j] * cost_row[j];
+		total_cost += u[i] * row_cost;
+	}
+
+	return total_cost;
+
+}
+
+double Fuse::Transport::calculate_emd_lower_bound(
+		unsigned int num_dimensions,
+		const std::vector<double>& coords_one,
+		const std::vector<double>& weights_one,
+		const std::vector<double>& coords_two,
+		const std::vector<double>& weights_two
+		){
+
+	unsigned int num_rows = weights_one.size();
+	unsigned int num_cols = weights_two.size();
+	if(num_rows == 0 || num_cols == 0)
+		return 0.0;
+
+	Transport_workspace& ws = transport_workspace;
+
+	double total_weight_one = 0.0;
+	for(auto weight : weights_one)
+		total_weight_one += weight;
+
+	double total_weight_two = 0.0;
+	for(auto weight : weights_two)
+		total_weight_two += weight;
+
+	if(total_weight_one <= 0.0 || total_weight_two <= 0.0)
+		return 0.0;
+
+	/* For any transport plan, the cost is E||x-y|| >= ||(E|x_d-y_d|)_d|| (Jensen), and each E|x_d-y_d| is at least the 1-D
+	*  distance between the two marginals in dimension d, which is the integral of the difference between their CDFs
+	*  This dominates both the distance between the weighted centroids and the largest per-dimension marginal distance
+	*/
+	double summed_squared_marginal_distances = 0.0;
+
+	for(unsigned int dim_idx = 0; dim_idx < num_dimensions; dim_idx++){
+
+		ws.marginal_points.clear();
+		ws.marginal_points.reserve(num_rows + num_cols);
+
+		for(unsigned int row_idx = 0; row_idx < num_rows; row_idx++)
+			ws.marginal_points.push_back(std::make_pair(
+				coords_one[static_cast<size_t>(row_idx) * num_dimensions + dim_idx],
+				weights_one[row_idx] / total_weight_one));
+
+		for(unsigned int col_idx = 0; col_idx < num_cols; col_idx++)
+			ws.marginal_points.push_back(std::make_pair(
+				coords_two[static_cast<size_t>(col_idx) * num_dimensions + dim_idx],
+				-weights_two[col_idx] / total_weight_two));
+
+		std::sort(ws.marginal_points.begin(), ws.marginal_points.end());
+
+		double cdf_difference = 0.0;
+		double marginal_distance = 0.0;
+		for(size_t point_idx = 0; point_idx + 1 < ws.marginal_points.size(); point_idx++){
+			cdf_difference += ws.marginal_points[point_idx].second;
+			marginal_distance += std::fabs(cdf_difference)
+				* (ws.marginal_points[point_idx+1].first - ws.marginal_points[point_idx].first);
+		}
+
+		summed_squared_marginal_distances += marginal_distance * marginal_distance;
+
+	}
+
+	return std::sqrt(summed_squared_marginal_distances);
+
+}
+
+void Fuse::Transport::calculate_ground_distances(
+		unsigned int num_dimensions,
+		const std::vector<double>& coords_one,
+		const std::vector<double>& coords_two,
+		std::vector<double>& costs
+		){
+
+	if(num_dimensions == 0){
+		costs.clear();
+		return;
+	}
+
+	unsigned int num_one = coords_one.size() / num_dimensions;
+	unsigned int num_two = coords_two.size() / num_dimensions;
+
+	costs.resize(static_cast<size_t>(num_one) * num_two);
+	calculate_transport_costs_for_dimensions(num_dimensions, coords_one.data(), num_one, coords_two.data(), num_two, costs.data());
+
+}
+
+double Fuse::Transport::calculate_sorted_1d_emd(
+		const std::vector<double>& sorted_values_one,
+		const std::vector<double>& sorted_values_two
+		){
+
+	size_t num_values_one = sorted_values_one.size();
+	size_t num_values_two = sorted_values_two.size();
+	if(num_values_one == 0 || num_values_two == 0)
+		return 0.0;
+
+	// Merge the two sorted sequences, integrating the CDF difference over each gap between consecutive values
+	size_t idx_one = 0;
+	size_t idx_two = 0;
+	double previous_value = std::min(sorted_values_one.front(), sorted_values_two.front());
+	double distance = 0.0;
+
+	while(idx_one < num_values_one || idx_two < num_values_two){
+
+		double value = 0.0;
+		if(idx_two == num_values_two || (idx_one < num_values_one && sorted_values_one[idx_one] <= sorted_values_two[idx_two]))
+			value = sorted_values_one[idx_one];
+		else
+			value = sorted_values_two[idx_two];
+
+		double cdf_one = static_cast<double>(idx_one) / num_values_one;
+		double cdf_two = static_cast<double>(idx_two) / num_values_two;
+		distance += std::fabs(cdf_one - cdf_two) * (value - previous_value);
+
+		// Step past every sample at this value
+		while(idx_one < num_values_one && sorted_values_one[idx_one] == value)
+			idx_one++;
+		while(idx_two < num_values_two && sorted_values_two[idx_two] == value)
+			idx_two++;
+
+		previous_value = value;
+
+	}
+
+	return distance;
+
+}
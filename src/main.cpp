@@ -1,4 +1,5 @@
 #include "fuse.h"
+#include "config.h"
 
 #include "cxxopts.hpp"
 
@@ -20,12 +21,15 @@ cxxopts::Options setup_options(char* argv, std::vector<std::string>& main_option
 
 	options.add_options("Main")
 		("d,target_dir", "Target Fuse target directory (containing fuse.json).", cxxopts::value<std::string>())
-		("e,execute_sequence", "Execute the sequence. Argument is number of repeat sequence executions. Conditioned by 'minimal', 'filter_events'.", cxxopts::value<unsigned int>())
-		("m,combine_sequence", "Combine the sequence repeats. Conditioned by 'strategies', 'repeat_indexes', 'minimal', 'filter_events'.")
+		("e,execute_sequence", "Execute the sequence. Argument is number of repeat sequence executions. Conditioned by 'minimal', 'filter_events', 'stream_combination'.", cxxopts::value<unsigned int>())
+		("m,combine_sequence", "Combine the sequence repeats. Conditioned by 'strategies', 'repeat_indexes', 'minimal', 'filter_events', 'bc_tree_combination'.")
 		("t,execute_hem", "Execute the HEM execution profile. Argument is number of repeat executions. Conditioned by 'filter_events'.", cxxopts::value<unsigned int>())
-		("a,analyse_accuracy", "Analyse accuracy of combined execution profiles. Conditioned by 'strategies', 'repeat_indexes', 'minimal', 'accuracy_metric'.")
+		("a,analyse_accuracy", "Analyse accuracy of combined execution profiles. Conditioned by 'strategies', 'repeat_indexes', 'minimal', 'accuracy_metric', 'bootstrap'.")
 		("r,execute_references", "Execute the reference execution profiles.", cxxopts::value<unsigned int>())
-		("c,run_calibration", "Run EPD calibration on the reference profiles.");
+		("c,run_calibration", "Run EPD calibration on the reference profiles. Conditioned by 'adaptive_calibration', 'calibration_tolerance'.")
+		("p,build_reference_pyramids", "Build the histogram pyramids of existing reference profiles, so that signatures with power-of-two bin counts do not need the reference values. Executing references also builds them if the library's 'build_reference_pyramids' configuration is enabled and the TMD bin count is a power of two.")
+		("b,benchmark_strategies", "Time the combination of the sequence repeats via each strategy, without storing the combinations. Conditioned by 'strategies', 'repeat_indexes', 'minimal'.")
+		("s,evaluate_tmd_solver", "Compare the TMDs of 'tmd_solver' to those of the exact solver, across the reference repeats. Conditioned by 'tmd_solver'.");
 
 	options.add_options("Utility")
 		("dump_instances", "Dumps an execution profile matrix. Argument is the output file. Requires 'tracefile', 'benchmark'.", cxxopts::value<std::string>())
@@ -33,11 +37,17 @@ cxxopts::Options setup_options(char* argv, std::vector<std::string>& main_option
 		("dump_dag_dot", "Dumps the task-creation and data-dependency DAG as a .dot for visualization. Argument is the output file. Requires 'tracefile', 'benchmark'.", cxxopts::value<std::string>());
 
 	options.add_options("Parameter")
-		("strategies", "Comma-separated list of strategies from {'random','ctc','lgl','bc','hem'}.",cxxopts::value<std::string>())
+		("strategies", "Comma-separated list of strategies from {'random','ctc','lgl','bc','auction','hem'}.",cxxopts::value<std::string>())
 		("repeat_indexes", "Comma-separated list of sequence repeat indexes to operate on, or 'all'. Defaults to all repeat indexes.",cxxopts::value<std::string>()->default_value("all"))
-		("minimal", "Use minimal execution profiles (default is non-minimal). Strategies 'bc' and 'hem' cannot use minimal.", cxxopts::value<bool>()->default_value("false"))
+		("minimal", "Use minimal execution profiles (default is non-minimal). Strategies 'bc', 'auction' and 'hem' cannot use minimal.", cxxopts::value<bool>()->default_value("false"))
+		("stream_combination", "When executing the sequence, combine each part via 'strategies' as soon as it completes, rather than keeping all parts for a later combination. Default is false.", cxxopts::value<bool>()->default_value("false"))
+		("bc_tree_combination", "Combine the parts of the 'bc' strategy pairwise as a tree wherever their overlapping events allow, rather than chaining them left to right. Changes which instances are matched. Default is false.", cxxopts::value<bool>()->default_value("false"))
 		("filter_events", "Main options only load and dump data for the events defined in the target JSON (i.e. exclude non HPM events). Default is false.", cxxopts::value<bool>()->default_value("false"))
-		("accuracy_metric", "Accuracy metric to use for analysis, out of {'epd', 'spearmans'}. Default is 'epd'.", cxxopts::value<std::string>()->default_value("epd"))
+		("accuracy_metric", "Comma-separated list of accuracy metrics to use for analysis, out of {'epd', 'spearmans', 'marginal_w1'}. 'marginal_w1' is much cheaper than 'epd', comparing each event's 1-D distribution. Multiple metrics are analysed in a single pass over the combined profiles. Default is 'epd'.", cxxopts::value<std::string>()->default_value("epd"))
+		("tmd_solver", "Solver for TMDs during calibration and analysis, out of {'transport', 'fast_emd', 'sinkhorn'}. 'sinkhorn' is approximate. Default is 'transport'.", cxxopts::value<std::string>()->default_value("transport"))
+		("adaptive_calibration", "When running calibration, sample combinations of reference repeats until each calibration TMD has converged, rather than using every combination. Default is false.", cxxopts::value<bool>()->default_value("false"))
+		("calibration_tolerance", "Half-width of the 95% confidence interval of each calibration TMD's median, relative to the median, at which adaptive calibration stops sampling. Default is 0.05.", cxxopts::value<double>()->default_value("0.05"))
+		("bootstrap", "Number of bootstrap replicates for a 95% confidence interval of each EPD when analysing accuracy. Default is 0 (no interval).", cxxopts::value<unsigned int>()->default_value("0"))
 		("tracefile", "Argument is the tracefile to load for utility options.", cxxopts::value<std::string>())
 		("benchmark", "Argument is the benchmark to use when loading tracefile for utility options.", cxxopts::value<std::string>());
 
@@ -133,17 +143,23 @@ std::vector<Fuse::Strategy> parse_strategies_option(
 	return strategies;
 }
 
-Fuse::Accuracy_metric parse_accuracy_metric_option(
+std::vector<Fuse::Accuracy_metric> parse_accuracy_metrics_option(
 		const cxxopts::ParseResult& options_parse_result
 		){
 
 	if(options_parse_result.count("accuracy_metric") == false)
 		throw std::invalid_argument("To analyse accuracy of Fuse combinations, the 'accuracy_metric' option must be provided.");
 
-	auto metric_str = options_parse_result["accuracy_metric"].as<std::string>();
+	auto metrics_str = options_parse_result["accuracy_metric"].as<std::string>();
 
-	return Fuse::convert_string_to_metric(metric_str);
+	std::vector<Fuse::Accuracy_metric> metrics;
 
+	for(auto metric_str : Fuse::Util::split_string_to_vector(metrics_str, ',')){
+		auto metric = Fuse::convert_string_to_metric(metric_str);
+		metrics.push_back(metric);
+	}
+
+	return metrics;
 }
 
 std::vector<unsigned int> parse_repeat_indexes_option(
@@ -224,6 +240,12 @@ void run_main_options(const cxxopts::ParseResult& options_parse_result){
 
 	bool minimal = options_parse_result["minimal"].as<bool>();
 
+	Fuse::Config::tmd_solver = Fuse::convert_string_to_tmd_solver(options_parse_result["tmd_solver"].as<std::string>());
+	Fuse::Config::epd_bootstrap_replicates = options_parse_result["bootstrap"].as<unsigned int>();
+	Fuse::Config::bc_tree_combination = options_parse_result["bc_tree_combination"].as<bool>();
+	Fuse::Config::adaptive_calibration = options_parse_result["adaptive_calibration"].as<bool>();
+	Fuse::Config::calibration_tolerance = options_parse_result["calibration_tolerance"].as<double>();
+
 	bool filter_to_events = options_parse_result["filter_events"].as<bool>();
 	if(filter_to_events){
 		fuse_target.set_filtered_events(fuse_target.get_target_events());
@@ -241,7 +263,10 @@ void run_main_options(const cxxopts::ParseResult& options_parse_result){
 
 	if(options_parse_result.count("execute_sequence")){
 		unsigned int number_of_executions = options_parse_result["execute_sequence"].as<unsigned int>();
-		Fuse::execute_sequence_repeats(fuse_target, number_of_executions, minimal);
+		std::vector<Fuse::Strategy> streaming_strategies;
+		if(options_parse_result["stream_combination"].as<bool>())
+			streaming_strategies = parse_strategies_option(options_parse_result, minimal);
+		Fuse::execute_sequence_repeats(fuse_target, number_of_executions, minimal, true, streaming_strategies);
 	}
 
 	if(options_parse_result.count("execute_hem")){
@@ -255,15 +280,29 @@ void run_main_options(const cxxopts::ParseResult& options_parse_result){
 		Fuse::combine_sequence_repeats(fuse_target, strategies, repeat_indexes, minimal);
 	}
 
+	if(options_parse_result.count("benchmark_strategies")){
+		auto strategies = parse_strategies_option(options_parse_result, minimal);
+		auto repeat_indexes = parse_repeat_indexes_option(options_parse_result, fuse_target, minimal, strategies);
+		Fuse::benchmark_combination_strategies(fuse_target, strategies, repeat_indexes, minimal);
+	}
+
+	if(options_parse_result.count("build_reference_pyramids")){
+		Fuse::build_reference_pyramids(fuse_target);
+	}
+
 	if(options_parse_result.count("run_calibration")){
 		Fuse::calculate_calibration_tmds(fuse_target);
 	}
 
+	if(options_parse_result.count("evaluate_tmd_solver")){
+		Fuse::evaluate_tmd_solver_error(fuse_target, Fuse::Config::tmd_solver);
+	}
+
 	if(options_parse_result.count("analyse_accuracy")){
 		auto strategies = parse_strategies_option(options_parse_result, minimal);
 		auto repeat_indexes = parse_repeat_indexes_option(options_parse_result, fuse_target, minimal, strategies);
-		Fuse::Accuracy_metric metric = parse_accuracy_metric_option(options_parse_result);
-		Fuse::analyse_sequence_combinations(fuse_target, strategies, repeat_indexes, metric);
+		auto metrics = parse_accuracy_metrics_option(options_parse_result);
+		Fuse::analyse_sequence_combinations(fuse_target, strategies, repeat_indexes, metrics);
 	}
 
 }
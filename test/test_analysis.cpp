@@ -0,0 +1,158 @@
+#include "analysis.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+TEST(Analysis, RanksOfDistinctValues){
+
+	std::vector<int64_t> values = {30, 10, 20, 40};
+	std::vector<double> expected = {3.0, 1.0, 2.0, 4.0};
+
+	EXPECT_EQ(Fuse::Analysis::calculate_ranks(values), expected);
+
+}
+
+TEST(Analysis, RanksAverageTiedValues){
+
+	std::vector<int64_t> values = {3, 1, 3, 2, 5, 5, 5};
+	std::vector<double> expected = {3.5, 1.0, 3.5, 2.0, 6.0, 6.0, 6.0};
+
+	EXPECT_EQ(Fuse::Analysis::calculate_ranks(values), expected);
+
+	std::vector<int64_t> constant_values = {7, 7, 7};
+	std::vector<double> constant_expected = {2.0, 2.0, 2.0};
+
+	EXPECT_EQ(Fuse::Analysis::calculate_ranks(constant_values), constant_expected);
+
+}
+
+TEST(Analysis, SpearmansRankCorrelationOfMonotonicColumns){
+
+	std::vector<std::vector<int64_t> > increasing = {{1, 10}, {2, 20}, {2, 20}, {3, 35}, {4, 100}};
+	std::vector<std::vector<int64_t> > decreasing = {{1, 100}, {2, 35}, {2, 35}, {3, 20}, {4, 10}};
+
+	EXPECT_NEAR(Fuse::Analysis::calculate_spearmans_rank_correlation(increasing), 1.0, 1e-12);
+	EXPECT_NEAR(Fuse::Analysis::calculate_spearmans_rank_correlation(decreasing), -1.0, 1e-12);
+
+}
+
+TEST(Analysis, SpearmansRankCorrelationOfTiedColumns){
+
+	// Ranks are (1, 2.5, 2.5, 4) and (1, 2, 3, 4), so the Pearson correlation of the ranks is 4.5 / sqrt(4.5 * 5)
+	std::vector<std::vector<int64_t> > distribution = {{1, 1}, {2, 2}, {2, 3}, {3, 4}};
+
+	EXPECT_NEAR(Fuse::Analysis::calculate_spearmans_rank_correlation(distribution), 4.5 / std::sqrt(4.5 * 5.0), 1e-12);
+
+}
+
+TEST(Analysis, SpearmansRankCorrelationOfConstantColumnIsZero){
+
+	std::vector<std::vector<int64_t> > distribution = {{5, 1}, {5, 2}, {5, 3}, {5, 4}};
+
+	EXPECT_EQ(Fuse::Analysis::calculate_spearmans_rank_correlation(distribution), 0.0);
+
+}
+
+/* The normalised mutual information as calculated before the native kernel
+*  Each column was quantised to floor(1000 * (value - min) / (max - min)), and the entropies were of those quantised values
+*/
+double calculate_reference_normalised_mutual_information(
+		const std::vector<std::vector<int64_t> >& distribution
+		){
+
+	std::vector<unsigned int> quantised_one;
+	std::vector<unsigned int> quantised_two;
+
+	for(unsigned int dim_idx = 0; dim_idx < 2; dim_idx++){
+
+		int64_t min_value = distribution.front().at(dim_idx);
+		int64_t max_value = distribution.front().at(dim_idx);
+		for(auto& instance_values : distribution){
+			min_value = std::min(min_value, instance_values.at(dim_idx));
+			max_value = std::max(max_value, instance_values.at(dim_idx));
+		}
+
+		auto& quantised = (dim_idx == 0) ? quantised_one : quantised_two;
+		for(auto& instance_values : distribution)
+			quantised.push_back(static_cast<unsigned int>(
+				(static_cast<double>(instance_values.at(dim_idx) - min_value) / (max_value - min_value)) * 1000));
+
+	}
+
+	std::map<unsigned int, unsigned int> counts_one;
+	std::map<unsigned int, unsigned int> counts_two;
+	std::map<std::pair<unsigned int, unsigned int>, unsigned int> joint_counts;
+	for(size_t instance_idx = 0; instance_idx < distribution.size(); instance_idx++){
+		counts_one[quantised_one[instance_idx]]++;
+		counts_two[quantised_two[instance_idx]]++;
+		joint_counts[std::make_pair(quantised_one[instance_idx], quantised_two[instance_idx])]++;
+	}
+
+	double num_instances = distribution.size();
+	double entropy_one = 0.0;
+	double entropy_two = 0.0;
+	double joint_entropy = 0.0;
+	for(auto& count : counts_one)
+		entropy_one -= (count.second / num_instances) * std::log(count.second / num_instances);
+	for(auto& count : counts_two)
+		entropy_two -= (count.second / num_instances) * std::log(count.second / num_instances);
+	for(auto& count : joint_counts)
+		joint_entropy -= (count.second / num_instances) * std::log(count.second / num_instances);
+
+	return (entropy_one + entropy_two - joint_entropy) / std::sqrt(entropy_one * entropy_two);
+
+}
+
+TEST(Analysis, MutualInformationOfConstantColumnIsZero){
+
+	std::vector<std::vector<int64_t> > distribution;
+	for(int64_t value = 0; value < 100; value++)
+		distribution.push_back({42, value * value});
+
+	EXPECT_EQ(Fuse::Analysis::calculate_normalised_mutual_information(distribution), 0.0);
+
+}
+
+TEST(Analysis, MutualInformationOfIdenticalColumnsIsOne){
+
+	std::mt19937_64 random_engine(5);
+	std::uniform_int_distribution<int64_t> value_distribution(0, 1000000);
+
+	std::vector<std::vector<int64_t> > distribution;
+	for(unsigned int instance_idx = 0; instance_idx < 5000; instance_idx++){
+		auto value = value_distribution(random_engine);
+		distribution.push_back({value, value});
+	}
+
+	EXPECT_NEAR(Fuse::Analysis::calculate_normalised_mutual_information(distribution), 1.0, 1e-12);
+
+}
+
+TEST(Analysis, MutualInformationMatchesPreviousQuantisation){
+
+	std::mt19937_64 random_engine(6);
+	std::normal_distribution<double> value_distribution(0.0, 1.0);
+
+	// From independent to strongly dependent columns
+	// Only the maximum value's bin differs (the previous quantisation gave it its own), so the results are very close
+	for(double dependence : {0.0, 0.5, 0.9, 0.99}){
+
+		std::vector<std::vector<int64_t> > distribution;
+		for(unsigned int instance_idx = 0; instance_idx < 20000; instance_idx++){
+			double value_one = value_distribution(random_engine);
+			double value_two = dependence * value_one + std::sqrt(1.0 - dependence * dependence) * value_distribution(random_engine);
+			distribution.push_back({static_cast<int64_t>(1e6 * value_one), static_cast<int64_t>(1e6 * value_two)});
+		}
+
+		EXPECT_NEAR(Fuse::Analysis::calculate_normalised_mutual_information(distribution),
+			calculate_reference_normalised_mutual_information(distribution), 1e-6) << "Dependence " << dependence;
+
+	}
+
+}
@@ -0,0 +1,194 @@
+#include "analysis.h"
+
+#include "gtest/gtest.h"
+
+#include <random>
+#include <utility>
+#include <vector>
+
+/* Values spread below, within and above the bounds of each dimension
+*  Every tenth instance takes the lower bound, the upper bound, or a bin boundary, in each dimension
+*/
+std::vector<std::vector<int64_t> > generate_random_distribution(
+		std::mt19937_64& random_engine,
+		unsigned int num_instances,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds_per_dimension,
+		unsigned int num_bins_per_dimension
+		){
+
+	std::vector<std::vector<int64_t> > distribution;
+	std::uniform_int_distribution<unsigned int> special_distribution(0, 29);
+
+	for(unsigned int instance_idx = 0; instance_idx < num_instances; instance_idx++){
+
+		std::vector<int64_t> instance_values;
+		for(auto bounds : bounds_per_dimension){
+
+			int64_t range = bounds.second - bounds.first;
+			std::uniform_int_distribution<int64_t> value_distribution(bounds.first - range / 4 - 1, bounds.second + range / 4 + 1);
+			std::uniform_int_distribution<unsigned int> boundary_distribution(0, num_bins_per_dimension);
+
+			switch(special_distribution(random_engine)){
+				case 0: instance_values.push_back(bounds.first); break;
+				case 1: instance_values.push_back(bounds.second); break;
+				case 2: instance_values.push_back(bounds.first + (range * boundary_distribution(random_engine)) / num_bins_per_dimension); break;
+				default: instance_values.push_back(value_distribution(random_engine));
+			}
+
+		}
+
+		distribution.push_back(instance_values);
+
+	}
+
+	return distribution;
+
+}
+
+void expect_equal_histograms(
+		const Fuse::Analysis::Tmd_histogram& histogram,
+		const Fuse::Analysis::Tmd_histogram& reference_histogram,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds_per_dimension
+		){
+
+	EXPECT_EQ(histogram.num_bins_per_dimension, reference_histogram.num_bins_per_dimension);
+	EXPECT_EQ(histogram.coords, reference_histogram.coords);
+	EXPECT_EQ(histogram.counts, reference_histogram.counts);
+	EXPECT_EQ(histogram.sums, reference_histogram.sums);
+
+	auto signature = Fuse::Analysis::construct_tmd_signature_from_histogram(histogram, bounds_per_dimension);
+	auto reference_signature = Fuse::Analysis::construct_tmd_signature_from_histogram(reference_histogram, bounds_per_dimension);
+
+	// Bit-identical, rather than approximately equal
+	EXPECT_EQ(signature.coords, reference_signature.coords);
+	EXPECT_EQ(signature.weights, reference_signature.weights);
+
+}
+
+TEST(Binning, KernelsMatchCoordinateBinning){
+
+	std::mt19937_64 random_engine(8);
+
+	std::vector<std::pair<int64_t,int64_t> > bounds_list = {{0, 1000}, {-537, 911}, {3, 4}, {1000000007, 1000000007 + 997}};
+
+	auto kernels = Fuse::Analysis::get_supported_bin_coords_kernels();
+
+	for(auto bounds : bounds_list){
+		for(unsigned int num_bins_per_dimension : {1u, 7u, 10u, 64u}){
+
+			double bin_size = (static_cast<double>(bounds.second) - static_cast<double>(bounds.first)) / num_bins_per_dimension;
+
+			// Lengths that are not multiples of the vector widths exercise the scalar remainders
+			for(unsigned int num_values : {1u, 3u, 8u, 13u, 37u, 200u}){
+
+				auto distribution = generate_random_distribution(random_engine, num_values, {bounds}, num_bins_per_dimension);
+
+				std::vector<int64_t> values;
+				std::vector<double> offsets;
+				std::vector<int32_t> expected_coords;
+				for(auto& instance_values : distribution){
+
+					values.push_back(instance_values.front());
+					offsets.push_back(static_cast<double>(instance_values.front() - bounds.first));
+
+					auto instance_histogram = Fuse::Analysis::construct_tmd_histogram_by_coordinates(
+						{instance_values}, {bounds}, num_bins_per_dimension);
+					expected_coords.push_back(instance_histogram.coords.front());
+
+				}
+
+				for(decltype(kernels.size()) kernel_idx = 0; kernel_idx < kernels.size(); kernel_idx++){
+
+					std::vector<int32_t> coords(num_values);
+					kernels[kernel_idx](values.data(), offsets.data(), num_values, bin_size, bounds.second,
+						static_cast<int>(num_bins_per_dimension), coords.data());
+
+					EXPECT_EQ(coords, expected_coords) << "Kernel " << kernel_idx << " of " << kernels.size() << " with bounds ["
+						<< bounds.first << "," << bounds.second << "], " << num_bins_per_dimension << " bins and " << num_values << " values";
+
+				}
+
+			}
+
+		}
+	}
+
+}
+
+TEST(Binning, DenseGridMatchesCoordinateBinning){
+
+	std::mt19937_64 random_engine(9);
+
+	// 12x12 cells for 10 bins per dimension, including the external bins, so the cells are held in a dense array
+	std::vector<std::pair<int64_t,int64_t> > bounds_per_dimension = {{0, 1000}, {-537, 911}};
+
+	for(unsigned int num_instances : {1u, 50u, 5000u}){
+
+		auto distribution = generate_random_distribution(random_engine, num_instances, bounds_per_dimension, 10);
+
+		expect_equal_histograms(
+			Fuse::Analysis::construct_tmd_histogram(distribution, bounds_per_dimension, 10),
+			Fuse::Analysis::construct_tmd_histogram_by_coordinates(distribution, bounds_per_dimension, 10),
+			bounds_per_dimension);
+
+	}
+
+}
+
+TEST(Binning, HashGridMatchesCoordinateBinning){
+
+	std::mt19937_64 random_engine(10);
+
+	// 202^3 cells is far more than the instances, so only the populated cells are kept in a hash grid
+	// The constant dimension puts all instances in the same bin of that dimension
+	std::vector<std::pair<int64_t,int64_t> > bounds_per_dimension = {{0, 100000}, {-53, 9110}, {42, 42}};
+
+	for(unsigned int num_instances : {1u, 50u, 5000u}){
+
+		auto distribution = generate_random_distribution(random_engine, num_instances, bounds_per_dimension, 200);
+
+		expect_equal_histograms(
+			Fuse::Analysis::construct_tmd_histogram(distribution, bounds_per_dimension, 200),
+			Fuse::Analysis::construct_tmd_histogram_by_coordinates(distribution, bounds_per_dimension, 200),
+			bounds_per_dimension);
+
+	}
+
+}
+
+TEST(Binning, GenericDimensionsMatchCoordinateBinning){
+
+	std::mt19937_64 random_engine(11);
+
+	// Beyond the specialised dimensions, with a dense grid (4 bins) and a hash grid (100 bins)
+	std::vector<std::pair<int64_t,int64_t> > bounds_per_dimension = {{0, 1000}, {-537, 911}, {3, 4}, {10, 20000}, {-5, 5}};
+
+	for(unsigned int num_bins_per_dimension : {4u, 100u}){
+
+		auto distribution = generate_random_distribution(random_engine, 2000, bounds_per_dimension, num_bins_per_dimension);
+
+		expect_equal_histograms(
+			Fuse::Analysis::construct_tmd_histogram(distribution, bounds_per_dimension, num_bins_per_dimension),
+			Fuse::Analysis::construct_tmd_histogram_by_coordinates(distribution, bounds_per_dimension, num_bins_per_dimension),
+			bounds_per_dimension);
+
+	}
+
+}
+
+TEST(Binning, TooManyBinsToKeyFallsBackToCoordinateBinning){
+
+	std::mt19937_64 random_engine(12);
+
+	// (2^20 + 2)^4 cells do not fit in a 64-bit key
+	std::vector<std::pair<int64_t,int64_t> > bounds_per_dimension = {{0, 1 << 22}, {-537, 911}, {3, 4}, {10, 1 << 24}};
+	unsigned int num_bins_per_dimension = 1u << 20;
+
+	auto distribution = generate_random_distribution(random_engine, 2000, bounds_per_dimension, num_bins_per_dimension);
+
+	expect_equal_histograms(
+		Fuse::Analysis::construct_tmd_histogram(distribution, bounds_per_dimension, num_bins_per_dimension),
+		Fuse::Analysis::construct_tmd_histogram_by_coordinates(distribution, bounds_per_dimension, num_bins_per_dimension),
+		bounds_per_dimension);
+
+}
@@ -0,0 +1,312 @@
+#include "combination.h"
+#include "instance.h"
+#include "statistics.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+typedef std::pair<std::vector<int>, std::vector<int> > Matched_labels;
+
+/* Instances of a single symbol with distinct labels, and linking event values drawn from few distinct values so many coincide
+*  The value offset separates the values of different profiles, as any value shared across profiles means BC starts at granularity 1
+*/
+std::vector<Fuse::Instance_p> generate_random_instances(
+		std::mt19937_64& random_engine,
+		unsigned int num_instances,
+		Fuse::Event_set events,
+		int label_root,
+		unsigned int num_distinct_values,
+		int64_t value_offset
+		){
+
+	std::uniform_int_distribution<int64_t> value_distribution(0, num_distinct_values - 1);
+
+	std::vector<Fuse::Instance_p> instances;
+	for(unsigned int instance_idx = 0; instance_idx < num_instances; instance_idx++){
+
+		Fuse::Instance_p instance(new Fuse::Instance());
+		instance->symbol = "task";
+		instance->label = {label_root, static_cast<int>(instance_idx)};
+
+		for(auto event : events)
+			instance->append_event_value(event, 1000 + 74 * value_distribution(random_engine) + value_offset, false);
+
+		instances.push_back(instance);
+
+	}
+
+	// Shuffle so that the input order is not the label order
+	std::shuffle(instances.begin(), instances.end(), random_engine);
+
+	return instances;
+
+}
+
+std::vector<int64_t> get_linking_values(
+		Fuse::Instance_p instance,
+		const Fuse::Event_set& events
+		){
+
+	std::vector<int64_t> values;
+	bool error = false;
+	for(auto event : events)
+		values.push_back(instance->get_event_value(event, error));
+
+	return values;
+
+}
+
+std::vector<unsigned int> get_reference_cluster(
+		Fuse::Instance_p instance,
+		const Fuse::Event_set& events,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds,
+		unsigned int granularity
+		){
+
+	if(granularity == 1)
+		return {0};
+
+	std::vector<unsigned int> cluster;
+	auto values = get_linking_values(instance, events);
+	for(unsigned int event_idx = 0; event_idx < events.size(); event_idx++){
+
+		int64_t minimum = bounds.at(event_idx).first;
+		int64_t maximum = bounds.at(event_idx).second;
+
+		if(minimum == maximum){
+			cluster.push_back(0);
+			continue;
+		}
+
+		unsigned int dim_coord = (((double) (values.at(event_idx) - minimum) / (maximum - minimum))) * granularity;
+		if(values.at(event_idx) == maximum && dim_coord > 0)
+			dim_coord--;
+
+		cluster.push_back(dim_coord);
+
+	}
+
+	return cluster;
+
+}
+
+/* The BC matching as calculated before the incremental refinement grid
+*  Every granularity reclusters the remaining instances, matches each shared cluster in label order, then finds the
+*  minimum bin distance between the remaining instances of the closest pairs of clusters, by brute force
+*/
+std::vector<std::pair<Matched_labels, unsigned int> > calculate_reference_bc_matches(
+		std::vector<Fuse::Instance_p> instances_a,
+		std::vector<Fuse::Instance_p> instances_b,
+		const Fuse::Event_set& events,
+		const std::vector<std::pair<int64_t,int64_t> >& bounds,
+		unsigned int& final_granularity
+		){
+
+	std::vector<std::pair<Matched_labels, unsigned int> > matches;
+
+	unsigned int g = Fuse::Combination::bc_find_maximum_granularity(instances_a, instances_b, events, bounds);
+	while(true){
+
+		final_granularity = g;
+
+		std::map<std::vector<unsigned int>, std::vector<Fuse::Instance_p> > clusters_a, clusters_b;
+		for(auto instance : instances_a)
+			clusters_a[get_reference_cluster(instance, events, bounds, g)].push_back(instance);
+		for(auto instance : instances_b)
+			clusters_b[get_reference_cluster(instance, events, bounds, g)].push_back(instance);
+
+		std::vector<Fuse::Instance_p> remaining_a, remaining_b;
+		for(auto& cluster_a : clusters_a){
+
+			auto cluster_b_iter = clusters_b.find(cluster_a.first);
+			if(cluster_b_iter == clusters_b.end())
+				continue;
+
+			auto& members_a = cluster_a.second;
+			auto& members_b = cluster_b_iter->second;
+			std::sort(members_a.begin(), members_a.end(), Fuse::comp_instances_by_label_dfs);
+			std::sort(members_b.begin(), members_b.end(), Fuse::comp_instances_by_label_dfs);
+
+			auto num_to_match = std::min(members_a.size(), members_b.size());
+			for(size_t member_idx = 0; member_idx < num_to_match; member_idx++)
+				matches.push_back(std::make_pair(std::make_pair(members_a[member_idx]->label, members_b[member_idx]->label), g));
+
+			members_a.erase(members_a.begin(), members_a.begin() + num_to_match);
+			members_b.erase(members_b.begin(), members_b.begin() + num_to_match);
+
+		}
+
+		for(auto& cluster_a : clusters_a)
+			remaining_a.insert(remaining_a.end(), cluster_a.second.begin(), cluster_a.second.end());
+		for(auto& cluster_b : clusters_b)
+			remaining_b.insert(remaining_b.end(), cluster_b.second.begin(), cluster_b.second.end());
+
+		instances_a = remaining_a;
+		instances_b = remaining_b;
+
+		if(instances_a.size() == 0 || instances_b.size() == 0)
+			break;
+
+		// Closest pairs of clusters that both still have instances
+		double minimum_squared_distance = std::numeric_limits<double>::max();
+		std::vector<std::pair<std::vector<unsigned int>, std::vector<unsigned int> > > closest_clusters;
+		for(auto& cluster_a : clusters_a){
+			for(auto& cluster_b : clusters_b){
+
+				if(cluster_a.second.empty() || cluster_b.second.empty())
+					continue;
+
+				double squared_distance = 0.0;
+				for(size_t k = 0; k < cluster_a.first.size(); k++)
+					squared_distance += std::pow(((double) cluster_a.first.at(k)) - ((double) cluster_b.first.at(k)), 2);
+
+				if(squared_distance > minimum_squared_distance)
+					continue;
+
+				if(squared_distance < minimum_squared_distance){
+					minimum_squared_distance = squared_distance;
+					closest_clusters.clear();
+				}
+
+				closest_clusters.push_back(std::make_pair(cluster_a.first, cluster_b.first));
+
+			}
+		}
+
+		double minimum_euclidean_squared_distance = std::numeric_limits<double>::max();
+		double minimum_bin_distance = 0.0;
+		for(auto& cluster_pair : closest_clusters){
+			for(auto instance_a : clusters_a.at(cluster_pair.first)){
+				for(auto instance_b : clusters_b.at(cluster_pair.second)){
+
+					auto values_a = get_linking_values(instance_a, events);
+					auto values_b = get_linking_values(instance_b, events);
+
+					double squared_bin_distance = 0.0;
+					double largest_bin_distance = 0.0;
+					for(size_t k = 0; k < events.size(); k++){
+
+						uint64_t difference = std::abs(((double) values_a.at(k)) - ((double) values_b.at(k)));
+						double bin_distance = ((double) difference) / (((double) (bounds.at(k).second - bounds.at(k).first)) / g);
+
+						largest_bin_distance = std::max(largest_bin_distance, bin_distance);
+						squared_bin_distance += std::pow(bin_distance, 2);
+
+					}
+
+					if(squared_bin_distance == minimum_euclidean_squared_distance){
+						minimum_bin_distance = std::min(minimum_bin_distance, largest_bin_distance);
+					} else if(squared_bin_distance < minimum_euclidean_squared_distance){
+						minimum_euclidean_squared_distance = squared_bin_distance;
+						minimum_bin_distance = largest_bin_distance;
+					}
+
+				}
+			}
+		}
+
+		g = Fuse::Combination::bc_relax_granularity(g, minimum_bin_distance);
+
+	}
+
+	return matches;
+
+}
+
+void expect_bc_matches_reference(
+		std::mt19937_64& random_engine,
+		Fuse::Event_set events,
+		unsigned int num_instances_a,
+		unsigned int num_instances_b,
+		unsigned int num_distinct_values,
+		int64_t value_offset
+		){
+
+	auto instances_a = generate_random_instances(random_engine, num_instances_a, events, 0, num_distinct_values, 0);
+	auto instances_b = generate_random_instances(random_engine, num_instances_b, events, 1, num_distinct_values, value_offset);
+
+	Fuse::Statistics_p statistics(new Fuse::Statistics("statistics.csv"));
+	for(auto instances : {instances_a, instances_b}){
+		for(auto instance : instances){
+			bool error = false;
+			for(auto event : events)
+				statistics->add_event_value(event, instance->get_event_value(event, error), instance->symbol);
+		}
+	}
+	statistics->calculate_statistics_from_running();
+
+	std::vector<std::pair<int64_t,int64_t> > bounds;
+	for(auto event : events)
+		bounds.push_back(statistics->get_bounds(event, "task"));
+
+	unsigned int reference_final_granularity = 0;
+	auto reference_matches = calculate_reference_bc_matches(instances_a, instances_b, events, bounds, reference_final_granularity);
+
+	std::vector<std::vector<Fuse::Instance_p> > instances_per_profile = {instances_a, instances_b};
+	std::vector<unsigned int> match_granularities;
+	auto matched_instances = Fuse::Combination::extract_matched_instances_bc(instances_per_profile, true, statistics,
+		events, &match_granularities);
+
+	ASSERT_EQ(matched_instances.size(), match_granularities.size());
+
+	std::vector<std::pair<Matched_labels, unsigned int> > matches;
+	for(size_t match_idx = 0; match_idx < matched_instances.size(); match_idx++)
+		matches.push_back(std::make_pair(std::make_pair(matched_instances[match_idx].at(0)->label,
+			matched_instances[match_idx].at(1)->label), match_granularities[match_idx]));
+
+	// The cells are visited in a different order, so only the set of matches and their granularities must agree
+	std::sort(matches.begin(), matches.end());
+	std::sort(reference_matches.begin(), reference_matches.end());
+
+	ASSERT_EQ(matches, reference_matches);
+	ASSERT_EQ(*std::min_element(match_granularities.begin(), match_granularities.end()), reference_final_granularity);
+
+	// Every instance of the smaller profile is matched, and the unmatched instances remain
+	auto num_matched = std::min(num_instances_a, num_instances_b);
+	EXPECT_EQ(matched_instances.size(), num_matched);
+	EXPECT_EQ(instances_per_profile.at(0).size(), num_instances_a - num_matched);
+	EXPECT_EQ(instances_per_profile.at(1).size(), num_instances_b - num_matched);
+
+}
+
+TEST(Combination, BcMatchesPreviousReclustering){
+
+	std::mt19937_64 random_engine(7);
+
+	std::vector<Fuse::Event_set> event_sets = {
+		{"PAPI_TOT_INS"},
+		{"PAPI_TOT_INS", "PAPI_L1_DCM"},
+		{"PAPI_TOT_INS", "PAPI_L1_DCM", "PAPI_L2_DCM"}
+	};
+
+	// Unequal instance counts in both directions
+	std::vector<std::pair<unsigned int, unsigned int> > instance_counts = {{40, 40}, {57, 31}, {12, 90}, {1, 25}};
+
+	for(auto events : event_sets){
+		for(auto num_instances : instance_counts){
+			for(unsigned int num_distinct_values : {3, 20, 400}){
+
+				// Shared values across the profiles, then separated values that require refining the granularity
+				for(int64_t value_offset : {0, 1, 29}){
+
+					SCOPED_TRACE(::testing::Message() << events.size() << " events, " << num_instances.first << " and "
+						<< num_instances.second << " instances, " << num_distinct_values << " distinct values, offset " << value_offset);
+
+					expect_bc_matches_reference(random_engine, events, num_instances.first, num_instances.second,
+						num_distinct_values, value_offset);
+
+				}
+
+			}
+		}
+	}
+
+}
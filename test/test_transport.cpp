@@ -0,0 +1,148 @@
+#include "analysis.h"
+#include "transport.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Random coordinates and unit-mass weights for up to max_points points
+Fuse::Analysis::Tmd_signature generate_random_signature(
+		std::mt19937_64& random_engine,
+		unsigned int num_dimensions,
+		unsigned int max_points
+		){
+
+	std::uniform_int_distribution<unsigned int> num_points_distribution(1, max_points);
+	std::uniform_real_distribution<double> coord_distribution(-1.0, 11.0);
+	std::uniform_real_distribution<double> weight_distribution(0.01, 1.0);
+
+	Fuse::Analysis::Tmd_signature signature;
+	signature.num_dimensions = num_dimensions;
+
+	unsigned int num_points = num_points_distribution(random_engine);
+	signature.num_instances = num_points;
+
+	for(unsigned int point_idx = 0; point_idx < num_points * num_dimensions; point_idx++)
+		signature.coords.push_back(coord_distribution(random_engine));
+
+	double total_weight = 0.0;
+	for(unsigned int point_idx = 0; point_idx < num_points; point_idx++){
+		signature.weights.push_back(weight_distribution(random_engine));
+		total_weight += signature.weights.back();
+	}
+
+	for(auto& weight : signature.weights)
+		weight /= total_weight;
+
+	return signature;
+
+}
+
+// The exact 1-D Wasserstein distance, as the area between the two (weighted) step CDFs
+double calculate_reference_1d_wasserstein(
+		const Fuse::Analysis::Tmd_signature& signature_one,
+		const Fuse::Analysis::Tmd_signature& signature_two
+		){
+
+	std::vector<std::pair<double, double> > points;
+	for(size_t point_idx = 0; point_idx < signature_one.weights.size(); point_idx++)
+		points.push_back(std::make_pair(signature_one.coords[point_idx], signature_one.weights[point_idx]));
+	for(size_t point_idx = 0; point_idx < signature_two.weights.size(); point_idx++)
+		points.push_back(std::make_pair(signature_two.coords[point_idx], -signature_two.weights[point_idx]));
+
+	std::sort(points.begin(), points.end());
+
+	double distance = 0.0;
+	double cdf_difference = 0.0;
+	for(size_t point_idx = 0; point_idx + 1 < points.size(); point_idx++){
+		cdf_difference += points[point_idx].second;
+		distance += std::fabs(cdf_difference) * (points[point_idx + 1].first - points[point_idx].first);
+	}
+
+	return distance;
+
+}
+
+TEST(Transport, ExactEmdMatchesOneDimensionalWasserstein){
+
+	std::mt19937_64 random_engine(1);
+
+	for(unsigned int trial = 0; trial < 3000; trial++){
+
+		auto signature_one = generate_random_signature(random_engine, 1, 40);
+		auto signature_two = generate_random_signature(random_engine, 1, 40);
+
+		double emd = Fuse::Transport::calculate_emd(1, signature_one.coords, signature_one.weights,
+			signature_two.coords, signature_two.weights);
+
+		ASSERT_NEAR(emd, calculate_reference_1d_wasserstein(signature_one, signature_two), 1e-9) << "Trial " << trial;
+
+	}
+
+}
+
+TEST(Transport, ExactEmdMatchesFastEmd){
+
+	std::mt19937_64 random_engine(2);
+
+	for(unsigned int num_dimensions = 1; num_dimensions <= 3; num_dimensions++){
+		for(unsigned int trial = 0; trial < 200; trial++){
+
+			auto signature_one = generate_random_signature(random_engine, num_dimensions, 60);
+			auto signature_two = generate_random_signature(random_engine, num_dimensions, 60);
+
+			double transport_emd = Fuse::Analysis::calculate_tmd_between_signatures(signature_one, signature_two,
+				Fuse::Tmd_solver::TRANSPORT_SIMPLEX);
+			double fast_emd = Fuse::Analysis::calculate_tmd_between_signatures(signature_one, signature_two,
+				Fuse::Tmd_solver::FAST_EMD);
+
+			// fast_emd rounds the weights and costs to integers at 1e-6 of their maxima, so only agrees to about 1e-4
+			ASSERT_NEAR(transport_emd, fast_emd, 1e-4 * std::max(1.0, fast_emd))
+				<< "Trial " << trial << " with " << num_dimensions << " dimensions";
+
+		}
+	}
+
+}
+
+TEST(Transport, ExactEmdOfIdenticalSignaturesIsZero){
+
+	std::mt19937_64 random_engine(3);
+
+	auto signature = generate_random_signature(random_engine, 2, 50);
+
+	EXPECT_NEAR(Fuse::Transport::calculate_emd(2, signature.coords, signature.weights, signature.coords, signature.weights),
+		0.0, 1e-12);
+
+}
+
+TEST(Transport, LowerBoundDoesNotExceedExactEmd){
+
+	std::mt19937_64 random_engine(4);
+
+	for(unsigned int num_dimensions = 1; num_dimensions <= 4; num_dimensions++){
+		for(unsigned int trial = 0; trial < 500; trial++){
+
+			auto signature_one = generate_random_signature(random_engine, num_dimensions, 40);
+			auto signature_two = generate_random_signature(random_engine, num_dimensions, 40);
+
+			double emd = Fuse::Transport::calculate_emd(num_dimensions, signature_one.coords, signature_one.weights,
+				signature_two.coords, signature_two.weights);
+			double lower_bound = Fuse::Transport::calculate_emd_lower_bound(num_dimensions, signature_one.coords,
+				signature_one.weights, signature_two.coords, signature_two.weights);
+
+			ASSERT_LE(lower_bound, emd + 1e-9) << "Trial " << trial << " with " << num_dimensions << " dimensions";
+
+			// A single dimension is its own marginal, so the bound is exact
+			if(num_dimensions == 1){
+				ASSERT_NEAR(lower_bound, emd, 1e-9) << "Trial " << trial;
+			}
+
+		}
+	}
+
+}